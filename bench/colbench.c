@@ -18,13 +18,18 @@
 #include <smlt_barrier.h>
 #include <smlt_broadcast.h>
 #include <smlt_reduction.h>
+#include <smlt_allreduce.h>
+#include <smlt_alltoall.h>
 #include <numa.h>
 #include <platforms/measurement_framework.h>
 
 #define NUM_RUNS 10000 //50 // 10000 // Tested up to 1.000.000
 #define NUM_RESULTS 1000
 
-#define NUM_EXP 3
+#define NUM_EXP 10
+
+#define ALLREDUCE_WORDS 7
+#define ALLTOALL_BLOCK_WORDS 1
 
 uint32_t num_topos = 7;
 uint32_t num_threads;
@@ -213,6 +218,115 @@ static void* reduction(void* a)
 }
 
 
+static void allreduce_run(smlt_allreduce_algo_t algo, const char *name)
+{
+    char outname[1024];
+    cycles_t *buf = (cycles_t*) malloc(sizeof(cycles_t)*NUM_RESULTS);
+    if (use_bar) {
+        sprintf(outname, "allreduce_%s_smltsync_%d", name, num_threads);
+    } else {
+        sprintf(outname, "allreduce_%s_smlt_%d", name, num_threads);
+    }
+
+    struct smlt_msg* msg = smlt_message_alloc(ALLREDUCE_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    sk_m_init(&m, NUM_RESULTS, outname, buf);
+
+    for (int j = 0; j < NUM_RUNS; j++) {
+
+        if (use_bar) {
+            smlt_dissem_barrier_wait(bar);
+            smlt_dissem_barrier_wait(bar);
+        }
+
+        sk_m_restart_tsc(&m);
+        smlt_allreduce_with_algo(context, msg, msg, SMLT_REDUCE_OP_SUM,
+                                 SMLT_REDUCE_DTYPE_U64, algo);
+        sk_m_add(&m);
+    }
+
+    sk_m_print(&m);
+}
+
+static void* allreduce_tree(void* a)
+{
+    allreduce_run(SMLT_ALLREDUCE_TREE, "tree");
+    return 0;
+}
+
+static void* allreduce_rd(void* a)
+{
+    allreduce_run(SMLT_ALLREDUCE_RECURSIVE_DOUBLING, "rd");
+    return 0;
+}
+
+static void* allreduce_hybrid(void* a)
+{
+    allreduce_run(SMLT_ALLREDUCE_HYBRID, "hybrid");
+    return 0;
+}
+
+static void* allreduce_auto(void* a)
+{
+    allreduce_run(SMLT_ALLREDUCE_AUTO, "auto");
+    return 0;
+}
+
+static void alltoall_run(smlt_alltoall_algo_t algo, const char *name)
+{
+    char outname[1024];
+    cycles_t *buf = (cycles_t*) malloc(sizeof(cycles_t)*NUM_RESULTS);
+    if (use_bar) {
+        sprintf(outname, "alltoall_%s_smltsync_%d", name, num_threads);
+    } else {
+        sprintf(outname, "alltoall_%s_smlt_%d", name, num_threads);
+    }
+
+    uint32_t words = num_threads * ALLTOALL_BLOCK_WORDS;
+    struct smlt_msg* send = smlt_message_alloc(words *
+                                               sizeof(smlt_msg_payload_t));
+    struct smlt_msg* recv = smlt_message_alloc(words *
+                                               sizeof(smlt_msg_payload_t));
+    send->words = words;
+
+    sk_m_init(&m, NUM_RESULTS, outname, buf);
+
+    for (int j = 0; j < NUM_RUNS; j++) {
+
+        if (use_bar) {
+            smlt_dissem_barrier_wait(bar);
+            smlt_dissem_barrier_wait(bar);
+        }
+
+        sk_m_restart_tsc(&m);
+        smlt_alltoall_with_algo(context, send, ALLTOALL_BLOCK_WORDS, recv,
+                                algo);
+        sk_m_add(&m);
+    }
+
+    sk_m_print(&m);
+}
+
+static void* alltoall_direct(void* a)
+{
+    alltoall_run(SMLT_ALLTOALL_DIRECT, "direct");
+    return 0;
+}
+
+static void* alltoall_pairwise(void* a)
+{
+    alltoall_run(SMLT_ALLTOALL_PAIRWISE, "pairwise");
+    return 0;
+}
+
+static void* alltoall_two_phase(void* a)
+{
+    alltoall_run(SMLT_ALLTOALL_TWO_PHASE, "twophase");
+    return 0;
+}
+
+
 int main(int argc, char **argv)
 {
     bool hyper = false;
@@ -261,6 +375,13 @@ int main(int argc, char **argv)
         &broadcast,
         &reduction,
         &barrier,
+        &allreduce_tree,
+        &allreduce_rd,
+        &allreduce_hybrid,
+        &allreduce_auto,
+        &alltoall_direct,
+        &alltoall_pairwise,
+        &alltoall_two_phase,
     };
    
     for (int i = 0; i < NUM_EXP; i++) {      
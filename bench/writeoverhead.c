@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <unistd.h>
 #include <smlt.h>
@@ -41,6 +42,7 @@ struct thr_args {
     coreid_t num_cores;
     size_t num_channels;
     size_t num_msg;
+    bool batch;
 };
 
 static cycles_t *do_sorting(cycles_t *array,
@@ -179,10 +181,19 @@ void* thr_write_one(void* a)
 
     struct smlt_qp *qp = queue_pairs[0][arg->r];
 
+    struct smlt_msg *msgs[arg->num_msg];
+    for (size_t i = 0; i < arg->num_msg; ++i) {
+        msgs[i] = msg;
+    }
+
     for (size_t j=0; j<NUM_EXP; j++) {
         tsc_start = bench_tsc();
-        for (size_t i = 0; i < arg->num_msg; ++i) {
-            smlt_queuepair_send(qp, msg);
+        if (arg->batch) {
+            smlt_queuepair_send_batch(qp, msgs, arg->num_msg);
+        } else {
+            for (size_t i = 0; i < arg->num_msg; ++i) {
+                smlt_queuepair_send(qp, msg);
+            }
         }
         tsc_end = bench_tsc();
         tsc_measurements[j % NUM_DATA] = (tsc_end - tsc_start) / arg->num_msg;
@@ -310,6 +321,7 @@ int main(int argc, char **argv)
     smlt_platform_pin_thread(0);
 
     struct thr_args args[num_cores];
+    memset(args, 0, sizeof(args));
 
     coreid_t num_local_cores = smlt_platform_num_cores_of_cluster(0) / 2;
 
@@ -413,6 +425,94 @@ int main(int argc, char **argv)
     }
 
 
+    printf("=============================================\n");
+
+    glb_label = "WRITEB";
+
+    /* same as WRITES, but the messages are sent as one batch */
+    for (uint32_t c = 0; c < smlt_platform_num_clusters(); ++c) {
+        coreid_t target = num_local_cores * c;
+        if (target == 0) target = 1;
+        struct smlt_node *dst = smlt_get_node_by_id(target);
+        for (uint32_t num_msg = 1; num_msg <= 16; ++num_msg) {
+            args[target].s = 0;
+            args[target].r = target;
+            args[target].num_channels = 1;
+            args[target].num_cores = c;
+            args[target].num_msg = num_msg;
+
+            err = smlt_node_start(dst, thr_receiver_one, args + target);
+            if (smlt_err_is_fail(err)) {
+                printf("Staring node failed \n");
+            }
+
+            args[0].s = 0;
+            args[0].r = target;
+            args[0].num_channels = c;
+            args[0].num_cores = c;
+            args[0].num_msg = num_msg;
+            args[0].batch = true;
+
+            sleep(1);
+            thr_write_one(args);
+
+            args[0].batch = false;
+
+            smlt_node_join(dst);
+        }
+    }
+
+    printf("=============================================\n");
+
+    /* sustained one-directional traffic with the different ACK policies */
+    const char *ack_labels[] = { "WRITEA-half", "WRITEA-every", "WRITEA-n8" };
+    smlt_ump_ack_policy_t ack_policies[] = {
+        SMLT_UMP_ACK_HALF_WINDOW,
+        SMLT_UMP_ACK_EVERY,
+        SMLT_UMP_ACK_EVERY_N
+    };
+
+    for (uint32_t p = 0; p < 3; ++p) {
+        glb_label = ack_labels[p];
+
+        coreid_t target = 1;
+        struct smlt_node *dst = smlt_get_node_by_id(target);
+
+        smlt_ump_queuepair_set_ack_policy(&queue_pairs[0][target]->q.ump,
+                                          ack_policies[p], 8);
+        smlt_ump_queuepair_set_ack_policy(&queue_pairs[1][target]->q.ump,
+                                          ack_policies[p], 8);
+
+        for (uint32_t num_msg = 64; num_msg <= 1024; num_msg *= 4) {
+            args[target].s = 0;
+            args[target].r = target;
+            args[target].num_channels = 1;
+            args[target].num_cores = 1;
+            args[target].num_msg = num_msg;
+
+            err = smlt_node_start(dst, thr_receiver_one, args + target);
+            if (smlt_err_is_fail(err)) {
+                printf("Staring node failed \n");
+            }
+
+            args[0].s = 0;
+            args[0].r = target;
+            args[0].num_channels = 1;
+            args[0].num_cores = 1;
+            args[0].num_msg = num_msg;
+
+            sleep(1);
+            thr_write_one(args);
+
+            smlt_node_join(dst);
+        }
+
+        smlt_ump_queuepair_set_ack_policy(&queue_pairs[0][target]->q.ump,
+                                          SMLT_UMP_ACK_HALF_WINDOW, 0);
+        smlt_ump_queuepair_set_ack_policy(&queue_pairs[1][target]->q.ump,
+                                          SMLT_UMP_ACK_HALF_WINDOW, 0);
+    }
+
     printf("=============================================\n");
 
     glb_label = "WRITEX";
@@ -16,6 +16,7 @@ struct smlt_message;
 
 
 #define SMLT_FFQ_DEFAULT_SLOTS 64
+#define SMLT_FFQ_MAX_SLOTS UINT16_MAX
 
 /**
  * represents an bidirectional FastForward queue
@@ -24,6 +25,7 @@ struct smlt_ffq_queuepair
 {
     struct smlt_ffq_queue tx SMLT_ARCH_ATTR_ALIGN;
     struct smlt_ffq_queue rx SMLT_ARCH_ATTR_ALIGN;
+    struct smlt_ffq_slot stage;     ///< staging slot for in-place sends
 };
 
 
@@ -41,11 +43,14 @@ errval_t smlt_ffq_queuepair_init(smlt_ffq_idx_t num_slots, uint8_t node_src,
                                   struct smlt_ffq_queuepair *dst);
 
 /**
- * @brief destorys a FFQ queuepair
+ * @brief destroys one end of a FFQ queuepair
  *
  * @param qp    the FFQ queuepair
  *
  * @returns SMLT_SUCCESS or error value
+ *
+ * The buffer the end receives on is freed, both ends have to be destroyed
+ * once neither of them is used anymore.
  */
 errval_t smlt_ffq_queuepair_destroy(struct smlt_ffq_queuepair *qp);
 
@@ -124,6 +129,31 @@ static inline bool smlt_ffq_queuepair_can_send_raw(struct smlt_ffq_queuepair *qp
  */
 bool smlt_ffq_queuepair_can_send(struct smlt_qp *qp);
 
+/**
+ * @brief obtains the payload buffer for the next message
+ *
+ * @param qp     The smelt queuepair to send on
+ * @param data   returns the pointer to the payload buffer
+ * @param words  returns the number of payload words in the buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL if there is no free slot
+ *
+ * The first word of a FFQ slot signals a valid message and must be written
+ * last, hence the payload is staged and copied into the slot on commit.
+ */
+errval_t smlt_ffq_queuepair_try_send_prepare(struct smlt_qp *qp,
+                                             smlt_msg_payload_t **data,
+                                             uint32_t *words);
+
+/**
+ * @brief sends the prepared message
+ *
+ * @param qp     The smelt queuepair to send on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ffq_queuepair_send_commit(struct smlt_qp *qp);
+
 
 /*
  * ===========================================================================
@@ -201,4 +231,26 @@ static inline bool smlt_ffq_queuepair_can_recv_raw(struct smlt_ffq_queuepair *qp
     return smlt_ffq_queue_can_recv(&qp->rx);
 }
 
+/**
+ * @brief lends the payload of the next message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS if the slot is lent, SMLT_ERR_QUEUE_EMPTY otherwise
+ */
+errval_t smlt_ffq_queuepair_try_recv_borrow(struct smlt_qp *qp,
+                                            const smlt_msg_payload_t **data,
+                                            uint32_t *words);
+
+/**
+ * @brief releases the lent message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ffq_queuepair_recv_release(struct smlt_qp *qp);
+
 #endif /*SMLT_FFQ_QUEUEPAIR_H_ */
@@ -18,6 +18,9 @@
 #define CACHELINE_SIZE 64
 #define DEFAULT_SHM_SIZE DEFAULT_SHM_Q_SIZE*CACHELINE_SIZE
 
+// Number of payload words in a slot
+#define SHM_QP_PAYLOAD_WORDS 7
+
 union __attribute__((aligned(64))) pos_pointer{
     uint64_t pos;
     uint8_t padding[CACHELINE_SIZE];
@@ -55,6 +58,9 @@ struct shm_qp {
 struct shm_qp* shm_queuepair_create(uint32_t src,
                                     uint32_t dst);
 
+// frees the shared memory of the queue, both contexts refer to it
+void shm_queuepair_destroy(struct shm_qp* qp);
+
 void shm_q_send(struct shm_context* context,
                 uintptr_t p1,
                 uintptr_t p2,
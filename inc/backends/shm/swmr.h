@@ -19,8 +19,27 @@
  */
 
 #define SWMRQ_SIZE 64 // Number of slots in shared memory queue
+#define SWMRQ_MIN_SLOTS 2 // Minimum number of message slots of a queue
+#define SWMRQ_MAX_SLOTS UINT16_MAX // the local position is 16 bits wide
 #define CACHELINE_SIZE 64
 
+/*
+ * Bulk messages
+ *
+ * Messages larger than 7 words are staged into consecutive slots and
+ * published by writing a single header. The header of the first slot
+ * carries the SWMR_SEQ_BULK flag, its payload starts with the number of
+ * words in this chunk and the number of words still to come. Subsequent
+ * slots of the chunk only carry payload and their header is left untouched.
+ */
+#define SWMR_SEQ_BULK (((uint64_t)1) << 63)
+
+// Number of payload words in a slot
+#define SWMR_SLOT_PAYLOAD_WORDS 7
+
+// Number of payload words in the first slot of a bulk chunk
+#define SWMR_BULK_HEAD_WORDS (SWMR_SLOT_PAYLOAD_WORDS - 2)
+
 union __attribute__((aligned(64))) pos_point{
     uint64_t pos;
     uint8_t padding[CACHELINE_SIZE];
@@ -69,6 +88,15 @@ void swmr_queue_create(struct swmr_queue**,
                        uint16_t count,
                        bool sep_header);
 
+errval_t swmr_queue_create_sized(struct swmr_queue**,
+                                 uint32_t src,
+                                 uint32_t* dst,
+                                 uint16_t count,
+                                 bool sep_header,
+                                 uint32_t queue_size);
+
+void swmr_queue_destroy(struct swmr_queue* queue);
+
 void swmr_send_raw(struct swmr_context* context,
                   uintptr_t p1,
                   uintptr_t p2,
@@ -99,4 +127,14 @@ errval_t smlt_swmr_send(struct swmr_queue *qp, struct smlt_msg *msg);
 errval_t smlt_swmr_send0(struct swmr_queue *qp);
 errval_t smlt_swmr_recv(struct swmr_context *context, struct smlt_msg *msg);
 errval_t smlt_swmr_recv0(struct swmr_context *context);
+
+errval_t smlt_swmr_send_prepare(struct swmr_queue *qp,
+                                smlt_msg_payload_t **data,
+                                uint32_t *words);
+errval_t smlt_swmr_send_commit(struct swmr_queue *qp);
+
+errval_t smlt_swmr_recv_borrow(struct swmr_context *context,
+                               const smlt_msg_payload_t **data,
+                               uint32_t *words);
+errval_t smlt_swmr_recv_release(struct swmr_context *context);
 #endif /* SYNC_SHM_H */
@@ -45,6 +45,12 @@ SMLT_STATIC_ASSERT(sizeof(smlt_ump_ctrl_word_t) <= sizeof(smlt_ump_payload_word_
 
 #define SMLT_UMP_DEFAULT_SLOTS (BASE_PAGE_SIZE / SMLT_UMP_MSG_BYTES)
 
+/**
+ * the maximum number of slots of a queue. The sequence numbers are 16 bits
+ * wide, the window must be less than half of their range to compare them.
+ */
+#define SMLT_UMP_MAX_SLOTS (1 << 15)
+
 /**
  * the number of (payload) words a message consists of.
  */
@@ -81,6 +87,22 @@ typedef uint16_t smlt_ump_idx_t;
  */
 #define SMLT_UMP_EPOCH_BITS  1
 
+///< mask for the epoch bit in the epoch field of the control word
+#define SMLT_UMP_EPOCH_MASK  ((1 << SMLT_UMP_EPOCH_BITS) - 1)
+
+/**
+ * flag in the epoch field marking the first slot of a fragmented message.
+ *
+ * The payload of a fragmented message starts with the total number of words
+ * followed by the data, which is continued in the subsequent slots.
+ */
+#define SMLT_UMP_FLAG_FRAG   (1 << SMLT_UMP_EPOCH_BITS)
+
+/**
+ * number of payload words in the first slot of a fragmented message
+ */
+#define SMLT_UMP_FRAG_HEAD_WORDS (SMLT_UMP_PAYLOAD_WORDS - 1)
+
 /**
  * number of bits available to encode the header
  */
@@ -136,6 +158,15 @@ typedef enum {
     SMLT_UMP_DIRECTION_SEND
 } smlt_ump_direction_t;
 
+/**
+ * when the receiver writes the ACK back to the sender
+ */
+typedef enum {
+    SMLT_UMP_ACK_HALF_WINDOW = 0,   ///< in the middle and at the end of the buffer
+    SMLT_UMP_ACK_EVERY,             ///< after every message
+    SMLT_UMP_ACK_EVERY_N,           ///< after every N messages
+} smlt_ump_ack_policy_t;
+
 /**
  * represents an uni-directional UMP channel.
  */
@@ -147,7 +178,9 @@ struct smlt_ump_queue
     smlt_ump_idx_t num_msg;         ///< buffer size in message
     bool epoch;                     ///< next message epoch
     smlt_ump_direction_t direction; ///< direction of the channel
-
+    smlt_ump_ack_policy_t ack_policy; ///< ACK policy of the receiver
+    smlt_ump_idx_t ack_interval;    ///< messages per ACK for ACK_EVERY_N
+    smlt_ump_idx_t ack_pending;     ///< messages received since the last ACK
 };
 
 
@@ -194,6 +227,20 @@ static inline smlt_ump_idx_t smlt_ump_queue_last_ack(struct smlt_ump_queue *q)
     return *q->last_ack;
 }
 
+/**
+ * @brief sets the ACK policy of the UMP receive queue
+ *
+ * @param q         the UMP receive queue
+ * @param policy    the ACK policy
+ * @param interval  number of messages per ACK for SMLT_UMP_ACK_EVERY_N
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the interval is not within the
+ *          size of the buffer
+ */
+errval_t smlt_ump_queue_set_ack_policy(struct smlt_ump_queue *q,
+                                       smlt_ump_ack_policy_t policy,
+                                       smlt_ump_idx_t interval);
+
 /*
  * ===========================================================================
  * Send Functions
@@ -215,6 +262,28 @@ struct smlt_ump_message *smlt_ump_queue_get_next(struct smlt_ump_queue *c)
 }
 
 
+/**
+ * @brief obtains a pointer to the n-th message slot after the current one
+ *
+ * @param c     the UMP channel to get the message slot for
+ * @param n     offset of the slot from the current position
+ *
+ * @return pointer to a message slot
+ */
+static inline volatile
+struct smlt_ump_message *smlt_ump_queue_get_nth(struct smlt_ump_queue *c,
+                                                smlt_ump_idx_t n)
+{
+    SMLT_ASSERT(c->direction == SMLT_UMP_DIRECTION_SEND);
+    SMLT_ASSERT(n < c->num_msg);
+
+    uint32_t idx = (uint32_t)c->pos + n;
+    if (idx >= c->num_msg) {
+        idx -= c->num_msg;
+    }
+    return c->buf + idx;
+}
+
 /**
  * @brief sends a message on the UMP channel
  *
@@ -233,7 +302,7 @@ static inline void smlt_ump_queue_send(struct smlt_ump_queue *c,
     smlt_arch_write_barrier();
 
     // write control word (thus sending the message)
-    ctrl.c.epoch = c->epoch;
+    ctrl.c.epoch = (ctrl.c.epoch & ~SMLT_UMP_EPOCH_MASK) | c->epoch;
     msg->ctrl.raw = ctrl.raw;
 
     // update pos
@@ -245,6 +314,37 @@ static inline void smlt_ump_queue_send(struct smlt_ump_queue *c,
 }
 
 
+/**
+ * @brief sends a batch of already filled message slots on the UMP channel
+ *
+ * @param c     the UMP channel to send on
+ * @param num   the number of slots to send, starting at the current one
+ * @param seq   sequence number of the first message
+ *
+ * The payload of all slots is ordered with a single write barrier before
+ * the control words are written in sequence.
+ */
+static inline void smlt_ump_queue_send_batch(struct smlt_ump_queue *c,
+                                             smlt_ump_idx_t num,
+                                             smlt_ump_idx_t seq)
+{
+    union smlt_ump_ctrl ctrl;
+
+    // write barrier for the payload of all messages
+    smlt_arch_write_barrier();
+
+    for (smlt_ump_idx_t i = 0; i < num; i++) {
+        ctrl.c.epoch = c->epoch;
+        ctrl.c.last_ack = seq + i;
+        c->buf[c->pos].ctrl.raw = ctrl.raw;
+
+        if (++c->pos == c->num_msg) {
+            c->pos = 0;
+            c->epoch = !c->epoch;
+        }
+    }
+}
+
 /**
  * @brief sends a notification on the UMP channel
  *
@@ -256,7 +356,7 @@ static inline void smlt_ump_queue_notify(struct smlt_ump_queue *c,
                                          union smlt_ump_ctrl ctrl)
 {
     // write the contorl block triggers the sending operation
-    ctrl.c.epoch = c->epoch;
+    ctrl.c.epoch = (ctrl.c.epoch & ~SMLT_UMP_EPOCH_MASK) | c->epoch;
     c->buf[c->pos].ctrl.raw = ctrl.raw;
 
     // update index state
@@ -296,7 +396,104 @@ static inline volatile bool smlt_ump_queue_can_recv(struct smlt_ump_queue *c)
 
     volatile struct smlt_ump_message *m = c->buf + c->pos;
 
-    return (m->ctrl.c.epoch == c->epoch);
+    return ((m->ctrl.c.epoch & SMLT_UMP_EPOCH_MASK) == c->epoch);
+}
+
+/**
+ * @brief obtains a pointer to the next message to be received
+ *
+ * @param c     the UMP channel to get the next message for
+ *
+ * @return pointer to a message slot
+ *
+ * The slot is only valid if smlt_ump_queue_can_recv() returned TRUE and stays
+ * valid until it is consumed using smlt_ump_queue_recv_raw().
+ */
+static inline volatile
+struct smlt_ump_message *smlt_ump_queue_peek(struct smlt_ump_queue *c)
+{
+    SMLT_ASSERT(c->direction == SMLT_UMP_DIRECTION_RECV);
+    return c->buf + c->pos;
+}
+
+/**
+ * @brief obtains a pointer to the n-th received message after the current one
+ *
+ * @param c     the UMP channel to get the message for
+ * @param n     offset of the slot from the current position
+ *
+ * @return pointer to the message slot, NULL if the slot has not been written
+ */
+static inline volatile
+struct smlt_ump_message *smlt_ump_queue_peek_nth(struct smlt_ump_queue *c,
+                                                 smlt_ump_idx_t n)
+{
+    SMLT_ASSERT(c->direction == SMLT_UMP_DIRECTION_RECV);
+    SMLT_ASSERT(n < c->num_msg);
+
+    bool epoch = c->epoch;
+    uint32_t idx = (uint32_t)c->pos + n;
+    if (idx >= c->num_msg) {
+        idx -= c->num_msg;
+        epoch = !epoch;
+    }
+
+    volatile struct smlt_ump_message *m = c->buf + idx;
+    if ((m->ctrl.c.epoch & SMLT_UMP_EPOCH_MASK) != epoch) {
+        return NULL;
+    }
+
+    return m;
+}
+
+/**
+ * @brief checks whether a message slot starts a fragmented message
+ *
+ * @param m     the UMP message slot
+ *
+ * @returns TRUE if the slot is the first fragment of a message
+ */
+static inline bool smlt_ump_message_is_frag(volatile struct smlt_ump_message *m)
+{
+    return (m->ctrl.c.epoch & SMLT_UMP_FLAG_FRAG);
+}
+
+/**
+ * @brief advances the receive position by one slot
+ *
+ * @param q     the UMP channel to be received on
+ *
+ * @returns TRUE if the ACK has to be written back according to the policy
+ */
+static inline bool smlt_ump_queue_advance_rx(struct smlt_ump_queue *q)
+{
+    bool do_ack;
+
+    switch(q->ack_policy) {
+        case SMLT_UMP_ACK_EVERY :
+            do_ack = true;
+            break;
+        case SMLT_UMP_ACK_EVERY_N :
+            do_ack = (++q->ack_pending == q->ack_interval);
+            if (do_ack) {
+                q->ack_pending = 0;
+            }
+            break;
+        default:
+            // ack twice: once in the middle and once at the end
+            do_ack = (q->pos == (q->num_msg >> 1));
+            break;
+    }
+
+    if (++q->pos == q->num_msg) {
+        q->pos = 0;
+        q->epoch = !q->epoch;
+        if (q->ack_policy == SMLT_UMP_ACK_HALF_WINDOW) {
+            do_ack = true;
+        }
+    }
+
+    return do_ack;
 }
 
 /**
@@ -321,19 +518,11 @@ static inline errval_t smlt_ump_queue_recv_raw(struct smlt_ump_queue *q,
     m = q->buf + q->pos;
 
     ctrl.raw = m->ctrl.raw;
-    if (ctrl.c.epoch != q->epoch) {
+    if ((ctrl.c.epoch & SMLT_UMP_EPOCH_MASK) != q->epoch) {
         return SMLT_ERR_QUEUE_EMPTY;
     }
 
-    // Write ack twice: once in the middle
-    // and once at the end
-    if (q->pos == (q->num_msg >> 1)) {
-        *(q->last_ack) = ctrl.c.last_ack;
-    }
-
-    if (++q->pos == q->num_msg) {
-        q->pos = 0;
-        q->epoch = !q->epoch;
+    if (smlt_ump_queue_advance_rx(q)) {
         *(q->last_ack) = ctrl.c.last_ack;
     }
 
@@ -344,4 +533,37 @@ static inline errval_t smlt_ump_queue_recv_raw(struct smlt_ump_queue *q,
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief consumes a batch of received message slots
+ *
+ * @param q     the UMP channel to be received on
+ * @param num   the number of slots to consume, starting at the current one
+ *
+ * The slots must have been checked with smlt_ump_queue_peek_nth(). The ACK
+ * is written back at most once for the entire batch, if the ACK policy
+ * requires one for any of the slots.
+ */
+static inline void smlt_ump_queue_recv_batch_raw(struct smlt_ump_queue *q,
+                                                 smlt_ump_idx_t num)
+{
+    union smlt_ump_ctrl ctrl;
+    bool do_ack = false;
+
+    SMLT_ASSERT(q);
+
+    ctrl.raw = 0;
+    for (smlt_ump_idx_t i = 0; i < num; i++) {
+        ctrl.raw = q->buf[q->pos].ctrl.raw;
+
+        if (smlt_ump_queue_advance_rx(q)) {
+            do_ack = true;
+        }
+    }
+
+    // acknowledge up to the last slot of the batch
+    if (do_ack) {
+        *(q->last_ack) = ctrl.c.last_ack;
+    }
+}
+
 #endif // SMLT_UMP_QUEUE_H_
@@ -24,6 +24,13 @@ struct smlt_ump_queuepair
     struct smlt_ump_queuepair *other; ///< pointer to the other queue pair
     smlt_ump_idx_t seq_id;            ///< last sequence number of the message
     smlt_ump_idx_t last_ack;          ///< last ACKed sequence number
+
+    /* fragmented messages that are partially sent or received */
+    smlt_msg_payload_t *tx_frag_data; ///< payload of the message being sent
+    uint32_t tx_frag_words;           ///< total words of the message being sent
+    uint32_t tx_frag_offset;          ///< words sent so far, 0 if none
+    uint32_t rx_frag_words;           ///< total words of the message being received
+    uint32_t rx_frag_offset;          ///< words received so far, 0 if none
 };
 
 /**
@@ -39,14 +46,34 @@ errval_t smlt_ump_queuepair_init(smlt_ump_idx_t num_slots, uint8_t node_src,
                                   struct smlt_ump_queuepair *dst);
 
 /**
- * @brief destorys a ump queuepair
+ * @brief destroys one end of a UMP queuepair
  *
  * @param qp    the UMP queuepair
  *
  * @returns SMLT_SUCCESS or error value
+ *
+ * The buffer the end receives on is freed, both ends have to be destroyed
+ * once neither of them is used anymore.
  */
 errval_t smlt_ump_queuepair_destroy(struct smlt_ump_queuepair *qp);
 
+/**
+ * @brief sets the ACK policy for the messages received on the queuepair
+ *
+ * @param qp        the UMP queuepair
+ * @param policy    the ACK policy
+ * @param interval  number of messages per ACK for SMLT_UMP_ACK_EVERY_N
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The default policy SMLT_UMP_ACK_HALF_WINDOW writes the ACK twice per round
+ * through the buffer. Acknowledging more often lets the sender reuse slots
+ * earlier at the cost of more cacheline transfers on the ACK word.
+ */
+errval_t smlt_ump_queuepair_set_ack_policy(struct smlt_ump_queuepair *qp,
+                                           smlt_ump_ack_policy_t policy,
+                                           smlt_ump_idx_t interval);
+
 
 /*
  * ===========================================================================
@@ -72,6 +99,28 @@ static inline volatile bool smlt_ump_queuepair_can_send_raw(struct smlt_ump_queu
     return (smlt_ump_idx_t)(qp->seq_id - qp->last_ack) <= qp->tx.num_msg;
 }
 
+/**
+ * @brief checks whether a number of messages can be sent on the queuepair
+ *
+ * @param qp    the UMP queue pair
+ * @param num   the number of messages to send
+ *
+ * @returns TRUE if num messages can be sent, FALSE otherwise
+ */
+static inline volatile bool smlt_ump_queuepair_can_send_n_raw(struct smlt_ump_queuepair *qp,
+                                                              smlt_ump_idx_t num)
+{
+    smlt_ump_idx_t seq_id = qp->seq_id + num - 1;
+
+    if ((smlt_ump_idx_t)(seq_id - qp->last_ack) <= qp->tx.num_msg) {
+        return true;
+    }
+
+    qp->last_ack = smlt_ump_queue_last_ack(&qp->tx);
+
+    return (smlt_ump_idx_t)(seq_id - qp->last_ack) <= qp->tx.num_msg;
+}
+
 /**
  * @brief prepares the UMP queuepair to send a message
  *
@@ -98,6 +147,7 @@ static inline errval_t smlt_ump_queuepair_notify_raw(struct smlt_ump_queuepair *
 
     SMLT_ASSERT(smlt_ump_queuepair_can_send_raw(qp));
 
+    ctrl.c.epoch = 0;
     ctrl.c.last_ack = (uintptr_t)qp->seq_id;
     qp->seq_id++;
 
@@ -113,6 +163,7 @@ static inline errval_t smlt_ump_queuepair_send_raw(struct smlt_ump_queuepair *qp
 
     SMLT_ASSERT(smlt_ump_queuepair_can_send_raw(qp));
 
+    ctrl.c.epoch = 0;
     ctrl.c.last_ack = qp->seq_id;
 
     qp->seq_id++;
@@ -121,6 +172,25 @@ static inline errval_t smlt_ump_queuepair_send_raw(struct smlt_ump_queuepair *qp
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief sends a batch of filled message slots
+ *
+ * @param qp    the UMP queuepair to send on
+ * @param num   the number of slots obtained by smlt_ump_queue_get_nth()
+ *
+ * @returns SMLT_SUCCESS
+ */
+static inline errval_t smlt_ump_queuepair_send_batch_raw(struct smlt_ump_queuepair *qp,
+                                                         smlt_ump_idx_t num)
+{
+    SMLT_ASSERT(smlt_ump_queuepair_can_send_n_raw(qp, num));
+
+    smlt_ump_queue_send_batch(&qp->tx, num, qp->seq_id);
+    qp->seq_id += num;
+
+    return SMLT_SUCCESS;
+}
+
 /* send function pointer */
 
 /**
@@ -130,6 +200,12 @@ static inline errval_t smlt_ump_queuepair_send_raw(struct smlt_ump_queuepair *qp
  * @param msg    the Smelt message to send
  *
  * @returns SMELT_SUCCESS of the messessage could be sent.
+ *
+ * Messages larger than SMLT_UMP_PAYLOAD_WORDS are fragmented and streamed
+ * over consecutive slots. If the queue fills up before the last fragment has
+ * been written, SMLT_ERR_QUEUE_FULL is returned and the next call with the
+ * same message continues where this one stopped. Other messages are not sent
+ * until the pending one is complete.
  */
 errval_t smlt_ump_queuepair_try_send(struct smlt_qp *qp,
                                      struct smlt_msg *msg);
@@ -153,12 +229,34 @@ static inline errval_t smlt_ump_queuepair_send(struct smlt_qp *qp,
     return err;
 }
 
+/**
+ * @brief sends a batch of messages on the queuepair
+ *
+ * @param qp      The smelt queuepair to send on
+ * @param msgs    array of Smelt messages to send
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages sent
+ *
+ * @returns SMLT_SUCCESS if at least one message was sent,
+ *          SMLT_ERR_QUEUE_FULL if none could be sent
+ *
+ * As many messages as there are free slots are published with a single
+ * write barrier. A message larger than SMLT_UMP_PAYLOAD_WORDS ends the batch
+ * and is sent on its own by the next call.
+ */
+errval_t smlt_ump_queuepair_try_send_batch(struct smlt_qp *qp,
+                                           struct smlt_msg **msgs,
+                                           uint32_t num,
+                                           uint32_t *ret_num);
+
 /**
 * @brief sends a notification on the queuepair
 *
 * @param qp     The smelt queuepair to send on
 *
-* @returns SMELT_SUCCESS of the messessage could be sent.
+* @returns SMELT_SUCCESS of the messessage could be sent, SMLT_ERR_QUEUE_FULL
+*          if a fragmented message is partially sent and has to be completed
+*          first.
 */
 errval_t smlt_ump_queuepair_notify(struct smlt_qp *qp);
 
@@ -167,10 +265,34 @@ errval_t smlt_ump_queuepair_notify(struct smlt_qp *qp);
 *
 * @param qp     The smelt queuepair to send on
 *
-* @returns TRUE if a message can be sent, FALSE otherwise
+* @returns TRUE if a message can be sent, FALSE otherwise or if a fragmented
+*          message is partially sent
 */
 bool smlt_ump_queuepair_can_send(struct smlt_qp *qp);
 
+/**
+ * @brief obtains the payload of the next message slot to write into
+ *
+ * @param qp     The smelt queuepair to send on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL if there is no free slot or
+ *          a fragmented message is partially sent
+ */
+errval_t smlt_ump_queuepair_try_send_prepare(struct smlt_qp *qp,
+                                             smlt_msg_payload_t **data,
+                                             uint32_t *words);
+
+/**
+ * @brief sends the prepared message slot
+ *
+ * @param qp     The smelt queuepair to send on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ump_queuepair_send_commit(struct smlt_qp *qp);
+
 
 /*
  * ===========================================================================
@@ -226,10 +348,38 @@ bool smlt_ump_queuepair_can_send(struct smlt_qp *qp);
  * @param msg    the Smelt message to receive in
  *
  * @returns SMELT_SUCCESS of the messessage could be received.
+ *          SMLT_ERR_MSG_TRUNCATED if a fragmented message did not fit into
+ *          the message buffer
+ *
+ * The number of words of the message is set to the number of words received,
+ * which is at most SMLT_UMP_PAYLOAD_WORDS for single slot messages. Fragmented
+ * messages are reassembled into the buffer of the message. If the queue runs
+ * empty before the last fragment has arrived, SMLT_ERR_QUEUE_EMPTY is
+ * returned and the next call with the same message continues the reassembly.
  */
 errval_t smlt_ump_queuepair_try_recv(struct smlt_qp *qp,
                                      struct smlt_msg *msg);
 
+/**
+ * @brief receives a batch of messages on the queuepair
+ *
+ * @param qp      The smelt queuepair to receive on
+ * @param msgs    array of Smelt messages to receive in
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages received
+ *
+ * @returns SMLT_SUCCESS if at least one message was received,
+ *          SMLT_ERR_QUEUE_EMPTY if there was no message
+ *
+ * All slots that are ready are consumed, up to num, and the ACK is written
+ * back to the sender at most once. A fragmented message ends the batch and
+ * is received on its own by the next call.
+ */
+errval_t smlt_ump_queuepair_try_recv_batch(struct smlt_qp *qp,
+                                           struct smlt_msg **msgs,
+                                           uint32_t num,
+                                           uint32_t *ret_num);
+
 /**
  * @brief receives a message on the queuepair
  *
@@ -267,5 +417,28 @@ errval_t smlt_ump_queuepair_recv_notify(struct smlt_qp *qp);
 */
 bool smlt_ump_queuepair_can_recv(struct smlt_qp *qp);
 
+/**
+ * @brief lends the payload of the next message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS if the slot is lent, SMLT_ERR_QUEUE_EMPTY if there is
+ *          no message or SMLT_ERR_MSG_FRAGMENTED for fragmented messages
+ */
+errval_t smlt_ump_queuepair_try_recv_borrow(struct smlt_qp *qp,
+                                            const smlt_msg_payload_t **data,
+                                            uint32_t *words);
+
+/**
+ * @brief releases the lent message slot and acknowledges it
+ *
+ * @param qp     The smelt queuepair to receive on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ump_queuepair_recv_release(struct smlt_qp *qp);
+
 
 #endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_ALLREDUCE_H_
+#define SMLT_ALLREDUCE_H_ 1
+
+#include <smlt_reduction.h>
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/**
+ * the maximum number of nodes for which recursive doubling over all nodes is
+ * selected, larger contexts use the hybrid algorithm
+ */
+#define SMLT_ALLREDUCE_RD_MAX_NODES 16
+
+/**
+ * allreduce algorithms
+ */
+typedef enum {
+    SMLT_ALLREDUCE_AUTO = 0,            ///< selected by smlt_allreduce_select()
+    SMLT_ALLREDUCE_TREE,                ///< reduction followed by a broadcast
+    SMLT_ALLREDUCE_RECURSIVE_DOUBLING,  ///< butterfly over the pairwise mesh
+    SMLT_ALLREDUCE_HYBRID,              ///< gather in the shared memory islands,
+                                        ///< butterfly between the island heads
+} smlt_allreduce_algo_t;
+
+
+/*
+ * ===========================================================================
+ * Smelt allreduce
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief selects the allreduce algorithm for the context and message size
+ *
+ * @param ctx       The smelt context
+ * @param words     number of payload words of the message
+ *
+ * @returns the algorithm to use
+ *
+ * Recursive doubling and the hybrid algorithm use the pairwise channels set
+ * up by smlt_init(). Messages up to SMLT_MSG_CHUNK_WORDS use recursive
+ * doubling on up to SMLT_ALLREDUCE_RD_MAX_NODES nodes and the hybrid
+ * algorithm on larger contexts. Larger messages use the pipelined tree.
+ */
+smlt_allreduce_algo_t smlt_allreduce_select(struct smlt_context *ctx,
+                                            uint32_t words);
+
+/**
+ * @brief reduces the input of all nodes and returns the result on all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * All nodes of the context have to call this function with the same number
+ * of words. The algorithm is chosen with smlt_allreduce_select().
+ */
+errval_t smlt_allreduce(struct smlt_context *ctx,
+                        struct smlt_msg *input,
+                        struct smlt_msg *result,
+                        smlt_reduce_op_t op,
+                        smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief reduces the input of all nodes using the given algorithm
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param algo      the algorithm, the same on all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_allreduce_with_algo(struct smlt_context *ctx,
+                                  struct smlt_msg *input,
+                                  struct smlt_msg *result,
+                                  smlt_reduce_op_t op,
+                                  smlt_reduce_dtype_t dtype,
+                                  smlt_allreduce_algo_t algo);
+
+#endif /* SMLT_ALLREDUCE_H_ */
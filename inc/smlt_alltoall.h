@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_ALLTOALL_H_
+#define SMLT_ALLTOALL_H_ 1
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/**
+ * the maximum number of words of a block for which the direct exchange is
+ * selected, larger blocks use the pairwise exchange
+ */
+#define SMLT_ALLTOALL_DIRECT_MAX_WORDS SMLT_MSG_CHUNK_WORDS
+
+/**
+ * all-to-all algorithms
+ */
+typedef enum {
+    SMLT_ALLTOALL_AUTO = 0,     ///< selected by smlt_alltoall_select()
+    SMLT_ALLTOALL_DIRECT,       ///< all blocks are exchanged at once
+    SMLT_ALLTOALL_PAIRWISE,     ///< one send and one receive peer per step
+    SMLT_ALLTOALL_TWO_PHASE,    ///< blocks are combined per NUMA node before
+                                ///< they cross to the remote NUMA nodes
+} smlt_alltoall_algo_t;
+
+
+/*
+ * ===========================================================================
+ * Smelt all-to-all
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief selects the all-to-all algorithm for the context and block size
+ *
+ * @param ctx           The smelt context
+ * @param block_words   number of words of a block
+ *
+ * @returns the algorithm to use
+ *
+ * If the nodes of the context span more than one NUMA node, small blocks use
+ * the two-phase algorithm. Otherwise, blocks up to
+ * SMLT_ALLTOALL_DIRECT_MAX_WORDS use the direct exchange and larger blocks
+ * the pairwise exchange.
+ */
+smlt_alltoall_algo_t smlt_alltoall_select(struct smlt_context *ctx,
+                                          uint32_t block_words);
+
+/**
+ * @brief sends a distinct block to every node and receives one from each
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks for all nodes
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the blocks of all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * Both buffers hold smlt_context_get_num_nodes() blocks in the order of
+ * smlt_context_get_rank(): block i of the send buffer goes to the node of
+ * rank i, block i of the receive buffer comes from the node of rank i. The
+ * blocks are exchanged over the pairwise channels set up by smlt_init(). The
+ * algorithm is chosen with smlt_alltoall_select().
+ */
+errval_t smlt_alltoall(struct smlt_context *ctx,
+                       struct smlt_msg *sendbuf,
+                       uint32_t block_words,
+                       struct smlt_msg *recvbuf);
+
+/**
+ * @brief sends a distinct block to every node using the given algorithm
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks for all nodes
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the blocks of all nodes
+ * @param algo          the algorithm, the same on all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_alltoall_with_algo(struct smlt_context *ctx,
+                                 struct smlt_msg *sendbuf,
+                                 uint32_t block_words,
+                                 struct smlt_msg *recvbuf,
+                                 smlt_alltoall_algo_t algo);
+
+#endif /* SMLT_ALLTOALL_H_ */
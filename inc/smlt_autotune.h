@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_AUTOTUNE_H_
+#define SMLT_AUTOTUNE_H_ 1
+
+#include <smlt_queuepair.h>
+
+/*
+ * ===========================================================================
+ * Backend autotuning
+ * ===========================================================================
+ */
+
+/// name of the file in the cache directory holding the per-edge decisions
+#define SMLT_AUTOTUNE_CACHE_FILE "backends"
+
+/// number of round trips to warm up the queuepair before measuring
+#define SMLT_AUTOTUNE_WARMUP 100
+
+/// number of measured round trips per backend
+#define SMLT_AUTOTUNE_ROUNDS 1000
+
+
+/**
+ * @brief measures the round trip latency of a backend between two cores
+ *
+ * @param type      the queuepair backend to measure
+ * @param src       the core initiating the round trips
+ * @param dst       the core echoing the messages
+ * @param ret_cyc   returns the median round trip time in cycles
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The measurement spawns one thread on each of the two cores.
+ */
+errval_t smlt_autotune_measure(smlt_qp_type_t type, coreid_t src,
+                               coreid_t dst, cycles_t *ret_cyc);
+
+/**
+ * @brief selects the fastest backend for the edge between two cores
+ *
+ * @param src       the core of the parent
+ * @param dst       the core of the child
+ * @param max_words the largest message sent on the edge, 0 if unknown
+ * @param ret_type  returns the backend to use
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Only UMP fragments messages, FFQ and the shared memory queuepair are
+ * considered only if max_words fits into one of their slots. Otherwise UMP
+ * is returned without measuring.
+ *
+ * The timings are looked up in the on-disk cache first. If the edge is not
+ * in the cache, the considered backends are measured with
+ * smlt_autotune_measure() and their timings are added to the cache.
+ */
+errval_t smlt_autotune_edge(coreid_t src, coreid_t dst, uint32_t max_words,
+                            smlt_qp_type_t *ret_type);
+
+/**
+ * @brief checks whether autotuning was requested in the environment
+ *
+ * @returns TRUE if SMLT_AUTOTUNE is set to a non-zero value
+ */
+bool smlt_autotune_enabled(void);
+
+/**
+ * @brief returns the largest message size given in the environment
+ *
+ * @returns the value of SMLT_AUTOTUNE_MAX_WORDS or 0 if it is not set or
+ *          not a number
+ */
+uint32_t smlt_autotune_max_msg_words(void);
+
+#endif /* SMLT_AUTOTUNE_H_ */
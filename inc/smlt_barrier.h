@@ -15,6 +15,7 @@
 struct smlt_context;
 struct smlt_channel;
 struct smlt_dissem_barrier;
+struct smlt_request;
 
 /*
  * ===========================================================================
@@ -72,6 +73,48 @@ errval_t smlt_barrier_destroy(struct smlt_context *ctx);
  */
 errval_t smlt_barrier_wait(struct smlt_context *ctx);
 
+/**
+ * @brief enters the barrier without waiting for the other nodes
+ *
+ * @param ctx    the Smelt context
+ * @param req    returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The request is completed once all nodes of the context have entered the
+ * barrier. The notifications are passed on while the node calls
+ * smlt_progress(), smlt_test() or smlt_wait().
+ */
+errval_t smlt_ibarrier(struct smlt_context *ctx, struct smlt_request **req);
+
+/**
+ * @brief signals that the node has arrived at the barrier
+ *
+ * @param ctx    the Smelt context
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ *
+ * The first half of smlt_barrier_wait(): the node can do work that does not
+ * depend on the other nodes before calling smlt_barrier_depart(). Calling
+ * smlt_progress() during that work forwards the arrival of the children
+ * towards the root. SMLT_ERR_INVAL is returned if the node has already
+ * arrived without departing.
+ */
+errval_t smlt_barrier_arrive(struct smlt_context *ctx);
+
+/**
+ * @brief waits until all nodes have arrived at the barrier
+ *
+ * @param ctx    the Smelt context
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ *
+ * The second half of smlt_barrier_wait(), returns once all nodes of the
+ * context have called smlt_barrier_arrive(). SMLT_ERR_INVAL is returned if
+ * the node has not arrived.
+ */
+errval_t smlt_barrier_depart(struct smlt_context *ctx);
+
 
 
 
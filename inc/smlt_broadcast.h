@@ -12,6 +12,7 @@
 /* forward declaratio */
 struct smlt_context;
 struct smlt_msg;
+struct smlt_request;
 
 /*
  * ===========================================================================
@@ -54,6 +55,39 @@ errval_t smlt_broadcast(struct smlt_context *ctx,
                         struct smlt_msg *msg);
 
 
+/**
+ * @brief performs a pipelined broadcast to the nodes of the subtree rooted
+ *        at the calling node
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   the message to send
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The other nodes of the subtree call smlt_broadcast_pipelined().
+ */
+errval_t smlt_broadcast_pipelined_subtree(struct smlt_context *ctx,
+                                          struct smlt_msg *msg);
+
+/**
+ * @brief performs a broadcast to all nodes, forwarding the message down the
+ *        tree in chunks
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   the message to send on the root, returns it on the others
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The message is split into chunks of SMLT_MSG_CHUNK_WORDS words.
+ * Inner nodes forward each chunk to their children as soon as it arrives,
+ * so the latency of large broadcasts is proportional to the depth of the
+ * tree plus the number of chunks rather than their product. The length of
+ * the message is not transmitted: all nodes must pass a message with the
+ * same number of words.
+ */
+errval_t smlt_broadcast_pipelined(struct smlt_context *ctx,
+                                  struct smlt_msg *msg);
+
 /**
  * @brief checks if the node can recv from his parent
  * 
@@ -72,6 +106,23 @@ bool smlt_broadcast_can_recv(struct smlt_context *ctx);
  */
 errval_t smlt_broadcast_notify(struct smlt_context *ctx);
 
+/**
+ * @brief starts a broadcast to all nodes without waiting for it
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   input for the broadcast, or NULL for a notification
+ * @param req   returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Like smlt_broadcast(), the message must not be touched until the request
+ * is completed. The message is received and forwarded to the children while
+ * the node calls smlt_progress(), smlt_test() or smlt_wait().
+ */
+errval_t smlt_ibroadcast(struct smlt_context *ctx,
+                         struct smlt_msg *msg,
+                         struct smlt_request **req);
+
 
 /*
  * ===========================================================================
@@ -80,6 +131,20 @@ errval_t smlt_broadcast_notify(struct smlt_context *ctx);
  */
 
 
+/**
+ * @brief advances a non-blocking broadcast
+ *
+ * @param req   the request of the broadcast
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Receives the message once the parent has sent it, then forwards it to the
+ * children and marks the request as done. A message of NULL broadcasts a
+ * notification.
+ */
+errval_t smlt_broadcast_progress(struct smlt_request *req);
+
+
 /*
   TODO
   uintptr_t mp_receive_forward(uintptr_t);  
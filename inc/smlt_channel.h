@@ -25,6 +25,17 @@
 
 extern __thread smlt_nid_t smlt_node_self_id; ///< caches the node id
 
+#define SMLT_CHAN_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/**
+ * number of payload words of a chunk of a collective operation, the largest
+ * message that fits into a single slot of every queuepair backend and of the
+ * SWMR queue
+ */
+#define SMLT_MSG_CHUNK_WORDS \
+    SMLT_CHAN_MIN(SMLT_CHAN_MIN(SMLT_UMP_PAYLOAD_WORDS, SMLT_FFQ_MSG_WORDS), \
+                  SMLT_CHAN_MIN(SHM_QP_PAYLOAD_WORDS, SWMR_SLOT_PAYLOAD_WORDS))
+
 /*
  * ===========================================================================
  * Smelt queuepair type definitions
@@ -58,6 +69,18 @@ struct smlt_channel
 };
 
 
+/**
+ * attributes used when creating a Smelt channel
+ */
+struct smlt_channel_attr
+{
+    smlt_qp_type_t backend;   ///< backend of the queuepairs of the channel
+    smlt_ump_ack_policy_t ack_policy; ///< ACK policy of UMP queuepairs
+    uint16_t ack_interval;    ///< messages per ACK for SMLT_UMP_ACK_EVERY_N
+    uint32_t num_slots;       ///< slots of the queuepairs, 0 for the default
+    uint32_t swmr_queue_size; ///< cachelines of the SWMR queue, 0 for default
+};
+
 /*
  * ===========================================================================
  * Smelt channel creation and destruction
@@ -82,12 +105,47 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
                              uint16_t count_src,
                              uint16_t count_dst);
 
+/**
+ * @brief initializes the channel attributes with the default values
+ *
+ * @param attr  the channel attributes to initialize
+ *
+ * The default backend is UMP. It can be overridden with the SMLT_BACKEND
+ * environment variable, which takes the values "ump", "ffq" and "shm".
+ */
+void smlt_channel_attr_init(struct smlt_channel_attr *attr);
+
+ /**
+  * @brief creates the queue pair using the given attributes
+  *
+  * @param chan     return pointer to the channel
+  * @param src      src core ids
+  * @param dst      array of core ids to desinations
+  * @param count_src    length of array src;
+  * @param count_dst    length of array dst;
+  * @param attr     channel attributes, NULL for the defaults
+  *
+  * @returns SMLT_SUCCESS or failure
+  *
+  * The backend in the attributes is used for the 1:1 channels and for the
+  * reverse direction of the 1:n channels. The forward direction of a 1:n
+  * channel always uses the shared memory queue, sized by swmr_queue_size.
+  */
+errval_t smlt_channel_create_with_attr(struct smlt_channel **chan,
+                                       uint32_t* src,
+                                       uint32_t* dst,
+                                       uint16_t count_src,
+                                       uint16_t count_dst,
+                                       struct smlt_channel_attr *attr);
+
  /**
-  * @brief destroys the channel
+  * @brief destroys the queuepairs and the queue of the channel
   *
-  * @param
+  * @param chan     the channel to destroy, it may be partially created
   *
-  * @returns 0
+  * The memory of the channel itself belongs to the caller.
+  *
+  * @returns SMLT_SUCCESS or failure
   */
 errval_t smlt_channel_destroy(struct smlt_channel *chan);
 
@@ -268,7 +326,7 @@ static inline errval_t smlt_channel_recv(struct smlt_channel *chan,
         } else {
             for (unsigned int i = 0; i < chan->m; i++) {
                 if (chan->c.shm.dst[i] == smlt_node_self_id) {
-                    smlt_swmr_recv(&chan->c.shm.send_owner.dst[i], msg);
+                    err = smlt_swmr_recv(&chan->c.shm.send_owner.dst[i], msg);
                 }
             }
             //smlt_swmr_recv(&chan->c.shm.send_owner.dst[smlt_node_self_id-1], msg);
@@ -309,7 +367,7 @@ static inline errval_t smlt_channel_recv_index(struct smlt_channel *chan,
                 err = smlt_queuepair_recv(chan->c.shm.recv_owner[i], msg);
             }
         } else {
-            smlt_swmr_recv(&chan->c.shm.send_owner.dst[index], msg);
+            err = smlt_swmr_recv(&chan->c.shm.send_owner.dst[index], msg);
         }
         return err;
     }
@@ -348,6 +406,29 @@ static inline bool smlt_channel_can_recv(struct smlt_channel *chan)
     return result;
 }
 
+/**
+ * @brief checks if there is a message to be received by a child of a 1:n
+ *        channel
+ *
+ * @param chan      the Smelt channel to call the check function on
+ * @param index     the index of the child in the channel
+ *
+ * @returns TRUE if smlt_channel_recv_index() will not block
+ *          FALSE otherwise
+ *
+ * Unlike smlt_channel_can_recv(), this checks the shared memory queue of the
+ * child. On the other channels, it is the same as smlt_channel_can_recv().
+ */
+static inline bool smlt_channel_can_recv_index(struct smlt_channel *chan,
+                                               uint32_t index)
+{
+    if (chan->use_shm && chan->owner != smlt_node_self_id) {
+        return swmr_can_receive(&chan->c.shm.send_owner.dst[index]);
+    }
+
+    return smlt_channel_can_recv(chan);
+}
+
 /**
  * @brief receives a message or a notification from the queuepair
  *
@@ -407,6 +488,150 @@ static inline errval_t smlt_channel_recv_notification(struct smlt_channel *chan)
     }
 }
 
+/**
+ * @brief obtains the payload of the next message slot of the channel
+ *
+ * @param chan      the Smelt channel to call the operation on
+ * @param data      returns a pointer to the payload in the queue slot
+ * @param words     returns the number of payload words available in the slot
+ *
+ * @returns error value
+ *
+ * The caller writes the message directly into the shared slot and sends it
+ * using smlt_channel_send_commit(). No other message must be sent on the
+ * channel in between. Only 1:1 channels and the owner of a 1:n channel have
+ * a single slot to write into, the other end of a 1:n channel writes to its
+ * own queuepair.
+ *
+ * This function is BLOCKING if the channel cannot take new messages
+ */
+static inline errval_t smlt_channel_send_prepare(struct smlt_channel *chan,
+                                                 smlt_msg_payload_t **data,
+                                                 uint32_t *words)
+{
+    if (!chan->use_shm) {
+        if (chan->owner == smlt_node_self_id) {
+            return smlt_queuepair_send_prepare(&chan->c.mp.send[0], data, words);
+        } else {
+            return smlt_queuepair_send_prepare(&chan->c.mp.recv[0], data, words);
+        }
+    } else {
+        if (chan->owner == smlt_node_self_id) {
+            return smlt_swmr_send_prepare(&chan->c.shm.send_owner, data, words);
+        }
+
+        for (unsigned int i = 0; i < chan->m; i++) {
+            if (chan->c.shm.dst[i] == smlt_node_self_id) {
+                return smlt_queuepair_send_prepare(chan->c.shm.recv[i],
+                                                   data, words);
+            }
+        }
+        return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief sends the message slot obtained by smlt_channel_send_prepare()
+ *
+ * @param chan      the Smelt channel to call the operation on
+ *
+ * @returns error value
+ */
+static inline errval_t smlt_channel_send_commit(struct smlt_channel *chan)
+{
+    if (!chan->use_shm) {
+        if (chan->owner == smlt_node_self_id) {
+            return smlt_queuepair_send_commit(&chan->c.mp.send[0]);
+        } else {
+            return smlt_queuepair_send_commit(&chan->c.mp.recv[0]);
+        }
+    } else {
+        if (chan->owner == smlt_node_self_id) {
+            return smlt_swmr_send_commit(&chan->c.shm.send_owner);
+        }
+
+        for (unsigned int i = 0; i < chan->m; i++) {
+            if (chan->c.shm.dst[i] == smlt_node_self_id) {
+                return smlt_queuepair_send_commit(chan->c.shm.recv[i]);
+            }
+        }
+        return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief lends the payload of the next message on the channel to the caller
+ *
+ * @param chan      the Smelt channel to call the operation on
+ * @param data      returns a pointer to the payload in the queue slot
+ * @param words     returns the number of payload words available in the slot
+ *
+ * @returns SMLT_SUCCESS if the message is lent
+ *          SMLT_ERR_MSG_FRAGMENTED if the message spans several slots and has
+ *          to be received using smlt_channel_recv()
+ *          SMLT_ERR_INVAL if called by the owner of a 1:n channel
+ *
+ * The payload is not copied. It remains valid until the slot is returned
+ * using smlt_channel_recv_release(), which acknowledges the message.
+ *
+ * this function is BLOCKING if there is no message on the channel
+ */
+static inline errval_t smlt_channel_recv_borrow(struct smlt_channel *chan,
+                                                const smlt_msg_payload_t **data,
+                                                uint32_t *words)
+{
+    // 1:1
+    if (chan->n == chan->m) {
+        if (chan->owner == smlt_node_self_id){
+            return smlt_queuepair_recv_borrow(&chan->c.mp.send[0], data, words);
+        } else {
+            return smlt_queuepair_recv_borrow(&chan->c.mp.recv[0], data, words);
+        }
+    } else {
+        if (chan->owner == smlt_node_self_id){
+            return SMLT_ERR_INVAL;
+        }
+
+        for (unsigned i = 0; i < chan->m; i++) {
+            if (chan->c.shm.dst[i] == smlt_node_self_id) {
+                return smlt_swmr_recv_borrow(&chan->c.shm.send_owner.dst[i],
+                                             data, words);
+            }
+        }
+        return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief returns the message slot lent by smlt_channel_recv_borrow()
+ *
+ * @param chan      the Smelt channel to call the operation on
+ *
+ * @returns error value
+ */
+static inline errval_t smlt_channel_recv_release(struct smlt_channel *chan)
+{
+    // 1:1
+    if (chan->n == chan->m) {
+        if (chan->owner == smlt_node_self_id){
+            return smlt_queuepair_recv_release(&chan->c.mp.send[0]);
+        } else {
+            return smlt_queuepair_recv_release(&chan->c.mp.recv[0]);
+        }
+    } else {
+        if (chan->owner == smlt_node_self_id){
+            return SMLT_ERR_INVAL;
+        }
+
+        for (unsigned i = 0; i < chan->m; i++) {
+            if (chan->c.shm.dst[i] == smlt_node_self_id) {
+                return smlt_swmr_recv_release(&chan->c.shm.send_owner.dst[i]);
+            }
+        }
+        return SMLT_ERR_INVAL;
+    }
+}
+
 /*
  * ===========================================================================
  * state queries
@@ -13,6 +13,8 @@
 
 /* forward declaration */
 struct smlt_channel;
+struct smlt_qp;
+struct smlt_request;
 
 #define SMLT_CONTEXT_CHECK(_ctx)
 
@@ -28,6 +30,21 @@ struct smlt_channel;
  */
 struct smlt_context;
 
+/**
+ * attributes used when creating a Smelt context
+ */
+struct smlt_context_attr
+{
+    smlt_qp_type_t backend;   ///< backend of the message passing channels
+    bool autotune;            ///< select the backend per edge by measuring
+    uint32_t max_msg_words;   ///< largest message sent, 0 if unknown
+    smlt_ump_ack_policy_t ack_policy; ///< ACK policy of UMP queuepairs
+    uint16_t ack_interval;    ///< messages per ACK for SMLT_UMP_ACK_EVERY_N
+    uint32_t num_slots;       ///< slots of inner edges, 0 for the default
+    uint32_t leaf_num_slots;  ///< slots of edges to leaves, 0 for num_slots
+    uint32_t swmr_queue_size; ///< cachelines of SWMR queues, 0 for default
+};
+
 
 /*
  * ===========================================================================
@@ -48,12 +65,39 @@ struct smlt_context;
 errval_t smlt_context_create(struct smlt_topology *topo,
                              struct smlt_context **ret_ctx);
 
+/**
+ * @brief initializes the context attributes with the default values
+ *
+ * @param attr  the context attributes to initialize
+ *
+ * The backend defaults are taken from the channel defaults, see
+ * smlt_channel_attr_init(). Autotuning is enabled by setting the
+ * SMLT_AUTOTUNE environment variable to 1, the largest message size is taken
+ * from SMLT_AUTOTUNE_MAX_WORDS.
+ */
+void smlt_context_attr_init(struct smlt_context_attr *attr);
+
+/**
+ * @brief creates a new smelt context from the topology using the attributes
+ *
+ * @param topo      Smelt topology to create the context from
+ * @param attr      context attributes, NULL for the defaults
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return  SMLT_ERR_MALLOC_FAIL
+ *          SMLT_ERR_INVAL
+ *          SMLT_SUCCESS
+ */
+errval_t smlt_context_create_with_attr(struct smlt_topology *topo,
+                                       struct smlt_context_attr *attr,
+                                       struct smlt_context **ret_ctx);
+
 /**
  * @brief destroys the Smelt context and frees its resources
  *
  * @param ctx   Smelt context to destroy
  *
- * @return  SMLT_SUCCESS
+ * @return  SMLT_SUCCESS or error value
  */
 errval_t smlt_context_destroy(struct smlt_context *ctx);
 
@@ -126,6 +170,262 @@ errval_t smlt_context_get_parent_channel(struct smlt_context *ctx,
     return smlt_context_node_get_parent_channel(ctx, smlt_node_self, ret_chan);
 }
 
+/**
+ * @brief obtains the queuepairs the children of the node send on
+ *
+ * @param ctx       Smelt context
+ * @param node      Smelt node
+ * @param ret_qps   returns the array of queuepairs
+ * @param ret_sizes returns the subtree size of the child of each queuepair
+ * @param ret_count returns the number of queuepairs
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL
+ *
+ * There is one queuepair per child, also for the children sharing the
+ * shared memory channel. The subtrees of the children follow the node in
+ * the order of the queuepairs when numbered by rank.
+ */
+errval_t smlt_context_node_get_children_sources(struct smlt_context *ctx,
+                                                struct smlt_node *node,
+                                                struct smlt_qp ***ret_qps,
+                                                uint32_t **ret_sizes,
+                                                uint32_t *ret_count);
+
+/**
+ * @brief obtains the queuepairs the children of the current node send on
+ *
+ * @param ctx       Smelt context
+ * @param ret_qps   returns the array of queuepairs
+ * @param ret_sizes returns the subtree size of the child of each queuepair
+ * @param ret_count returns the number of queuepairs
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+static inline
+errval_t smlt_context_get_children_sources(struct smlt_context *ctx,
+                                           struct smlt_qp ***ret_qps,
+                                           uint32_t **ret_sizes,
+                                           uint32_t *ret_count)
+{
+    return smlt_context_node_get_children_sources(ctx, smlt_node_self, ret_qps,
+                                                  ret_sizes, ret_count);
+}
+
+
+
+/*
+ * ===========================================================================
+ * Node enumeration
+ * ===========================================================================
+ */
+
+///< index returned for nodes that are not part of the enumeration
+#define SMLT_CONTEXT_IDX_INVALID ((uint32_t)-1)
+
+/**
+ * @brief obtains the number of nodes in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of nodes
+ */
+uint32_t smlt_context_get_num_nodes(struct smlt_context *ctx);
+
+/**
+ * @brief obtains the id of a node in the context
+ *
+ * @param ctx   Smelt context
+ * @param idx   index of the node, smaller than smlt_context_get_num_nodes()
+ *
+ * @return the node id
+ *
+ * The nodes are numbered in the order of the topology, the root has index 0.
+ */
+smlt_nid_t smlt_context_get_node_id(struct smlt_context *ctx, uint32_t idx);
+
+/**
+ * @brief obtains the index of the node in the context
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the index or SMLT_CONTEXT_IDX_INVALID if the node is not part of
+ *         the context
+ */
+uint32_t smlt_context_node_get_idx(struct smlt_context *ctx,
+                                   struct smlt_node *node);
+
+/**
+ * @brief obtains the index of the current node in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the index or SMLT_CONTEXT_IDX_INVALID
+ */
+static inline uint32_t smlt_context_get_idx(struct smlt_context *ctx)
+{
+    return smlt_context_node_get_idx(ctx, smlt_node_self);
+}
+
+/**
+ * @brief obtains the number of islands of the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of islands
+ *
+ * The islands are the shared memory groups of the topology: a node and
+ * its children on the shared memory channel form an island headed by the
+ * node. Every node that is not a shared memory child heads an island, which
+ * has no other members if the node has no shared memory children. The
+ * root heads the island with index 0.
+ */
+uint32_t smlt_context_get_num_islands(struct smlt_context *ctx);
+
+/**
+ * @brief obtains the id of the head node of an island
+ *
+ * @param ctx   Smelt context
+ * @param idx   index of the island, the island of the root has index 0
+ *
+ * @return the node id of the head of the island
+ */
+smlt_nid_t smlt_context_get_island_head(struct smlt_context *ctx,
+                                        uint32_t idx);
+
+/**
+ * @brief obtains the island index of a node heading an island
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the index of the island or SMLT_CONTEXT_IDX_INVALID if the node
+ *         does not head an island
+ */
+uint32_t smlt_context_node_get_island_idx(struct smlt_context *ctx,
+                                          struct smlt_node *node);
+
+/**
+ * @brief obtains the island index of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the index of the island or SMLT_CONTEXT_IDX_INVALID
+ */
+static inline uint32_t smlt_context_get_island_idx(struct smlt_context *ctx)
+{
+    return smlt_context_node_get_island_idx(ctx, smlt_node_self);
+}
+
+/**
+ * @brief obtains the head of the island the node belongs to
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the node id of the head, the id of the node if it heads the island
+ */
+smlt_nid_t smlt_context_node_get_island_head(struct smlt_context *ctx,
+                                             struct smlt_node *node);
+
+/**
+ * @brief obtains the other members of the island headed by the node
+ *
+ * @param ctx           Smelt context
+ * @param node          Smelt node heading the island
+ * @param ret_members   returns the node ids of the members
+ * @param ret_count     returns the number of members
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL if the node does not head an island
+ */
+errval_t smlt_context_node_get_island_members(struct smlt_context *ctx,
+                                              struct smlt_node *node,
+                                              smlt_nid_t **ret_members,
+                                              uint32_t *ret_count);
+
+/**
+ * @brief obtains the rank of the node in the context
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the rank or SMLT_CONTEXT_IDX_INVALID if the node is not part of
+ *         the context
+ *
+ * The ranks number the nodes in a depth first traversal of the tree, so the
+ * subtree of every node occupies a contiguous range of ranks starting at
+ * the node itself. The gather and scatter collectives order the blocks of
+ * the nodes by rank.
+ */
+uint32_t smlt_context_node_get_rank(struct smlt_context *ctx,
+                                    struct smlt_node *node);
+
+/**
+ * @brief obtains the rank of the current node in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the rank or SMLT_CONTEXT_IDX_INVALID
+ */
+static inline uint32_t smlt_context_get_rank(struct smlt_context *ctx)
+{
+    return smlt_context_node_get_rank(ctx, smlt_node_self);
+}
+
+/**
+ * @brief obtains the id of the node with the given rank
+ *
+ * @param ctx   Smelt context
+ * @param rank  rank of the node, smaller than smlt_context_get_num_nodes()
+ *
+ * @return the node id
+ */
+smlt_nid_t smlt_context_get_node_id_by_rank(struct smlt_context *ctx,
+                                            uint32_t rank);
+
+/**
+ * @brief obtains the number of nodes in the subtree of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of nodes including the current node
+ */
+uint32_t smlt_context_get_subtree_size(struct smlt_context *ctx);
+
+/**
+ * @brief obtains the nodes served by the channel to the parent
+ *
+ * @param ctx       Smelt context
+ * @param ret_rank  returns the first rank served by the channel
+ * @param ret_num   returns the number of nodes served by the channel, 0 on
+ *                  the root
+ *
+ * For a message passing channel, these are the nodes of the subtree of the
+ * current node. The children sharing a shared memory channel all read the
+ * same messages, the channel serves the subtrees of all of them.
+ */
+void smlt_context_get_parent_ranks(struct smlt_context *ctx,
+                                   uint32_t *ret_rank, uint32_t *ret_num);
+
+/**
+ * @brief obtains the split barrier the current node has arrived at
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the request of the barrier or NULL
+ *
+ * Set by smlt_barrier_arrive() and cleared by smlt_barrier_depart().
+ */
+struct smlt_request *smlt_context_get_barrier_request(struct smlt_context *ctx);
+
+/**
+ * @brief records the split barrier the current node has arrived at
+ *
+ * @param ctx   Smelt context
+ * @param req   the request of the barrier, NULL once the node departed
+ */
+void smlt_context_set_barrier_request(struct smlt_context *ctx,
+                                      struct smlt_request *req);
 
 
 /*
@@ -68,6 +68,14 @@ enum smlt_err_code {
     /* send erros */
     SMLT_ERR_SEND,
     SMLT_ERR_NOTIFY,
+
+    /* message errors */
+    SMLT_ERR_MSG_TRUNCATED,
+    SMLT_ERR_MSG_FRAGMENTED,
+
+    /* cache errors */
+    SMLT_ERR_CACHE_PATH,
+    SMLT_ERR_CACHE_MISS,
     SMLT_ERR
 };
 
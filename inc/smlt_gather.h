@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_GATHER_H_
+#define SMLT_GATHER_H_ 1
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/*
+ * ===========================================================================
+ * Smelt gather
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief collects a block of each node at the root
+ *
+ * @param ctx       The smelt context
+ * @param input     the block of this node
+ * @param result    returns the blocks of all nodes on the root
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * All nodes contribute the same number of words. The root receives the
+ * blocks concatenated in the order of smlt_context_get_rank(), its result
+ * has to hold smlt_context_get_num_nodes() blocks. Every other node
+ * collects the blocks of its subtree and forwards them to its parent as
+ * one message, the result is not used and may be NULL.
+ */
+errval_t smlt_gather(struct smlt_context *ctx,
+                     struct smlt_msg *input,
+                     struct smlt_msg *result);
+
+/**
+ * @brief collects a block of each node and distributes them to all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     the block of this node
+ * @param result    returns the blocks of all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * Like smlt_gather(), followed by a pipelined broadcast of the blocks. The
+ * result has to hold smlt_context_get_num_nodes() blocks on all nodes.
+ */
+errval_t smlt_allgather(struct smlt_context *ctx,
+                        struct smlt_msg *input,
+                        struct smlt_msg *result);
+
+#endif /* SMLT_GATHER_H_ */
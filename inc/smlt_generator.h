@@ -10,6 +10,8 @@
 #ifndef SMLT_GENERATOR_H_
 #define SMLT_GENERATOR_H_ 1
 
+/* forward declaration */
+struct smlt_sparse_model;
 
 struct smlt_generated_model {
     // number of cores participating
@@ -24,19 +26,61 @@ struct smlt_generated_model {
 };
 
 /**
- * @brief generates a model using the simulator
+ * built-in tree shapes, the cores are grouped by NUMA node before the tree
+ * is built, starting with the NUMA node of the root followed by the others
+ * in the order of their distance to it
+ */
+typedef enum {
+    SMLT_GENERATOR_SEQUENTIAL = 0,  ///< the root sends to all cores
+    SMLT_GENERATOR_KARY,            ///< every core sends to up to fanout cores
+    SMLT_GENERATOR_BINOMIAL,        ///< binomial tree, the largest subtree first
+    SMLT_GENERATOR_CLUSTER,         ///< the root sends to the first core of
+                                    ///< each NUMA node, which sends to the
+                                    ///< rest of its NUMA node
+    SMLT_GENERATOR_ADAPTIVE,        ///< binomial tree between the NUMA nodes
+                                    ///< and within each of them
+} smlt_generator_shape_t;
+
+/**
+ * @brief obtains the sparse model of a topology
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        returns the sparse model
+ *
+ * @return              SMLT_SUCCESS if there was no parser/connection
+ *                      error otherwise SMLT_ERR_GENERATOR
+ *
+ * Unless cores is NULL or $SMLT_MODEL_CACHE is 0, the model is looked up in
+ * the model cache first (see smlt_model_cache.h). On a miss, the simulator
+ * is contacted if $SMLT_HOSTNAME is set. Otherwise, or if the simulator
+ * fails, the model is built by smlt_generate_tree_sparse_model() for the
+ * names known to smlt_generator_shape_by_name(). A generated model is
+ * stored to the cache. Only the simulator produces a topology matrix.
+ *
+ * The model is freed with smlt_platform_free() and can be passed to
+ * smlt_topology_create_sparse().
+ */
+errval_t smlt_generate_sparse_model(coreid_t* cores, uint32_t len,
+                                    const char* name,
+                                    struct smlt_sparse_model** sparse);
+
+/**
+ * @brief obtains the model of a topology
  *
  * @param cores         an arry of cores that contains the
  *                      cores of the model
  * @param len           length of the cores array
- * @param name          name of the tree topology generated by the
- *                      simulator
- * @param model         result pointer to array of the encoded model
- * @param leafs         result pointer to array of leaf nodes
- * @param last_node     result pointer to last_node
+ * @param name          name of the tree topology
+ * @param model         returns the encoded model (model itself, leafs, root)
  *
  * @return              SMLT_SUCCESS if there was no parser/connection
  *                      error otherwise SMLT_ERR_GENERATOR
+ *
+ * The model is obtained by smlt_generate_sparse_model() and expanded into
+ * the len * len topology matrix.
  */
 errval_t smlt_generate_model(coreid_t* cores,
                          uint32_t len,
@@ -52,10 +96,127 @@ errval_t smlt_generate_model(coreid_t* cores,
  *
  * @return              SMLT_SUCCESS if there was no parser error otherwise
  *                      SMLT_ERR_GENERATOR
+ *
+ * The file is mapped and parsed by smlt_generate_model_from_json().
  */
 errval_t smlt_generate_modal_from_file(char* filepath, uint32_t ncores,
                                    struct smlt_generated_model** model);
 
+/**
+ * @brief generates a model from a json string
+ *
+ * @param json          the json string, it does not need to be terminated
+ * @param size          length of the json string
+ * @param ncores        number of cores in model
+ * @param model         (return value) in struct encoded model
+ *                      (last_node, leafs, model)
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_GENERATOR if the string is not
+ *                      a valid model or SMLT_ERR_MALLOC_FAIL
+ *
+ * The parser only knows the keys "root", "leaf_nodes" and "model" and skips
+ * all others. It does not build a document tree: a first pass over the
+ * string sizes the leafs and the matrix, a second one fills them in place.
+ * The matrix has to be square and its entries at most UINT16_MAX.
+ */
+errval_t smlt_generate_model_from_json(const char *json, size_t size,
+                                       uint32_t ncores,
+                                       struct smlt_generated_model** model);
+
+/**
+ * @brief obtains the tree shape of a topology name
+ *
+ * @param name          name of the tree topology, NULL for $SMLT_TOPO
+ *                      or "adaptivetree"
+ * @param shape         returns the shape
+ * @param fanout        returns the fanout of the k-ary tree
+ *
+ * @return              SMLT_SUCCESS or SMLT_ERR_INVAL if there is no
+ *                      built-in shape for the name
+ *
+ * The names are "sequential", "bintree" and "binary_tree" (fanout 2),
+ * "kary-<fanout>", "binomial" and "mst", "cluster" and the names starting
+ * with "adaptivetree".
+ */
+errval_t smlt_generator_shape_by_name(const char *name,
+                                      smlt_generator_shape_t *shape,
+                                      uint32_t *fanout);
+
+/**
+ * @brief generates a sparse message passing model without the simulator
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, NULL for the first len cores
+ *                      the process may run on
+ * @param len           length of the cores array
+ * @param shape         the shape of the tree
+ * @param fanout        the fanout of SMLT_GENERATOR_KARY
+ * @param sparse        returns the sparse model
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_INVAL if a core is out of
+ *                      range or a core has too many children,
+ *                      SMLT_ERR_MALLOC_FAIL or SMLT_ERR_PLATFORM_INIT
+ *
+ * The first core is the root. The tree is built from the NUMA distances of
+ * the platform, no measurements are needed. The model has a node for each
+ * of the smlt_get_num_proc() cores and takes O(len) time and space.
+ */
+errval_t smlt_generate_tree_sparse_model(coreid_t* cores, uint32_t len,
+                                         smlt_generator_shape_t shape,
+                                         uint32_t fanout,
+                                         struct smlt_sparse_model** sparse);
+
+/**
+ * @brief generates a message passing model without the simulator
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, NULL for the first len cores
+ *                      the process may run on
+ * @param len           length of the cores array
+ * @param shape         the shape of the tree
+ * @param fanout        the fanout of SMLT_GENERATOR_KARY
+ * @param model         (return value) in struct encoded model
+ *                      (last_node, leafs, model)
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_INVAL if a core is out of
+ *                      range or a core has too many children,
+ *                      SMLT_ERR_MALLOC_FAIL or SMLT_ERR_PLATFORM_INIT
+ *
+ * The model of smlt_generate_tree_sparse_model() expanded into the topology
+ * matrix.
+ */
+errval_t smlt_generate_tree_model(coreid_t* cores, uint32_t len,
+                                  smlt_generator_shape_t shape,
+                                  uint32_t fanout,
+                                  struct smlt_generated_model** model);
+
+/**
+ * the maximum number of cores sharing one shared memory channel in a model
+ * generated by smlt_generate_hybrid_model(), larger NUMA nodes are split
+ */
+#define SMLT_GENERATOR_ISLAND_MAX_CORES 8
+
+/**
+ * @brief generates a hybrid model of message passing and shared memory
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param model         (return value) in struct encoded model
+ *                      (last_node, leafs, model)
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_INVAL if a core is out of
+ *                      range or SMLT_ERR_MALLOC_FAIL
+ *
+ * The cores are grouped into islands by their NUMA node, in the order of the
+ * cores array. The first core of an island is its head and broadcasts to
+ * the other cores of the island over one shared memory channel. The heads
+ * are connected by a binary tree of message passing channels rooted at the
+ * head of the first island.
+ */
+errval_t smlt_generate_hybrid_model(coreid_t* cores, uint32_t len,
+                                    struct smlt_generated_model** model);
+
 /**
  * @brief update measurements on the generator
  *        i.e. make new measurements and send them to
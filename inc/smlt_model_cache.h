@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_MODEL_CACHE_H_
+#define SMLT_MODEL_CACHE_H_ 1
+
+/* forward declaration */
+struct smlt_generated_model;
+struct smlt_sparse_model;
+
+/*
+ * ===========================================================================
+ * Generated model cache
+ * ===========================================================================
+ */
+
+/// prefix of the model files in the cache directory
+#define SMLT_MODEL_CACHE_FILE "model-"
+
+/// identifies a model file, "SMLM"
+#define SMLT_MODEL_CACHE_MAGIC 0x4d4c4d53
+
+/// version of the model file format
+#define SMLT_MODEL_CACHE_VERSION 2
+
+/**
+ * the header of a model file, followed by the cores (uint32_t) and the
+ * model serialized by smlt_sparse_model_serialize()
+ */
+struct smlt_model_cache_header
+{
+    uint32_t magic;             ///< SMLT_MODEL_CACHE_MAGIC
+    uint32_t version;           ///< SMLT_MODEL_CACHE_VERSION
+    uint64_t fingerprint;       ///< the key of the model
+    uint32_t ncores;            ///< number of cores of the model
+    uint32_t reserved;          ///< zero
+};
+
+/**
+ * @brief checks whether the model cache is enabled
+ *
+ * @returns FALSE if SMLT_MODEL_CACHE is set to 0
+ */
+bool smlt_model_cache_enabled(void);
+
+/**
+ * @brief computes the key of a model
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ *
+ * @returns the fingerprint of the machine, the cores and the name
+ *
+ * The fingerprint covers the processor model, the NUMA node of every core,
+ * the NUMA distances, the number of nodes of the model, the simulator in use
+ * ($SMLT_HOSTNAME), the cores in their order and the topology name.
+ */
+uint64_t smlt_model_cache_fingerprint(coreid_t *cores, uint32_t len,
+                                      const char *name);
+
+/**
+ * @brief looks up a sparse model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        returns the cached model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_CACHE_MISS, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ *
+ * The model file is mapped read-only and validated, the nodes are copied
+ * into the returned model, which is freed with smlt_platform_free().
+ */
+errval_t smlt_model_cache_lookup_sparse(coreid_t *cores, uint32_t len,
+                                        const char *name,
+                                        struct smlt_sparse_model **sparse);
+
+/**
+ * @brief looks up a generated model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param model         returns the cached model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_CACHE_MISS, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ *
+ * The sparse model of the file is expanded into the topology matrix.
+ */
+errval_t smlt_model_cache_lookup(coreid_t *cores, uint32_t len,
+                                 const char *name,
+                                 struct smlt_generated_model **model);
+
+/**
+ * @brief stores a sparse model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        the model to store
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ *
+ * The file is written under a temporary name and renamed, concurrent
+ * processes never see a partial model.
+ */
+errval_t smlt_model_cache_store_sparse(coreid_t *cores, uint32_t len,
+                                       const char *name,
+                                       struct smlt_sparse_model *sparse);
+
+/**
+ * @brief stores a generated model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param model         the model to store
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ *
+ * The matrix is converted with smlt_sparse_model_from_model() and stored
+ * like smlt_model_cache_store_sparse() does.
+ */
+errval_t smlt_model_cache_store(coreid_t *cores, uint32_t len,
+                                const char *name,
+                                struct smlt_generated_model *model);
+
+#endif /* SMLT_MODEL_CACHE_H_ */
@@ -281,6 +281,28 @@ uint8_t smlt_platform_cluster_of_core(coreid_t core_id);
  */
 uint32_t smlt_platform_num_clusters(void);
 
+/**
+ * @brief returns the distance between two clusters
+ *
+ * @param from          the id of the first NUMA node
+ * @param to            the id of the second NUMA node
+ *
+ * @return the relative distance, 10 within a NUMA node
+ */
+uint32_t smlt_platform_cluster_distance(uint8_t from, uint8_t to);
+
+/**
+ * @brief obtains the cores the process is allowed to run on
+ *
+ * @param cores         array to store the core ids in
+ * @param num           the length of the array, returns the number of cores
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PLATFORM_INIT
+ *
+ * The cores are returned in ascending order, at most num of them.
+ */
+errval_t smlt_platform_get_affinity(coreid_t *cores, uint32_t *num);
+
 /**
  * @brief  obtains the number of cores in the system
  *
@@ -288,6 +310,16 @@ uint32_t smlt_platform_num_clusters(void);
  */
 uint32_t smlt_platform_num_cores(void);
 
+/**
+ * @brief obtains the name of the processor model
+ *
+ * @param buf           buffer to store the name in
+ * @param len           length of the buffer
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PLATFORM_INIT if the name is unknown
+ */
+errval_t smlt_platform_cpu_model(char *buf, size_t len);
+
 /**
  * @brief  obtains the number of cores on a cluster
  *
@@ -297,4 +329,26 @@ uint32_t smlt_platform_num_cores(void);
  */
 uint32_t smlt_platform_num_cores_of_cluster(uint8_t cluster_id);
 
+
+/*
+ * ===========================================================================
+ * Persistent cache
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the path of a file in the machine specific cache directory
+ *
+ * @param name  name of the cache file
+ * @param path  buffer to store the path in
+ * @param len   length of the buffer
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_CACHE_PATH
+ *
+ * The directory is $SMLT_CACHE_DIR, $XDG_CACHE_HOME/smelt or
+ * $HOME/.cache/smelt, followed by the machine name ($SMLT_MACHINE or the
+ * hostname). Missing directories are created.
+ */
+errval_t smlt_platform_cache_path(const char *name, char *path, size_t len);
+
 #endif /* SMLT_PLATFORM_H_ */
@@ -68,6 +68,47 @@ typedef errval_t (*smlt_qp_notify_fn_t)(struct smlt_qp *qp);
  */
 typedef bool (*smlt_qp_check_fn_t)(struct smlt_qp *qp);
 
+/**
+ * @brief type definition for the BORROW function of the queuepair.
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload in the queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns error value
+ */
+typedef errval_t (*smlt_qp_borrow_fn_t)(struct smlt_qp *qp,
+                                        const smlt_msg_payload_t **data,
+                                        uint32_t *words);
+
+/**
+ * @brief type definition for the PREPARE function of the queuepair.
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload of the next queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns error value
+ */
+typedef errval_t (*smlt_qp_prepare_fn_t)(struct smlt_qp *qp,
+                                         smlt_msg_payload_t **data,
+                                         uint32_t *words);
+
+/**
+ * @brief type definition for the BATCH function of the queuepair.
+ *
+ * @param qp      the Smelt queuepair to call the operation on
+ * @param msgs    array of Smelt messages
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages processed
+ *
+ * @returns error value
+ */
+typedef errval_t (*smlt_qp_batch_fn_t)(struct smlt_qp *qp,
+                                       struct smlt_msg **msgs,
+                                       uint32_t num,
+                                       uint32_t *ret_num);
+
 /**
  * represents a Smelt queuepair
  */
@@ -95,11 +136,17 @@ struct smlt_qp
             smlt_qp_op_fn_t try_send;           ///< send operation
             smlt_qp_notify_fn_t notify;
             smlt_qp_check_fn_t can_send;    ///< checks if can be send
+            smlt_qp_prepare_fn_t prepare;   ///< obtains the next message slot
+            smlt_qp_notify_fn_t commit;     ///< sends the prepared slot
+            smlt_qp_batch_fn_t batch;       ///< sends several messages
         } send;
         struct {
             smlt_qp_op_fn_t try_recv;           ///< recv operation
             smlt_qp_notify_fn_t notify; // TODO change name
             smlt_qp_check_fn_t can_recv;    ///< checksi if can be received
+            smlt_qp_borrow_fn_t borrow;     ///< lends the next message slot
+            smlt_qp_notify_fn_t release;    ///< releases the lent slot
+            smlt_qp_batch_fn_t batch;       ///< receives several messages
         } recv;
     } f;
     /* type specific queue pair */
@@ -125,12 +172,39 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
                                coreid_t src,
                                coreid_t dst);
 
+/**
+ * @brief creates the queue pair with the given number of slots
+ *
+ * @param type      the backend of the queuepair
+ * @param qp_src    returns the end of the source core
+ * @param qp_dst    returns the end of the destination core
+ * @param src       the source core
+ * @param dst       the destination core
+ * @param num_slots number of slots in each direction, 0 for the default
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the number of slots is not
+ *          supported by the backend, or error value
+ *
+ * UMP takes between 2 and SMLT_UMP_MAX_SLOTS slots, FFQ between 2 and
+ * SMLT_FFQ_MAX_SLOTS. The shared memory queuepair has a fixed size and
+ * ignores the argument.
+ */
+errval_t smlt_queuepair_create_sized(smlt_qp_type_t type,
+                                     struct smlt_qp **qp_src,
+                                     struct smlt_qp **qp_dst,
+                                     coreid_t src,
+                                     coreid_t dst,
+                                     uint32_t num_slots);
+
  /**
-  * @brief destroys the queuepair
+  * @brief destroys one end of the queuepair
   *
-  * @param
+  * @param qp   the end to destroy
   *
-  * @returns 0
+  * Each end frees the buffer it receives on, both ends of a queuepair have
+  * to be destroyed to release all of its memory.
+  *
+  * @returns SMLT_SUCCESS or error value
   */
 errval_t smlt_queuepair_destroy(struct smlt_qp *qp);
 
@@ -207,6 +281,116 @@ static inline bool smlt_queuepair_can_send(struct smlt_qp *qp)
     return qp->f.send.can_send(qp);
 }
 
+/**
+ * @brief obtains the payload of the next message slot to write into
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload of the queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns SMLT_SUCCESS if the slot can be written
+ *          SMLT_ERR_QUEUE_FULL if there is no free slot
+ *
+ * The message is sent by smlt_queuepair_send_commit(). No other message must
+ * be sent on the queuepair in between.
+ */
+static inline errval_t smlt_queuepair_try_send_prepare(struct smlt_qp *qp,
+                                                       smlt_msg_payload_t **data,
+                                                       uint32_t *words)
+{
+    return qp->f.send.prepare(qp, data, words);
+}
+
+/**
+ * @brief obtains the payload of the next message slot to write into
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload of the queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns error value
+ *
+ * This function is BLOCKING if the queuepair cannot take new messages
+ */
+static inline errval_t smlt_queuepair_send_prepare(struct smlt_qp *qp,
+                                                   smlt_msg_payload_t **data,
+                                                   uint32_t *words)
+{
+    errval_t err;
+    do {
+        err = smlt_queuepair_try_send_prepare(qp, data, words);
+    } while(err == SMLT_ERR_QUEUE_FULL);
+
+    return err;
+}
+
+/**
+ * @brief sends the message slot obtained by smlt_queuepair_send_prepare()
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ *
+ * @returns error value
+ */
+static inline errval_t smlt_queuepair_send_commit(struct smlt_qp *qp)
+{
+    return qp->f.send.commit(qp);
+}
+
+/**
+ * @brief sends a batch of messages on the queuepair
+ *
+ * @param qp      the Smelt queuepair to call the operation on
+ * @param msgs    array of Smelt messages to send
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages sent
+ *
+ * @returns SMLT_SUCCESS if at least one message was sent
+ *          SMLT_ERR_QUEUE_FULL if no message could be sent
+ *
+ * The messages are sent in order. Backends that support it publish the
+ * whole batch with a single write barrier.
+ */
+static inline errval_t smlt_queuepair_try_send_batch(struct smlt_qp *qp,
+                                                     struct smlt_msg **msgs,
+                                                     uint32_t num,
+                                                     uint32_t *ret_num)
+{
+    return qp->f.send.batch(qp, msgs, num, ret_num);
+}
+
+/**
+ * @brief sends a batch of messages on the queuepair
+ *
+ * @param qp      the Smelt queuepair to call the operation on
+ * @param msgs    array of Smelt messages to send
+ * @param num     number of messages in the array
+ *
+ * @returns error value
+ *
+ * This function is BLOCKING until all messages have been sent
+ */
+static inline errval_t smlt_queuepair_send_batch(struct smlt_qp *qp,
+                                                 struct smlt_msg **msgs,
+                                                 uint32_t num)
+{
+    errval_t err;
+    uint32_t sent;
+
+    while (num > 0) {
+        err = smlt_queuepair_try_send_batch(qp, msgs, num, &sent);
+        if (err == SMLT_ERR_QUEUE_FULL) {
+            continue;
+        }
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+        msgs += sent;
+        num -= sent;
+    }
+
+    return SMLT_SUCCESS;
+}
+
 /* TODO: include also non blocking variants ? */
 
 /*
@@ -252,6 +436,53 @@ static inline errval_t smlt_queuepair_recv(struct smlt_qp *qp,
     return err;
 }
 
+/**
+ * @brief receives a batch of messages from the queuepair
+ *
+ * @param qp      the Smelt queuepair to call the operation on
+ * @param msgs    array of Smelt messages to receive in
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages received
+ *
+ * @returns SMLT_SUCCESS if at least one message was received
+ *          SMLT_ERR_QUEUE_EMPTY if there was no message
+ *
+ * Receives all messages that are ready, up to num, without waiting for
+ * more. Backends that support it acknowledge the batch only once.
+ */
+static inline errval_t smlt_queuepair_try_recv_batch(struct smlt_qp *qp,
+                                                     struct smlt_msg **msgs,
+                                                     uint32_t num,
+                                                     uint32_t *ret_num)
+{
+    return qp->f.recv.batch(qp, msgs, num, ret_num);
+}
+
+/**
+ * @brief receives a batch of messages from the queuepair
+ *
+ * @param qp      the Smelt queuepair to call the operation on
+ * @param msgs    array of Smelt messages to receive in
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages received
+ *
+ * @returns error value
+ *
+ * this function is BLOCKING until at least one message has been received
+ */
+static inline errval_t smlt_queuepair_recv_batch(struct smlt_qp *qp,
+                                                 struct smlt_msg **msgs,
+                                                 uint32_t num,
+                                                 uint32_t *ret_num)
+{
+    errval_t err;
+    do {
+        err = smlt_queuepair_try_recv_batch(qp, msgs, num, ret_num);
+    } while(err == SMLT_ERR_QUEUE_EMPTY);
+
+    return err;
+}
+
 /**
  * @brief receives a notification from the queuepair
  *
@@ -281,6 +512,62 @@ static inline bool smlt_queuepair_can_recv(struct smlt_qp *qp)
     return qp->f.recv.can_recv(qp);
 }
 
+/**
+ * @brief lends the next message slot of the queuepair to the caller
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload in the queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns SMLT_SUCCESS if a slot is lent
+ *          SMLT_ERR_QUEUE_EMPTY if there is no message
+ *          SMLT_ERR_MSG_FRAGMENTED if the message spans several slots
+ *
+ * The slot is not acknowledged until smlt_queuepair_recv_release() is
+ * called, the payload must not be accessed afterwards.
+ */
+static inline errval_t smlt_queuepair_try_recv_borrow(struct smlt_qp *qp,
+                                                      const smlt_msg_payload_t **data,
+                                                      uint32_t *words)
+{
+    return qp->f.recv.borrow(qp, data, words);
+}
+
+/**
+ * @brief lends the next message slot of the queuepair to the caller
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ * @param data  returns a pointer to the payload in the queue slot
+ * @param words returns the number of payload words of the slot
+ *
+ * @returns error value
+ *
+ * this function is BLOCKING if there is no message on the queuepair
+ */
+static inline errval_t smlt_queuepair_recv_borrow(struct smlt_qp *qp,
+                                                  const smlt_msg_payload_t **data,
+                                                  uint32_t *words)
+{
+    errval_t err;
+    do {
+        err = smlt_queuepair_try_recv_borrow(qp, data, words);
+    } while(err == SMLT_ERR_QUEUE_EMPTY);
+
+    return err;
+}
+
+/**
+ * @brief releases the message slot lent by smlt_queuepair_recv_borrow()
+ *
+ * @param qp    the Smelt queuepair to call the operation on
+ *
+ * @returns error value
+ */
+static inline errval_t smlt_queuepair_recv_release(struct smlt_qp *qp)
+{
+    return qp->f.recv.release(qp);
+}
+
 
 /*
  * ===========================================================================
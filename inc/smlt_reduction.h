@@ -12,6 +12,7 @@
 /* forward declaration */
 struct smlt_context;
 struct smlt_msg;
+struct smlt_request;
 
 /**
  * @brief operation to be called when performing the aggregate
@@ -22,6 +23,32 @@ struct smlt_msg;
  */
 typedef errval_t (*smlt_reduce_fn_t)(struct smlt_msg *dest, struct smlt_msg *src);
 
+/**
+ * builtin reduction operations
+ */
+typedef enum {
+    SMLT_REDUCE_OP_SUM = 0,  ///< element wise sum
+    SMLT_REDUCE_OP_MIN,      ///< element wise minimum
+    SMLT_REDUCE_OP_MAX,      ///< element wise maximum
+    SMLT_REDUCE_OP_BAND,     ///< bitwise and, integer types only
+    SMLT_REDUCE_OP_BOR,      ///< bitwise or, integer types only
+    SMLT_REDUCE_OP_BXOR,     ///< bitwise xor, integer types only
+    SMLT_REDUCE_OP_NUM
+} smlt_reduce_op_t;
+
+/**
+ * type of the elements the message payload is interpreted as
+ */
+typedef enum {
+    SMLT_REDUCE_DTYPE_U32 = 0,
+    SMLT_REDUCE_DTYPE_U64,
+    SMLT_REDUCE_DTYPE_I64,
+    SMLT_REDUCE_DTYPE_F32,
+    SMLT_REDUCE_DTYPE_F64,
+    SMLT_REDUCE_DTYPE_NUM
+} smlt_reduce_dtype_t;
+
+
 
 /**
  * @brief performs a reduction on the current instance
@@ -73,6 +100,219 @@ errval_t smlt_reduce_all(struct smlt_context *ctx,
                          smlt_reduce_fn_t operation);
 
 
+/*
+ * ===========================================================================
+ * Builtin operations
+ * ===========================================================================
+ */
+
+/**
+ * @brief checks whether the operation is defined for the data type
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns TRUE if the operation can be applied to the data type
+ */
+bool smlt_reduce_op_is_valid(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief combines the elements of two messages using a builtin operation
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param dest      the first operand, returns the result
+ * @param src       the second operand
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ *
+ * The payload of both messages is an array of elements of the given type.
+ * The messages must have the same number of words and must not share
+ * their buffer. A trailing 32-bit element of an odd sized message is
+ * part of the last word. The kernels use AVX-512 or AVX2 if the CPU
+ * supports them.
+ */
+errval_t smlt_reduce_op_apply(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype,
+                              struct smlt_msg *dest, struct smlt_msg *src);
+
+/**
+ * @brief initializes the result with the input of this node
+ *
+ * @param input     input for the reduction
+ * @param result    returns a copy of the input, may be the input itself
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the result buffer is too small
+ */
+errval_t smlt_reduce_copy_input(struct smlt_msg *input,
+                                struct smlt_msg *result);
+
+/**
+ * @brief fills the message with the identity element of the operation
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param msg       the message to fill, msg->words words are written
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ *
+ * The identity is 0 for the sum, or and xor, all bits set for the and, the
+ * largest value of the type for the minimum and the smallest value for the
+ * maximum. Infinities are used for the floating point types.
+ */
+errval_t smlt_reduce_op_identity(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype,
+                                 struct smlt_msg *msg);
+
+/**
+ * @brief performs a reduction using a builtin operation
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * The result is only complete on the root of the tree. input and result
+ * may be the same message. All nodes must pass the same number of words.
+ */
+errval_t smlt_reduce_builtin(struct smlt_context *ctx,
+                             struct smlt_msg *input,
+                             struct smlt_msg *result,
+                             smlt_reduce_op_t op,
+                             smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief performs a reduction using a builtin operation, streaming the
+ *        message up the tree in chunks
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * The message is split into chunks of SMLT_MSG_CHUNK_WORDS words. A node
+ * forwards chunk k to its parent as soon as it has combined chunk k of all
+ * its children, while the children already work on the next chunks. The
+ * latency of large reductions is thus proportional to the depth of the tree
+ * plus the number of chunks rather than their product. All nodes must pass
+ * the same number of words.
+ */
+errval_t smlt_reduce_pipelined(struct smlt_context *ctx,
+                               struct smlt_msg *input,
+                               struct smlt_msg *result,
+                               smlt_reduce_op_t op,
+                               smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief performs a pipelined reduction of the subtree rooted at the
+ *        calling node
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction of the subtree
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * Like smlt_reduce_pipelined(), except that the calling node does not send
+ * the result to its parent. The other nodes of the subtree call
+ * smlt_reduce_pipelined().
+ */
+errval_t smlt_reduce_pipelined_subtree(struct smlt_context *ctx,
+                                       struct smlt_msg *input,
+                                       struct smlt_msg *result,
+                                       smlt_reduce_op_t op,
+                                       smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief performs a reduction using a builtin operation and distributes the
+ *        result to all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_all_builtin(struct smlt_context *ctx,
+                                 struct smlt_msg *input,
+                                 struct smlt_msg *result,
+                                 smlt_reduce_op_t op,
+                                 smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief performs a pipelined reduction using a builtin operation and
+ *        distributes the result to all nodes with a pipelined broadcast
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * See smlt_reduce_pipelined() and smlt_broadcast_pipelined().
+ */
+errval_t smlt_reduce_all_pipelined(struct smlt_context *ctx,
+                                   struct smlt_msg *input,
+                                   struct smlt_msg *result,
+                                   smlt_reduce_op_t op,
+                                   smlt_reduce_dtype_t dtype);
+
+
+/*
+ * ===========================================================================
+ * Non-blocking reduction
+ * ===========================================================================
+ */
+
+/**
+ * @brief starts a reduction using a builtin operation without waiting for it
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param req       returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ *
+ * Like smlt_reduce_builtin(), the result is only complete on the root once
+ * the request is completed, and must not be touched before. The input is
+ * copied into the result right away. The messages of the children are
+ * combined while the node calls smlt_progress(), smlt_test() or smlt_wait().
+ */
+errval_t smlt_ireduce(struct smlt_context *ctx,
+                      struct smlt_msg *input,
+                      struct smlt_msg *result,
+                      smlt_reduce_op_t op,
+                      smlt_reduce_dtype_t dtype,
+                      struct smlt_request **req);
+
+/**
+ * @brief advances a non-blocking reduction
+ *
+ * @param req   the request of the reduction
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Combines the messages of the children into the result of the request in
+ * the order of the children, as far as they have arrived. Once all are
+ * combined, sends the result to the parent and marks the request as done. A
+ * result of NULL reduces notifications.
+ */
+errval_t smlt_reduce_progress(struct smlt_request *req);
+
+
 //uintptr_t sync_reduce(uintptr_t);
 //uintptr_t sync_reduce0(uintptr_t);
 
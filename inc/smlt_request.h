@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_REQUEST_H_
+#define SMLT_REQUEST_H_ 1
+
+#include <smlt_reduction.h>
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+struct smlt_request;
+
+/**
+ * advances a non-blocking operation as far as possible without blocking,
+ * sets done once the operation is completed
+ */
+typedef errval_t (*smlt_request_fn_t)(struct smlt_request *req);
+
+/*
+ * ===========================================================================
+ * Smelt request type declarations
+ * ===========================================================================
+ */
+
+/**
+ * the state of a non-blocking operation
+ */
+struct smlt_request
+{
+    struct smlt_request *next;      ///< next pending request of the node
+    struct smlt_context *ctx;       ///< the context of the operation
+    smlt_request_fn_t progress;     ///< advances the operation
+    uint32_t state;                 ///< the phase of the operation
+    uint32_t pos;                   ///< the progress within the phase
+    struct smlt_msg *msg;           ///< the message of the operation
+    struct smlt_msg *result;        ///< the result of a reduction
+    smlt_reduce_op_t op;            ///< the reduction operation
+    smlt_reduce_dtype_t dtype;      ///< the type of the elements
+    bool done;                      ///< the operation is completed
+    errval_t err;                   ///< the outcome of the operation
+};
+
+
+/*
+ * ===========================================================================
+ * Smelt requests
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief advances the pending requests of the calling node
+ *
+ * @returns SMLT_SUCCESS or the error value of a failed request
+ *
+ * The requests of a node are advanced in the order they were started, a
+ * request only makes progress once all earlier ones are completed. All nodes
+ * of a context have to start their non-blocking operations on it in the
+ * same order, and must not start a blocking operation on it while requests
+ * are pending. The function does not block, except for sends waiting on a
+ * full queue.
+ */
+errval_t smlt_progress(void);
+
+/**
+ * @brief checks whether a request is completed
+ *
+ * @param req       the request
+ * @param done      returns true if the request is completed
+ *
+ * @returns SMLT_SUCCESS or the error value of the operation
+ *
+ * Advances the pending requests first. Once the request is completed, it is
+ * released and must not be used anymore.
+ */
+errval_t smlt_test(struct smlt_request *req, bool *done);
+
+/**
+ * @brief waits until a request is completed
+ *
+ * @param req       the request
+ *
+ * @returns SMLT_SUCCESS or the error value of the operation
+ *
+ * The request is released and must not be used anymore.
+ */
+errval_t smlt_wait(struct smlt_request *req);
+
+
+/*
+ * ===========================================================================
+ * Smelt requests: lower level functions
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief starts a non-blocking operation on the calling node
+ *
+ * @param ctx       the context of the operation
+ * @param progress  the function advancing the operation
+ * @param req       returns the request, its state is cleared
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ *
+ * The request is appended to the pending requests of the node. The caller
+ * fills in the arguments of the operation and calls smlt_progress() to get
+ * it going.
+ */
+errval_t smlt_request_start(struct smlt_context *ctx,
+                            smlt_request_fn_t progress,
+                            struct smlt_request **req);
+
+#endif /* SMLT_REQUEST_H_ */
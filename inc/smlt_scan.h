@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_SCAN_H_
+#define SMLT_SCAN_H_ 1
+
+#include <smlt_reduction.h>
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/*
+ * ===========================================================================
+ * Smelt prefix reductions
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief computes the inclusive prefix reduction in the order of the ranks
+ *
+ * @param ctx       The smelt context
+ * @param input     the contribution of this node
+ * @param result    returns the reduction of the nodes up to this one
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * The node with rank r receives the reduction of the inputs of the ranks
+ * 0 to r, see smlt_context_get_rank(). All nodes contribute the same number
+ * of words. The partial results of the subtrees are sent up the tree, then
+ * each node receives the reduction of all ranks before it from its parent.
+ */
+errval_t smlt_scan(struct smlt_context *ctx,
+                   struct smlt_msg *input,
+                   struct smlt_msg *result,
+                   smlt_reduce_op_t op,
+                   smlt_reduce_dtype_t dtype);
+
+/**
+ * @brief computes the exclusive prefix reduction in the order of the ranks
+ *
+ * @param ctx       The smelt context
+ * @param input     the contribution of this node
+ * @param result    returns the reduction of the nodes before this one
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * Like smlt_scan() without the contribution of the node itself. The node
+ * with rank 0 receives the identity of the operation, see
+ * smlt_reduce_op_identity().
+ */
+errval_t smlt_exscan(struct smlt_context *ctx,
+                     struct smlt_msg *input,
+                     struct smlt_msg *result,
+                     smlt_reduce_op_t op,
+                     smlt_reduce_dtype_t dtype);
+
+#endif /* SMLT_SCAN_H_ */
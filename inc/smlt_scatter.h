@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_SCATTER_H_
+#define SMLT_SCATTER_H_ 1
+
+/* forward declaration */
+struct smlt_context;
+struct smlt_msg;
+
+/*
+ * ===========================================================================
+ * Smelt scatter
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief distributes a block of the root's buffer to each node
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks of all nodes, only used on the root
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the block of this node
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * The blocks of the send buffer are in the order of smlt_context_get_rank(),
+ * it has to hold smlt_context_get_num_nodes() blocks. Each child receives
+ * only the contiguous range of blocks of its subtree, the interior nodes
+ * keep their own block and forward the rest to their children.
+ */
+errval_t smlt_scatter(struct smlt_context *ctx,
+                      struct smlt_msg *sendbuf,
+                      uint32_t block_words,
+                      struct smlt_msg *recvbuf);
+
+#endif /* SMLT_SCATTER_H_ */
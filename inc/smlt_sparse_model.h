@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#ifndef SMLT_SPARSE_MODEL_H_
+#define SMLT_SPARSE_MODEL_H_ 1
+
+/* forward declaration */
+struct smlt_generated_model;
+
+/// the node has no parent, it is the root or not part of the model
+#define SMLT_SPARSE_MODEL_NO_PARENT UINT32_MAX
+
+/// identifies a serialized sparse model, "SMLS"
+#define SMLT_SPARSE_MODEL_MAGIC 0x534c4d53
+
+/// version of the serialized format
+#define SMLT_SPARSE_MODEL_VERSION 2
+
+/// the node is listed as a leaf by the model
+#define SMLT_SPARSE_MODEL_LEAF 0x1
+
+/*
+ * ===========================================================================
+ * Smelt sparse model type declarations
+ * ===========================================================================
+ */
+
+/**
+ * a node of a sparse model, the edge to its parent
+ */
+struct smlt_sparse_model_node
+{
+    uint32_t parent;    ///< the parent or SMLT_SPARSE_MODEL_NO_PARENT
+    uint16_t edge;      ///< the entry of the parent in the topology matrix:
+                        ///< the position among the message passing children
+                        ///< (1 to TOPO_MATRIX_MAX_MP) or a shared memory
+                        ///< master (TOPO_MATRIX_SHM_MASTER_*)
+    uint16_t flags;     ///< SMLT_SPARSE_MODEL_LEAF or zero
+};
+
+/**
+ * a model stored as the parent of each node, the equivalent of the topology
+ * matrix of struct smlt_generated_model in O(len) space
+ */
+struct smlt_sparse_model
+{
+    uint32_t ncores;                        ///< number of cores participating
+    uint32_t len;                           ///< number of nodes
+    uint32_t root;                          ///< the root node
+    struct smlt_sparse_model_node *nodes;   ///< the len nodes
+};
+
+/**
+ * the header of a serialized sparse model, followed by the len nodes
+ */
+struct smlt_sparse_model_header
+{
+    uint32_t magic;     ///< SMLT_SPARSE_MODEL_MAGIC
+    uint32_t version;   ///< SMLT_SPARSE_MODEL_VERSION
+    uint32_t ncores;    ///< number of cores participating
+    uint32_t len;       ///< number of nodes
+    uint32_t root;      ///< the root node
+    uint32_t reserved;  ///< zero
+};
+
+
+/*
+ * ===========================================================================
+ * Smelt sparse models
+ * ===========================================================================
+ */
+
+
+/**
+ * @brief allocates a sparse model whose nodes have no parents
+ *
+ * @param len           number of nodes
+ *
+ * @returns the model or NULL if the allocation failed
+ *
+ * The nodes are part of the allocation, smlt_platform_free() releases both.
+ */
+struct smlt_sparse_model *smlt_sparse_model_alloc(uint32_t len);
+
+/**
+ * @brief converts a topology matrix into a sparse model
+ *
+ * @param model         the model with the topology matrix
+ * @param sparse        returns the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the matrix is malformed or
+ *          SMLT_ERR_MALLOC_FAIL
+ *
+ * The matrix is scanned once, every child entry has to be matched by a
+ * parent entry in the transposed position. The leafs of the model are
+ * flagged with SMLT_SPARSE_MODEL_LEAF.
+ */
+errval_t smlt_sparse_model_from_model(struct smlt_generated_model *model,
+                                      struct smlt_sparse_model **sparse);
+
+/**
+ * @brief expands a sparse model into a topology matrix
+ *
+ * @param sparse        the sparse model
+ * @param model         returns the model with the topology matrix
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ *
+ * This takes O(len^2) space and is only needed by users of the matrix. The
+ * leafs are the flagged nodes in the order of their id.
+ */
+errval_t smlt_sparse_model_to_model(struct smlt_sparse_model *sparse,
+                                    struct smlt_generated_model **model);
+
+/**
+ * @brief checks that the parents of the sparse model form a tree
+ *
+ * @param sparse        the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if a node with a parent does not
+ *          reach the root or SMLT_ERR_MALLOC_FAIL
+ *
+ * Nodes without a parent are not part of the model, but no node may have
+ * one of them as its parent. Every node is visited at most twice.
+ */
+errval_t smlt_sparse_model_check(struct smlt_sparse_model *sparse);
+
+/**
+ * @brief returns the size of the serialized sparse model in bytes
+ *
+ * @param sparse        the sparse model
+ *
+ * @returns the number of bytes
+ */
+size_t smlt_sparse_model_size(struct smlt_sparse_model *sparse);
+
+/**
+ * @brief serializes the sparse model into the buffer
+ *
+ * @param sparse        the sparse model
+ * @param buf           the buffer
+ * @param size          size of the buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the buffer is too small
+ */
+errval_t smlt_sparse_model_serialize(struct smlt_sparse_model *sparse,
+                                     void *buf, size_t size);
+
+/**
+ * @brief reads a serialized sparse model
+ *
+ * @param buf           the buffer, 4-byte aligned
+ * @param size          size of the buffer
+ * @param sparse        returns the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the buffer does not hold a valid
+ *          model or SMLT_ERR_MALLOC_FAIL
+ *
+ * The nodes of the returned model point into the buffer, which has to stay
+ * valid as long as the model is used. Models with parent cycles or with
+ * nodes that do not reach the root are rejected.
+ */
+errval_t smlt_sparse_model_deserialize(void *buf, size_t size,
+                                       struct smlt_sparse_model **sparse);
+
+#endif /* SMLT_SPARSE_MODEL_H_ */
@@ -21,6 +21,7 @@
 struct smlt_topology;
 struct smlt_topology_node;
 struct smlt_generated_model;
+struct smlt_sparse_model;
 
 ///< refer to the current smelt topology
 #define SMLT_TOPOLOGY_CURRENT NULL;
@@ -65,20 +66,40 @@ errval_t smlt_topology_init(void);
  * @param name          name of the topology
  * @param ret_topology  returned pointer to the topology
  *
- * @return SMELT_SUCCESS or error value
+ * @return SMELT_SUCCESS, SMLT_ERR_INVAL if the matrix is malformed or
+ *         SMLT_ERR_MALLOC_FAIL
  *
- * If the model is NULL, then a binary tree will be generated
+ * If the model is NULL, then a binary tree will be generated. The matrix is
+ * converted by smlt_sparse_model_from_model(), which takes O(len^2) time,
+ * smlt_topology_create_sparse() avoids it.
  */
 errval_t smlt_topology_create(struct smlt_generated_model* model,
                               const char *name,
                               struct smlt_topology **ret_topology);
 
+/**
+ * @brief creates a new Smelt topology out of a sparse model
+ *
+ * @param model         the sparse model
+ * @param name          name of the topology
+ * @param ret_topology  returned pointer to the topology
+ *
+ * @return SMELT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ *
+ * The topology is built in time linear in the number of nodes.
+ */
+errval_t smlt_topology_create_sparse(struct smlt_sparse_model* model,
+                                     const char *name,
+                                     struct smlt_topology **ret_topology);
+
 /**
  * @brief destroys a smelt topology.
  *
  * @param topology  the Smelt topology to destroy
  *
  * @return SMELT_SUCCESS or error vlaue
+ *
+ * Contexts created from the topology do not refer to it.
  */
 errval_t smlt_topology_destroy(struct smlt_topology *topology);
 
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_context.h>
+#include <smlt_broadcast.h>
+#include <smlt_reduction.h>
+#include <smlt_allreduce.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * Chunked transfers on the pairwise channels
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains a view of a chunk of the message
+ */
+static inline struct smlt_msg smlt_allreduce_chunk(struct smlt_msg *msg,
+                                                   uint32_t offset)
+{
+    uint32_t words = msg->words - offset;
+    if (words > SMLT_MSG_CHUNK_WORDS) {
+        words = SMLT_MSG_CHUNK_WORDS;
+    }
+
+    struct smlt_msg chunk = {
+        .words = words,
+        .bufsize = words * sizeof(smlt_msg_payload_t),
+        .data = msg->data + offset
+    };
+
+    return chunk;
+}
+
+/**
+ * @brief sends the message to the node in chunks
+ */
+static errval_t smlt_allreduce_send(smlt_nid_t nid, struct smlt_msg *msg)
+{
+    errval_t err;
+
+    for (uint32_t offset = 0; offset < msg->words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        struct smlt_msg chunk = smlt_allreduce_chunk(msg, offset);
+        err = smlt_send(nid, &chunk);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief receives the message from the node in chunks, combining them with
+ *        the message if combine is set and overwriting it otherwise
+ */
+static errval_t smlt_allreduce_recv(smlt_nid_t nid, struct smlt_msg *msg,
+                                    bool combine, smlt_reduce_op_t op,
+                                    smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    smlt_msg_payload_t buf[SMLT_MSG_CHUNK_WORDS];
+    struct smlt_msg in = {
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    for (uint32_t offset = 0; offset < msg->words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        struct smlt_msg chunk = smlt_allreduce_chunk(msg, offset);
+
+        if (!combine) {
+            err = smlt_recv(nid, &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            continue;
+        }
+
+        /* single slot messages do not carry their length */
+        in.words = chunk.words;
+        err = smlt_recv(nid, &in);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        err = smlt_reduce_op_apply(op, dtype, &chunk, &in);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief exchanges the message with the node and combines the two
+ *
+ * Both nodes send a chunk before receiving the chunk of the peer, so at most
+ * one chunk per direction is in flight.
+ */
+static errval_t smlt_allreduce_exchange(smlt_nid_t nid, struct smlt_msg *msg,
+                                        smlt_reduce_op_t op,
+                                        smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    smlt_msg_payload_t buf[SMLT_MSG_CHUNK_WORDS];
+    struct smlt_msg in = {
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    for (uint32_t offset = 0; offset < msg->words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        struct smlt_msg chunk = smlt_allreduce_chunk(msg, offset);
+
+        err = smlt_send(nid, &chunk);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        in.words = chunk.words;
+        err = smlt_recv(nid, &in);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        err = smlt_reduce_op_apply(op, dtype, &chunk, &in);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Algorithms
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the node id of a participant of the recursive doubling
+ */
+static inline smlt_nid_t smlt_allreduce_peer(struct smlt_context *ctx,
+                                             bool heads, uint32_t rank)
+{
+    if (heads) {
+        return smlt_context_get_island_head(ctx, rank);
+    }
+    return smlt_context_get_node_id(ctx, rank);
+}
+
+/**
+ * @brief performs recursive doubling among the nodes or the island heads
+ *
+ * @param ctx       The smelt context
+ * @param heads     run among the island heads instead of all nodes
+ * @param rank      the index of the calling node among the participants
+ * @param num       the number of participants
+ * @param result    the contribution of this node, returns the result
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * If the number of participants is not a power of two, the even ones of the
+ * first 2 * rem participants fold their contribution into the next one and
+ * receive the result from it at the end.
+ */
+static errval_t smlt_allreduce_rd(struct smlt_context *ctx, bool heads,
+                                  uint32_t rank, uint32_t num,
+                                  struct smlt_msg *result,
+                                  smlt_reduce_op_t op,
+                                  smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    uint32_t pof2 = 1;
+    while (pof2 * 2 <= num) {
+        pof2 *= 2;
+    }
+    uint32_t rem = num - pof2;
+
+    uint32_t newrank;
+    if (rank < 2 * rem) {
+        smlt_nid_t peer;
+        if (rank % 2 == 0) {
+            peer = smlt_allreduce_peer(ctx, heads, rank + 1);
+            err = smlt_allreduce_send(peer, result);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            return smlt_allreduce_recv(peer, result, false, op, dtype);
+        }
+
+        peer = smlt_allreduce_peer(ctx, heads, rank - 1);
+        err = smlt_allreduce_recv(peer, result, true, op, dtype);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+        newrank = rank / 2;
+    } else {
+        newrank = rank - rem;
+    }
+
+    for (uint32_t mask = 1; mask < pof2; mask <<= 1) {
+        uint32_t newpartner = newrank ^ mask;
+        uint32_t partner = (newpartner < rem) ? newpartner * 2 + 1
+                                              : newpartner + rem;
+
+        err = smlt_allreduce_exchange(smlt_allreduce_peer(ctx, heads, partner),
+                                      result, op, dtype);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    if (rank < 2 * rem) {
+        return smlt_allreduce_send(smlt_allreduce_peer(ctx, heads, rank - 1),
+                                   result);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief reduces within the shared memory islands, runs recursive doubling
+ *        among the island heads and returns the result to the members
+ */
+static errval_t smlt_allreduce_hybrid(struct smlt_context *ctx,
+                                      struct smlt_msg *input,
+                                      struct smlt_msg *result,
+                                      smlt_reduce_op_t op,
+                                      smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    err = smlt_reduce_copy_input(input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t island = smlt_context_get_island_idx(ctx);
+
+    if (island == SMLT_CONTEXT_IDX_INVALID) {
+        /* member of an island, the head does the work */
+        smlt_nid_t head = smlt_context_node_get_island_head(ctx, smlt_node_self);
+        err = smlt_allreduce_send(head, result);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        return smlt_allreduce_recv(head, result, false, op, dtype);
+    }
+
+    smlt_nid_t *members;
+    uint32_t num_members;
+    err = smlt_context_node_get_island_members(ctx, smlt_node_self, &members,
+                                               &num_members);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < num_members; i++) {
+        err = smlt_allreduce_recv(members[i], result, true, op, dtype);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    err = smlt_allreduce_rd(ctx, true, island,
+                            smlt_context_get_num_islands(ctx),
+                            result, op, dtype);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    for (uint32_t i = 0; i < num_members; i++) {
+        err = smlt_allreduce_send(members[i], result);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Smelt allreduce
+ * ===========================================================================
+ */
+
+/**
+ * @brief selects the allreduce algorithm for the context and message size
+ *
+ * @param ctx       The smelt context
+ * @param words     number of payload words of the message
+ *
+ * @returns the algorithm to use
+ */
+smlt_allreduce_algo_t smlt_allreduce_select(struct smlt_context *ctx,
+                                            uint32_t words)
+{
+    if (words > SMLT_MSG_CHUNK_WORDS) {
+        return SMLT_ALLREDUCE_TREE;
+    }
+
+    if (smlt_context_get_num_nodes(ctx) <= SMLT_ALLREDUCE_RD_MAX_NODES) {
+        return SMLT_ALLREDUCE_RECURSIVE_DOUBLING;
+    }
+
+    return SMLT_ALLREDUCE_HYBRID;
+}
+
+/**
+ * @brief reduces the input of all nodes using the given algorithm
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param algo      the algorithm, the same on all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_allreduce_with_algo(struct smlt_context *ctx,
+                                  struct smlt_msg *input,
+                                  struct smlt_msg *result,
+                                  smlt_reduce_op_t op,
+                                  smlt_reduce_dtype_t dtype,
+                                  smlt_allreduce_algo_t algo)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (algo == SMLT_ALLREDUCE_AUTO) {
+        algo = smlt_allreduce_select(ctx, input->words);
+    }
+
+    SMLT_DEBUG(SMLT_DBG__REDUCE, "allreduce: algorithm %d, %" PRIu32
+               " words\n", algo, input->words);
+
+    switch(algo) {
+        case SMLT_ALLREDUCE_TREE :
+            if (input->words <= SMLT_MSG_CHUNK_WORDS) {
+                return smlt_reduce_all_builtin(ctx, input, result, op, dtype);
+            }
+            return smlt_reduce_all_pipelined(ctx, input, result, op, dtype);
+        case SMLT_ALLREDUCE_RECURSIVE_DOUBLING :
+            err = smlt_reduce_copy_input(input, result);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            return smlt_allreduce_rd(ctx, false, smlt_context_get_idx(ctx),
+                                     smlt_context_get_num_nodes(ctx),
+                                     result, op, dtype);
+        case SMLT_ALLREDUCE_HYBRID :
+            return smlt_allreduce_hybrid(ctx, input, result, op, dtype);
+        default:
+            return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief reduces the input of all nodes and returns the result on all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_allreduce(struct smlt_context *ctx,
+                        struct smlt_msg *input,
+                        struct smlt_msg *result,
+                        smlt_reduce_op_t op,
+                        smlt_reduce_dtype_t dtype)
+{
+    return smlt_allreduce_with_algo(ctx, input, result, op, dtype,
+                                    SMLT_ALLREDUCE_AUTO);
+}
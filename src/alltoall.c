@@ -0,0 +1,599 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_context.h>
+#include <smlt_platform.h>
+#include <smlt_alltoall.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/// holds the blocks combined per NUMA node by the two-phase algorithm
+static __thread struct smlt_msg *smlt_alltoall_scratch = NULL;
+
+/**
+ * @brief returns the scratch buffer, growing it to hold at least words words
+ */
+static smlt_msg_payload_t *smlt_alltoall_get_scratch(uint32_t words)
+{
+    uint32_t bufsize = words * sizeof(smlt_msg_payload_t);
+
+    if (smlt_alltoall_scratch && smlt_alltoall_scratch->bufsize < bufsize) {
+        smlt_message_free(smlt_alltoall_scratch);
+        smlt_alltoall_scratch = NULL;
+    }
+
+    if (smlt_alltoall_scratch == NULL) {
+        smlt_alltoall_scratch = smlt_message_alloc(bufsize);
+        if (smlt_alltoall_scratch == NULL) {
+            return NULL;
+        }
+    }
+
+    return smlt_alltoall_scratch->data;
+}
+
+
+/*
+ * ===========================================================================
+ * Concurrent transfers on the pairwise channels
+ * ===========================================================================
+ */
+
+/**
+ * a transfer of a range of words to or from a node
+ */
+struct smlt_alltoall_xfer {
+    smlt_nid_t nid;                 ///< the peer node
+    smlt_msg_payload_t *data;       ///< the words to send or receive
+    uint32_t words;                 ///< the number of words
+    uint32_t pos;                   ///< the number of words transferred
+};
+
+/**
+ * @brief obtains a view of the next chunk of the transfer
+ */
+static inline struct smlt_msg smlt_alltoall_chunk(struct smlt_alltoall_xfer *x)
+{
+    uint32_t words = x->words - x->pos;
+    if (words > SMLT_MSG_CHUNK_WORDS) {
+        words = SMLT_MSG_CHUNK_WORDS;
+    }
+
+    struct smlt_msg chunk = {
+        .words = words,
+        .bufsize = words * sizeof(smlt_msg_payload_t),
+        .data = x->data + x->pos
+    };
+
+    return chunk;
+}
+
+/**
+ * @brief checks whether an earlier transfer with the same node is pending
+ *
+ * The chunks of two transfers with the same node share the channel, so they
+ * have to follow each other in the order of the array on both sides.
+ */
+static inline bool smlt_alltoall_xfer_blocked(struct smlt_alltoall_xfer *xfers,
+                                              uint32_t i)
+{
+    for (uint32_t j = 0; j < i; j++) {
+        if (xfers[j].nid == xfers[i].nid && xfers[j].pos < xfers[j].words) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief runs the transfers until all of them are completed
+ *
+ * @param sends         the transfers to send
+ * @param num_sends     the number of transfers to send
+ * @param recvs         the transfers to receive
+ * @param num_recvs     the number of transfers to receive
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * A chunk is only sent to a node that has room for it and only received from
+ * a node that has sent one, so a full channel to a slow receiver never
+ * blocks the transfers to and from the other nodes. Transfers with the same
+ * node are carried out in the order of the array.
+ */
+static errval_t smlt_alltoall_progress(struct smlt_alltoall_xfer *sends,
+                                       uint32_t num_sends,
+                                       struct smlt_alltoall_xfer *recvs,
+                                       uint32_t num_recvs)
+{
+    errval_t err;
+
+    uint32_t pending = 0;
+    for (uint32_t i = 0; i < num_sends; i++) {
+        pending += (sends[i].pos < sends[i].words);
+    }
+    for (uint32_t i = 0; i < num_recvs; i++) {
+        pending += (recvs[i].pos < recvs[i].words);
+    }
+
+    while (pending > 0) {
+        for (uint32_t i = 0; i < num_sends; i++) {
+            struct smlt_alltoall_xfer *x = &sends[i];
+            if (x->pos == x->words || smlt_alltoall_xfer_blocked(sends, i) ||
+                !smlt_can_send(x->nid)) {
+                continue;
+            }
+
+            struct smlt_msg chunk = smlt_alltoall_chunk(x);
+            err = smlt_send(x->nid, &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            x->pos += chunk.words;
+            if (x->pos == x->words) {
+                pending--;
+            }
+        }
+
+        for (uint32_t i = 0; i < num_recvs; i++) {
+            struct smlt_alltoall_xfer *x = &recvs[i];
+            if (x->pos == x->words || smlt_alltoall_xfer_blocked(recvs, i) ||
+                !smlt_can_recv(x->nid)) {
+                continue;
+            }
+
+            /* single slot messages do not carry their length */
+            struct smlt_msg chunk = smlt_alltoall_chunk(x);
+            err = smlt_recv(x->nid, &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            x->pos += chunk.words;
+            if (x->pos == x->words) {
+                pending--;
+            }
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief initializes a transfer with the node of the rank
+ */
+static inline void smlt_alltoall_xfer_init(struct smlt_alltoall_xfer *x,
+                                           struct smlt_context *ctx,
+                                           uint32_t rank,
+                                           smlt_msg_payload_t *data,
+                                           uint32_t words)
+{
+    x->nid = smlt_context_get_node_id_by_rank(ctx, rank);
+    x->data = data;
+    x->words = words;
+    x->pos = 0;
+}
+
+
+/*
+ * ===========================================================================
+ * Algorithms
+ * ===========================================================================
+ */
+
+/**
+ * @brief exchanges the blocks with all nodes at once
+ *
+ * Each node starts with the node following it in rank order, so the nodes
+ * do not all send to the same receiver first.
+ */
+static errval_t smlt_alltoall_direct(struct smlt_context *ctx,
+                                     smlt_msg_payload_t *send,
+                                     uint32_t bw,
+                                     smlt_msg_payload_t *recv)
+{
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint32_t rank = smlt_context_get_rank(ctx);
+
+    struct smlt_alltoall_xfer sends[num - 1];
+    struct smlt_alltoall_xfer recvs[num - 1];
+
+    for (uint32_t step = 1; step < num; step++) {
+        uint32_t dst = (rank + step) % num;
+        uint32_t src = (rank + num - step) % num;
+        smlt_alltoall_xfer_init(&sends[step - 1], ctx, dst, send + dst * bw,
+                                bw);
+        smlt_alltoall_xfer_init(&recvs[step - 1], ctx, src, recv + src * bw,
+                                bw);
+    }
+
+    return smlt_alltoall_progress(sends, num - 1, recvs, num - 1);
+}
+
+/**
+ * @brief exchanges the blocks in num - 1 steps
+ *
+ * In step s, the node of rank r sends to rank r + s and receives from rank
+ * r - s. Every node sends to and receives from exactly one node per step.
+ */
+static errval_t smlt_alltoall_pairwise(struct smlt_context *ctx,
+                                       smlt_msg_payload_t *send,
+                                       uint32_t bw,
+                                       smlt_msg_payload_t *recv)
+{
+    errval_t err;
+
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint32_t rank = smlt_context_get_rank(ctx);
+
+    for (uint32_t step = 1; step < num; step++) {
+        struct smlt_alltoall_xfer sx, rx;
+        uint32_t dst = (rank + step) % num;
+        uint32_t src = (rank + num - step) % num;
+        smlt_alltoall_xfer_init(&sx, ctx, dst, send + dst * bw, bw);
+        smlt_alltoall_xfer_init(&rx, ctx, src, recv + src * bw, bw);
+
+        err = smlt_alltoall_progress(&sx, 1, &rx, 1);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief groups the ranks of the context by the NUMA node of their core
+ *
+ * @param ctx       The smelt context
+ * @param group     returns the group of each rank
+ * @param idx       returns the index of each rank within its group
+ * @param size      returns the number of ranks of each group
+ * @param start     returns the offset of each group in members
+ * @param members   returns the ranks ordered by group
+ *
+ * @returns the number of groups
+ *
+ * The groups are numbered in the order of their lowest rank, all nodes
+ * compute the same grouping.
+ */
+static uint32_t smlt_alltoall_groups(struct smlt_context *ctx,
+                                     uint32_t *group, uint32_t *idx,
+                                     uint32_t *size, uint32_t *start,
+                                     uint32_t *members)
+{
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint8_t cluster[num];
+
+    uint32_t num_groups = 0;
+    for (uint32_t r = 0; r < num; r++) {
+        struct smlt_node *node;
+        node = smlt_get_node_by_id(smlt_context_get_node_id_by_rank(ctx, r));
+        uint8_t c = smlt_platform_cluster_of_core(
+                            smlt_node_get_coreid_of_node(node));
+
+        uint32_t g = 0;
+        while (g < num_groups && cluster[g] != c) {
+            g++;
+        }
+        if (g == num_groups) {
+            cluster[num_groups] = c;
+            size[num_groups++] = 0;
+        }
+
+        group[r] = g;
+        idx[r] = size[g]++;
+    }
+
+    start[0] = 0;
+    for (uint32_t g = 1; g < num_groups; g++) {
+        start[g] = start[g - 1] + size[g - 1];
+    }
+
+    for (uint32_t r = 0; r < num; r++) {
+        members[start[group[r]] + idx[r]] = r;
+    }
+
+    return num_groups;
+}
+
+/**
+ * @brief combines the blocks per NUMA node before they cross to the remote
+ *        NUMA nodes
+ *
+ * For every pair of groups a and b, member b % size(a) of group a is the
+ * proxy of a for b. In the first phase, every node exchanges its blocks
+ * directly with the members of its group and sends the blocks for every
+ * other group b, combined into one message, to the proxy of its group for b.
+ * In the second phase, the proxies send to every member of b the blocks of
+ * all members of a as one message. Only one message per pair of proxy and
+ * receiver crosses the NUMA boundary instead of one per pair of nodes.
+ */
+static errval_t smlt_alltoall_two_phase(struct smlt_context *ctx,
+                                        smlt_msg_payload_t *send,
+                                        uint32_t bw,
+                                        smlt_msg_payload_t *recv)
+{
+    errval_t err;
+
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint32_t rank = smlt_context_get_rank(ctx);
+
+    uint32_t group[num], idx[num], size[num], start[num], members[num];
+    uint32_t num_groups = smlt_alltoall_groups(ctx, group, idx, size, start,
+                                               members);
+    if (num_groups == 1) {
+        return smlt_alltoall_direct(ctx, send, bw, recv);
+    }
+
+    uint32_t a = group[rank];
+    uint32_t ma = size[a];
+
+    /* the groups this node is the proxy for and the words they need */
+    uint32_t num_proxied = 0;
+    uint32_t proxied_members = 0;
+    for (uint32_t b = 0; b < num_groups; b++) {
+        if (b != a && members[start[a] + b % ma] == rank) {
+            num_proxied++;
+            proxied_members += size[b];
+        }
+    }
+
+    /*
+     * scratch layout:
+     *   packed   the blocks of this node for each other group, by group
+     *   staged   for each proxied group b, the blocks of the members of a
+     *            for the members of b, by sender
+     *   sorted   the staged blocks by receiver
+     *   incoming the blocks from the proxies for this group, by group
+     */
+    uint32_t packed_words = (num - ma) * bw;
+    uint32_t staged_words = proxied_members * ma * bw;
+    uint32_t incoming_words = (num - ma) * bw;
+
+    smlt_msg_payload_t *packed = smlt_alltoall_get_scratch(
+                    packed_words + 2 * staged_words + incoming_words);
+    if (packed == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+    smlt_msg_payload_t *staged = packed + packed_words;
+    smlt_msg_payload_t *sorted = staged + staged_words;
+    smlt_msg_payload_t *incoming = sorted + staged_words;
+
+    /* phase 1: exchange within the group and send to the proxies */
+    uint32_t num_sends = (ma - 1) + (num_groups - 1);
+    uint32_t num_recvs = (ma - 1) + num_proxied * (ma - 1);
+    struct smlt_alltoall_xfer xfers[num_sends + num_recvs];
+    struct smlt_alltoall_xfer *sends = xfers;
+    struct smlt_alltoall_xfer *recvs = xfers + num_sends;
+
+    uint32_t s = 0, r = 0;
+    for (uint32_t i = 1; i < ma; i++) {
+        uint32_t peer = members[start[a] + (idx[rank] + i) % ma];
+        smlt_alltoall_xfer_init(&sends[s++], ctx, peer, send + peer * bw, bw);
+        smlt_alltoall_xfer_init(&recvs[r++], ctx, peer, recv + peer * bw, bw);
+    }
+
+    smlt_msg_payload_t *pack = packed;
+    smlt_msg_payload_t *stage = staged;
+    for (uint32_t b = 0; b < num_groups; b++) {
+        if (b == a) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < size[b]; j++) {
+            memcpy(pack + j * bw, send + members[start[b] + j] * bw,
+                   bw * sizeof(smlt_msg_payload_t));
+        }
+
+        uint32_t proxy = members[start[a] + b % ma];
+        uint32_t words = size[b] * bw;
+        if (proxy != rank) {
+            smlt_alltoall_xfer_init(&sends[s++], ctx, proxy, pack, words);
+            pack += words;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < ma; i++) {
+            uint32_t src = members[start[a] + i];
+            if (src == rank) {
+                memcpy(stage + i * words, pack,
+                       words * sizeof(smlt_msg_payload_t));
+            } else {
+                smlt_alltoall_xfer_init(&recvs[r++], ctx, src,
+                                        stage + i * words, words);
+            }
+        }
+
+        pack += words;
+        stage += ma * words;
+    }
+
+    err = smlt_alltoall_progress(sends, s, recvs, r);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    /* phase 2: the proxies forward the blocks to the other groups */
+    struct smlt_alltoall_xfer fwd[proxied_members + num_groups - 1];
+    sends = fwd;
+    recvs = fwd + proxied_members;
+
+    s = 0;
+    r = 0;
+    stage = staged;
+    smlt_msg_payload_t *sort = sorted;
+    for (uint32_t b = 0; b < num_groups; b++) {
+        if (b == a || members[start[a] + b % ma] != rank) {
+            continue;
+        }
+
+        for (uint32_t j = 0; j < size[b]; j++) {
+            for (uint32_t i = 0; i < ma; i++) {
+                memcpy(sort + (j * ma + i) * bw,
+                       stage + (i * size[b] + j) * bw,
+                       bw * sizeof(smlt_msg_payload_t));
+            }
+
+            smlt_alltoall_xfer_init(&sends[s++], ctx, members[start[b] + j],
+                                    sort + j * ma * bw, ma * bw);
+        }
+
+        stage += ma * size[b] * bw;
+        sort += ma * size[b] * bw;
+    }
+
+    smlt_msg_payload_t *in = incoming;
+    for (uint32_t g = 0; g < num_groups; g++) {
+        if (g == a) {
+            continue;
+        }
+
+        uint32_t proxy = members[start[g] + a % size[g]];
+        smlt_alltoall_xfer_init(&recvs[r++], ctx, proxy, in, size[g] * bw);
+        in += size[g] * bw;
+    }
+
+    err = smlt_alltoall_progress(sends, s, recvs, r);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    in = incoming;
+    for (uint32_t g = 0; g < num_groups; g++) {
+        if (g == a) {
+            continue;
+        }
+
+        for (uint32_t i = 0; i < size[g]; i++) {
+            memcpy(recv + members[start[g] + i] * bw, in + i * bw,
+                   bw * sizeof(smlt_msg_payload_t));
+        }
+        in += size[g] * bw;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Smelt all-to-all
+ * ===========================================================================
+ */
+
+/**
+ * @brief selects the all-to-all algorithm for the context and block size
+ *
+ * @param ctx           The smelt context
+ * @param block_words   number of words of a block
+ *
+ * @returns the algorithm to use
+ */
+smlt_alltoall_algo_t smlt_alltoall_select(struct smlt_context *ctx,
+                                          uint32_t block_words)
+{
+    if (block_words > SMLT_ALLTOALL_DIRECT_MAX_WORDS) {
+        return SMLT_ALLTOALL_PAIRWISE;
+    }
+
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    if (num > 1) {
+        uint32_t group[num], idx[num], size[num], start[num], members[num];
+        if (smlt_alltoall_groups(ctx, group, idx, size, start, members) > 1) {
+            return SMLT_ALLTOALL_TWO_PHASE;
+        }
+    }
+
+    return SMLT_ALLTOALL_DIRECT;
+}
+
+/**
+ * @brief sends a distinct block to every node using the given algorithm
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks for all nodes
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the blocks of all nodes
+ * @param algo          the algorithm, the same on all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_alltoall_with_algo(struct smlt_context *ctx,
+                                 struct smlt_msg *sendbuf,
+                                 uint32_t block_words,
+                                 struct smlt_msg *recvbuf,
+                                 smlt_alltoall_algo_t algo)
+{
+    if (sendbuf == NULL || recvbuf == NULL || sendbuf == recvbuf ||
+        block_words == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t num = smlt_context_get_num_nodes(ctx);
+    uint32_t total = num * block_words;
+    if (sendbuf->words < total ||
+        recvbuf->bufsize < total * sizeof(smlt_msg_payload_t)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (algo == SMLT_ALLTOALL_AUTO) {
+        algo = smlt_alltoall_select(ctx, block_words);
+    }
+
+    SMLT_DEBUG(SMLT_DBG__GENERAL, "alltoall: algorithm %d, %" PRIu32
+               " words per block\n", algo, block_words);
+
+    recvbuf->words = total;
+
+    uint32_t rank = smlt_context_get_rank(ctx);
+    memcpy(recvbuf->data + rank * block_words,
+           sendbuf->data + rank * block_words,
+           block_words * sizeof(smlt_msg_payload_t));
+
+    if (num == 1) {
+        return SMLT_SUCCESS;
+    }
+
+    switch(algo) {
+        case SMLT_ALLTOALL_DIRECT :
+            return smlt_alltoall_direct(ctx, sendbuf->data, block_words,
+                                        recvbuf->data);
+        case SMLT_ALLTOALL_PAIRWISE :
+            return smlt_alltoall_pairwise(ctx, sendbuf->data, block_words,
+                                          recvbuf->data);
+        case SMLT_ALLTOALL_TWO_PHASE :
+            return smlt_alltoall_two_phase(ctx, sendbuf->data, block_words,
+                                           recvbuf->data);
+        default:
+            return SMLT_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief sends a distinct block to every node and receives one from each
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks for all nodes
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the blocks of all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_alltoall(struct smlt_context *ctx,
+                       struct smlt_msg *sendbuf,
+                       uint32_t block_words,
+                       struct smlt_msg *recvbuf)
+{
+    return smlt_alltoall_with_algo(ctx, sendbuf, block_words, recvbuf,
+                                   SMLT_ALLTOALL_AUTO);
+}
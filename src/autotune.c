@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_queuepair.h>
+#include <smlt_message.h>
+#include <smlt_autotune.h>
+#include "smlt_debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define SMLT_AUTOTUNE_PATH_MAX 512
+
+/*
+ * ===========================================================================
+ * Measurement
+ * ===========================================================================
+ */
+
+/// the backends considered for an edge
+static smlt_qp_type_t smlt_autotune_candidates[] = {
+    SMLT_QP_TYPE_UMP,
+    SMLT_QP_TYPE_FFQ,
+    SMLT_QP_TYPE_SHM
+};
+
+#define SMLT_AUTOTUNE_NUM_CANDIDATES \
+    (sizeof(smlt_autotune_candidates) / sizeof(smlt_autotune_candidates[0]))
+
+/**
+ * @brief returns the largest message the backend transfers without truncating
+ *
+ * Only UMP fragments messages over several slots.
+ */
+static uint32_t smlt_autotune_max_words(smlt_qp_type_t type)
+{
+    switch(type) {
+        case SMLT_QP_TYPE_UMP :
+            return UINT32_MAX;
+        case SMLT_QP_TYPE_FFQ :
+            return SMLT_FFQ_MSG_WORDS;
+        case SMLT_QP_TYPE_SHM :
+            return SHM_QP_PAYLOAD_WORDS;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief checks whether the backend is considered for the message size
+ *
+ * @param max_words the largest message sent on the edge, 0 if unknown
+ */
+static inline bool smlt_autotune_allowed(smlt_qp_type_t type,
+                                         uint32_t max_words)
+{
+    if (max_words == 0) {
+        return (type == SMLT_QP_TYPE_UMP);
+    }
+    return (max_words <= smlt_autotune_max_words(type));
+}
+
+struct smlt_autotune_args
+{
+    struct smlt_qp *qp;
+    coreid_t core;
+    cycles_t *samples;
+    errval_t err;
+};
+
+static void *smlt_autotune_ping(void *a)
+{
+    struct smlt_autotune_args *args = (struct smlt_autotune_args *) a;
+
+    args->err = smlt_platform_pin_thread(args->core);
+
+    struct smlt_msg *msg = smlt_message_alloc(sizeof(smlt_msg_payload_t));
+
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_WARMUP + SMLT_AUTOTUNE_ROUNDS; i++) {
+        cycles_t start = smlt_arch_tsc();
+
+        msg->data[0] = i;
+        msg->words = 1;
+        smlt_queuepair_send(args->qp, msg);
+        smlt_queuepair_recv(args->qp, msg);
+
+        if (i >= SMLT_AUTOTUNE_WARMUP) {
+            args->samples[i - SMLT_AUTOTUNE_WARMUP] = smlt_arch_tsc() - start;
+        }
+    }
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+static void *smlt_autotune_pong(void *a)
+{
+    struct smlt_autotune_args *args = (struct smlt_autotune_args *) a;
+
+    args->err = smlt_platform_pin_thread(args->core);
+
+    struct smlt_msg *msg = smlt_message_alloc(sizeof(smlt_msg_payload_t));
+
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_WARMUP + SMLT_AUTOTUNE_ROUNDS; i++) {
+        msg->words = 1;
+        smlt_queuepair_recv(args->qp, msg);
+        smlt_queuepair_send(args->qp, msg);
+    }
+
+    smlt_message_free(msg);
+
+    return NULL;
+}
+
+static int smlt_autotune_cmp(const void *a, const void *b)
+{
+    cycles_t x = *(const cycles_t *) a;
+    cycles_t y = *(const cycles_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief measures the round trip latency of a backend between two cores
+ *
+ * @param type      the queuepair backend to measure
+ * @param src       the core initiating the round trips
+ * @param dst       the core echoing the messages
+ * @param ret_cyc   returns the median round trip time in cycles
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_autotune_measure(smlt_qp_type_t type, coreid_t src,
+                               coreid_t dst, cycles_t *ret_cyc)
+{
+    errval_t err;
+    struct smlt_qp *qp_src, *qp_dst;
+    pthread_t ping, pong;
+
+    err = smlt_queuepair_create(type, &qp_src, &qp_dst, src, dst);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    cycles_t *samples = (cycles_t *) calloc(SMLT_AUTOTUNE_ROUNDS,
+                                            sizeof(cycles_t));
+    if (samples == NULL) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto err_destroy;
+    }
+
+    struct smlt_autotune_args args_src = {
+        .qp = qp_src, .core = src, .samples = samples
+    };
+    struct smlt_autotune_args args_dst = {
+        .qp = qp_dst, .core = dst, .samples = NULL
+    };
+
+    if (pthread_create(&pong, NULL, smlt_autotune_pong, &args_dst)) {
+        free(samples);
+        err = SMLT_ERR_NODE_CREATE;
+        goto err_destroy;
+    }
+
+    if (pthread_create(&ping, NULL, smlt_autotune_ping, &args_src)) {
+        /*
+         * the echo thread cannot terminate without its peer, run the
+         * round trips on the calling thread and restore its affinity
+         */
+        cpu_set_t cpu_mask;
+        sched_getaffinity(0, sizeof(cpu_mask), &cpu_mask);
+        smlt_autotune_ping(&args_src);
+        sched_setaffinity(0, sizeof(cpu_mask), &cpu_mask);
+    } else {
+        pthread_join(ping, NULL);
+    }
+
+    pthread_join(pong, NULL);
+
+    /* the numbers are meaningless if the threads were not pinned */
+    if (smlt_err_is_fail(args_src.err) || smlt_err_is_fail(args_dst.err)) {
+        free(samples);
+        err = SMLT_ERR_PLATFORM_INIT;
+        goto err_destroy;
+    }
+
+    qsort(samples, SMLT_AUTOTUNE_ROUNDS, sizeof(cycles_t), smlt_autotune_cmp);
+    *ret_cyc = samples[SMLT_AUTOTUNE_ROUNDS / 2];
+
+    free(samples);
+
+    err = smlt_queuepair_destroy(qp_src);
+    if (smlt_err_is_fail(err)) {
+        smlt_queuepair_destroy(qp_dst);
+        return err;
+    }
+
+    return smlt_queuepair_destroy(qp_dst);
+
+    err_destroy:
+    smlt_queuepair_destroy(qp_src);
+    smlt_queuepair_destroy(qp_dst);
+    return err;
+}
+
+
+/*
+ * ===========================================================================
+ * Cache
+ * ===========================================================================
+ */
+
+static const char *smlt_autotune_type_name(smlt_qp_type_t type)
+{
+    switch(type) {
+        case SMLT_QP_TYPE_UMP :
+            return "ump";
+        case SMLT_QP_TYPE_FFQ :
+            return "ffq";
+        case SMLT_QP_TYPE_SHM :
+            return "shm";
+        default:
+            return "invalid";
+    }
+}
+
+static smlt_qp_type_t smlt_autotune_type_from_name(const char *name)
+{
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_NUM_CANDIDATES; i++) {
+        smlt_qp_type_t type = smlt_autotune_candidates[i];
+        if (!strcmp(name, smlt_autotune_type_name(type))) {
+            return type;
+        }
+    }
+    return SMLT_QP_TYPE_INVALID;
+}
+
+/**
+ * @brief looks up the fastest allowed backend of the edge in the cache file
+ *
+ * The file has one line per measured backend of an edge:
+ * "<src> <dst> <backend> <cycles>". It is a hit only if all the backends
+ * allowed for the message size have been measured.
+ */
+static errval_t smlt_autotune_cache_lookup(const char *path, coreid_t src,
+                                           coreid_t dst, uint32_t max_words,
+                                           smlt_qp_type_t *ret_type)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return SMLT_ERR_CACHE_MISS;
+    }
+
+    bool found[SMLT_AUTOTUNE_NUM_CANDIDATES] = { false };
+    cycles_t cycles[SMLT_AUTOTUNE_NUM_CANDIDATES];
+    unsigned int s, d;
+    uint64_t cyc;
+    char name[16];
+
+    while (fscanf(f, "%u %u %15s %" SCNu64, &s, &d, name, &cyc) == 4) {
+        if (s != src || d != dst) {
+            continue;
+        }
+
+        smlt_qp_type_t type = smlt_autotune_type_from_name(name);
+        for (uint32_t i = 0; i < SMLT_AUTOTUNE_NUM_CANDIDATES; i++) {
+            if (smlt_autotune_candidates[i] == type) {
+                /* later entries take precedence */
+                found[i] = true;
+                cycles[i] = cyc;
+            }
+        }
+    }
+
+    fclose(f);
+
+    smlt_qp_type_t best = SMLT_QP_TYPE_INVALID;
+    cycles_t best_cyc = 0;
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_NUM_CANDIDATES; i++) {
+        if (!smlt_autotune_allowed(smlt_autotune_candidates[i], max_words)) {
+            continue;
+        }
+        if (!found[i]) {
+            return SMLT_ERR_CACHE_MISS;
+        }
+        if (best == SMLT_QP_TYPE_INVALID || cycles[i] < best_cyc) {
+            best = smlt_autotune_candidates[i];
+            best_cyc = cycles[i];
+        }
+    }
+
+    *ret_type = best;
+
+    return SMLT_SUCCESS;
+}
+
+static errval_t smlt_autotune_cache_store(const char *path, coreid_t src,
+                                          coreid_t dst, smlt_qp_type_t type,
+                                          cycles_t cyc)
+{
+    FILE *f = fopen(path, "a");
+    if (f == NULL) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    fprintf(f, "%" PRIu32 " %" PRIu32 " %s %" PRIu64 "\n", src, dst,
+            smlt_autotune_type_name(type), (uint64_t) cyc);
+
+    fclose(f);
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Edge selection
+ * ===========================================================================
+ */
+
+/**
+ * @brief selects the fastest backend for the edge between two cores
+ *
+ * @param src       the core of the parent
+ * @param dst       the core of the child
+ * @param max_words the largest message sent on the edge, 0 if unknown
+ * @param ret_type  returns the backend to use
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_autotune_edge(coreid_t src, coreid_t dst, uint32_t max_words,
+                            smlt_qp_type_t *ret_type)
+{
+    errval_t err;
+    char path[SMLT_AUTOTUNE_PATH_MAX];
+    bool use_cache = true;
+    uint32_t num_allowed = 0;
+
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_NUM_CANDIDATES; i++) {
+        if (smlt_autotune_allowed(smlt_autotune_candidates[i], max_words)) {
+            *ret_type = smlt_autotune_candidates[i];
+            num_allowed++;
+        }
+    }
+
+    /* nothing to choose from, the messages only fit UMP */
+    if (num_allowed == 1) {
+        return SMLT_SUCCESS;
+    }
+
+    err = smlt_platform_cache_path(SMLT_AUTOTUNE_CACHE_FILE, path,
+                                   sizeof(path));
+    if (smlt_err_is_fail(err)) {
+        SMLT_WARNING("autotune: no cache directory, not caching results\n");
+        use_cache = false;
+    }
+
+    if (use_cache) {
+        err = smlt_autotune_cache_lookup(path, src, dst, max_words, ret_type);
+        if (!smlt_err_is_fail(err)) {
+            return SMLT_SUCCESS;
+        }
+    }
+
+    smlt_qp_type_t best = SMLT_QP_TYPE_INVALID;
+    cycles_t best_cyc = 0;
+
+    for (uint32_t i = 0; i < SMLT_AUTOTUNE_NUM_CANDIDATES; i++) {
+        if (!smlt_autotune_allowed(smlt_autotune_candidates[i], max_words)) {
+            continue;
+        }
+
+        cycles_t cyc;
+        err = smlt_autotune_measure(smlt_autotune_candidates[i], src, dst, &cyc);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        SMLT_DEBUG(SMLT_DBG__GENERAL, "autotune: %" PRIu32 " -> %" PRIu32
+                   " %s: %" PRIu64 " cycles\n", src, dst,
+                   smlt_autotune_type_name(smlt_autotune_candidates[i]),
+                   (uint64_t) cyc);
+
+        /* every measurement is kept, other message sizes may need it */
+        if (use_cache) {
+            err = smlt_autotune_cache_store(path, src, dst,
+                                            smlt_autotune_candidates[i], cyc);
+            if (smlt_err_is_fail(err)) {
+                SMLT_WARNING("autotune: could not write the cache file\n");
+                use_cache = false;
+            }
+        }
+
+        if (best == SMLT_QP_TYPE_INVALID || cyc < best_cyc) {
+            best = smlt_autotune_candidates[i];
+            best_cyc = cyc;
+        }
+    }
+
+    *ret_type = best;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief checks whether autotuning was requested in the environment
+ *
+ * @returns TRUE if SMLT_AUTOTUNE is set to a non-zero value
+ */
+bool smlt_autotune_enabled(void)
+{
+    char *env = getenv("SMLT_AUTOTUNE");
+
+    return (env != NULL && strcmp(env, "") && strcmp(env, "0"));
+}
+
+/**
+ * @brief returns the largest message size given in the environment
+ *
+ * @returns the value of SMLT_AUTOTUNE_MAX_WORDS or 0 if it is not set or
+ *          not a number
+ */
+uint32_t smlt_autotune_max_msg_words(void)
+{
+    char *env = getenv("SMLT_AUTOTUNE_MAX_WORDS");
+    if (env == NULL) {
+        return 0;
+    }
+
+    char *end;
+    unsigned long words = strtoul(env, &end, 10);
+    if (*env == 0 || *end != 0 || words > UINT32_MAX) {
+        return 0;
+    }
+
+    return (uint32_t) words;
+}
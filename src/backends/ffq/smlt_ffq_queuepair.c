@@ -86,14 +86,23 @@ errval_t smlt_ffq_queuepair_init(smlt_ffq_idx_t num_slots, uint8_t node_src,
 }
 
 /**
- * @brief destorys a FFQ queuepair
+ * @brief destroys one end of a FFQ queuepair
  *
  * @param qp    the FFQ queuepair
  *
  * @returns SMLT_SUCCESS or error value
+ *
+ * Each end frees the buffer it receives on, so destroying both ends frees
+ * both directions.
  */
 errval_t smlt_ffq_queuepair_destroy(struct smlt_ffq_queuepair *qp)
 {
+    if (qp->rx.slots) {
+        smlt_platform_free((void *) qp->rx.slots);
+    }
+
+    memset(qp, 0, sizeof(*qp));
+
     return SMLT_SUCCESS;
 }
 
@@ -129,6 +138,10 @@ errval_t smlt_ffq_queuepair_send(struct smlt_qp *qp,
 errval_t smlt_ffq_queuepair_notify(struct smlt_qp *qp)
 {
     struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+
+    while(!smlt_ffq_queuepair_can_send_raw(ffq))
+        ;
+
     return smlt_ffq_queuepair_notify_raw(ffq);
 }
 
@@ -145,6 +158,45 @@ bool smlt_ffq_queuepair_can_send(struct smlt_qp *qp)
     return smlt_ffq_queuepair_can_send_raw(ffq);
 }
 
+/**
+ * @brief obtains the payload buffer for the next message
+ *
+ * @param qp     The smelt queuepair to send on
+ * @param data   returns the pointer to the payload buffer
+ * @param words  returns the number of payload words in the buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL if there is no free slot
+ */
+errval_t smlt_ffq_queuepair_try_send_prepare(struct smlt_qp *qp,
+                                             smlt_msg_payload_t **data,
+                                             uint32_t *words)
+{
+    struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+
+    if (!smlt_ffq_queuepair_can_send_raw(ffq)) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    *data = ffq->stage.data;
+    *words = SMLT_FFQ_MSG_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief sends the prepared message
+ *
+ * @param qp     The smelt queuepair to send on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ffq_queuepair_send_commit(struct smlt_qp *qp)
+{
+    struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+    return smlt_ffq_queuepair_send_raw(ffq, ffq->stage.data,
+                                       SMLT_FFQ_MSG_WORDS);
+}
+
 
 /*
  * ===========================================================================
@@ -177,6 +229,10 @@ errval_t smlt_ffq_queuepair_recv(struct smlt_qp *qp,
  errval_t smlt_ffq_queuepair_recv_notify(struct smlt_qp *qp)
  {
     struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+
+    while(!smlt_ffq_queuepair_can_recv_raw(ffq))
+        ;
+
     return smlt_ffq_queuepair_recv_raw(ffq, NULL, 0);
  }
 
@@ -192,3 +248,41 @@ errval_t smlt_ffq_queuepair_recv(struct smlt_qp *qp,
     struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
     return smlt_ffq_queuepair_can_recv_raw(ffq);
  }
+
+/**
+ * @brief lends the payload of the next message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS if the slot is lent, SMLT_ERR_QUEUE_EMPTY otherwise
+ */
+errval_t smlt_ffq_queuepair_try_recv_borrow(struct smlt_qp *qp,
+                                            const smlt_msg_payload_t **data,
+                                            uint32_t *words)
+{
+    struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+
+    if (!smlt_ffq_queuepair_can_recv_raw(ffq)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    *data = (const smlt_msg_payload_t *)(ffq->rx.slots + ffq->rx.pos)->data;
+    *words = SMLT_FFQ_MSG_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief releases the lent message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ffq_queuepair_recv_release(struct smlt_qp *qp)
+{
+    struct smlt_ffq_queuepair *ffq = &qp->q.ffq;
+    return smlt_ffq_queuepair_recv_raw(ffq, NULL, 0);
+}
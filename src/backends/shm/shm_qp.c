@@ -52,15 +52,30 @@ struct shm_qp* shm_queuepair_create(uint32_t src,
                                     uint32_t dst)
 {
     struct shm_qp* qp = (struct shm_qp*) malloc(sizeof(struct shm_qp));
-    void* shm = numa_alloc_onnode(sizeof(SHM_SIZE),
+    void* shm = numa_alloc_onnode(SHM_SIZE,
                                   numa_node_of_cpu(dst));
-    qp->src = *shm_init_context(shm,
-                               numa_node_of_cpu(src));
-    qp->dst = *shm_init_context(shm,
-                               numa_node_of_cpu(dst));
+
+    // the contexts are copied into the queuepair
+    struct shm_context* ctx = shm_init_context(shm, numa_node_of_cpu(src));
+    qp->src = *ctx;
+    numa_free(ctx, sizeof(struct shm_context));
+
+    ctx = shm_init_context(shm, numa_node_of_cpu(dst));
+    qp->dst = *ctx;
+    numa_free(ctx, sizeof(struct shm_context));
+
     return qp;
 }
 
+void shm_queuepair_destroy(struct shm_qp* qp)
+{
+    if (qp->src.shm) {
+        numa_free(qp->src.shm, SHM_SIZE);
+    }
+    qp->src.shm = NULL;
+    qp->dst.shm = NULL;
+}
+
 void get_next_sync(struct shm_context* q, 
                    uint64_t* next)
 {
@@ -165,10 +180,16 @@ bool shm_q_can_recv(struct shm_context* context)
 bool shm_q_can_send(struct shm_context* context)
 {
     if (context->next_seq == context->next_sync) {
-        return false;
-    } else {
-        return true;
+        // at the sync point, check whether the reader has made progress
+        uint64_t next_sync;
+        get_next_sync(context, &next_sync);
+        if (context->next_seq == next_sync) {
+            return false;
+        }
+        context->next_sync = next_sync;
     }
+
+    return true;
 }
 
 // returns NULL if reader reached writers pos
@@ -24,12 +24,16 @@
 #include <numa.h>
 #include <smlt_platform.h>
 #include <smlt_message.h>
+#include <arch/x86_64.h>
 
 #include <shm/swmr.h>
 
 
 #define SLOT_SIZE CACHELINE_SIZE/sizeof(uintptr_t)
 
+static errval_t swmr_receive_bulk(struct swmr_context* context,
+                                  struct smlt_msg *msg);
+
 //#define DEBUG_SHM
 
 /**
@@ -81,13 +85,45 @@ void swmr_queue_create(struct swmr_queue** queue,
                        uint32_t* dst,
                        uint16_t count,
                        bool sep_header)
+{
+    errval_t err;
+
+    err = swmr_queue_create_sized(queue, src, dst, count, sep_header, 0);
+    assert(!smlt_err_is_fail(err));
+}
+
+/**
+ * \brief Create a shared memory queue with the given size
+ *
+ * \param queue_size Number of cachelines of the queue including the
+ * read pointers of the readers, 0 to pick a multiple of SWMRQ_SIZE that
+ * leaves at least 48 slots for messages.
+ *
+ * \returns SMLT_ERR_INVAL if the queue has less than SWMRQ_MIN_SLOTS
+ * message slots or more than SWMRQ_MAX_SLOTS, SMLT_ERR_MALLOC_FAIL or
+ * SMLT_SUCCESS
+ */
+errval_t swmr_queue_create_sized(struct swmr_queue** queue,
+                                 uint32_t src,
+                                 uint32_t* dst,
+                                 uint16_t count,
+                                 bool sep_header,
+                                 uint32_t queue_size)
 {
     void* shm;
-    uint32_t queue_size = SWMRQ_SIZE;
-    // at least 32 slots
-    while ((queue_size - (count+1)) < 48) {
-        // Add another page
-        queue_size += SWMRQ_SIZE;
+
+    if (queue_size == 0) {
+        queue_size = SWMRQ_SIZE;
+        // at least 32 slots
+        while ((queue_size - (count+1)) < 48) {
+            // Add another page
+            queue_size += SWMRQ_SIZE;
+        }
+    }
+
+    if (queue_size < (uint32_t) (count + 1) + SWMRQ_MIN_SLOTS ||
+        queue_size - (count + 1) > SWMRQ_MAX_SLOTS) {
+        return SMLT_ERR_INVAL;
     }
 
     if (sep_header) {
@@ -100,7 +136,9 @@ void swmr_queue_create(struct swmr_queue** queue,
                                           numa_node_of_cpu(dst[0]), true);
     }
 
-    assert(shm != NULL);
+    if (shm == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
     swmr_init_context(shm, &(*queue)->src, count, 0, sep_header, queue_size);
 
@@ -108,23 +146,46 @@ void swmr_queue_create(struct swmr_queue** queue,
         (sizeof(struct swmr_context)*count,
          SMLT_ARCH_CACHELINE_SIZE,
          numa_node_of_cpu(dst[0]), true);
-    assert ((*queue)->dst != NULL);
+    if ((*queue)->dst == NULL) {
+        smlt_platform_free(shm);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
     for (int i = 0; i < count ; i++) {
         swmr_init_context(shm, &((*queue)->dst[i]), count, i,
 			  sep_header, queue_size);
     }
+
+    return SMLT_SUCCESS;
 }
 
+/**
+ * \brief Frees the shared memory and the reader contexts of the queue
+ */
+void swmr_queue_destroy(struct swmr_queue* queue)
+{
+    if (queue->src.shm) {
+        smlt_platform_free(queue->src.shm);
+    }
+    if (queue->dst) {
+        smlt_platform_free(queue->dst);
+    }
+    queue->src.shm = NULL;
+    queue->dst = NULL;
+}
+
+
+static void swmr_send_bulk(struct swmr_context* context,
+                           struct smlt_msg *msg);
 
 errval_t smlt_swmr_send(struct swmr_queue *qp, struct smlt_msg *msg)
 {
-    if (msg->words <= 7) {
+    if (msg->words <= SWMR_SLOT_PAYLOAD_WORDS) {
         uintptr_t* data = (uintptr_t*) msg->data;
         swmr_send_raw(&qp->src, data[0], data[1], data[2],
                       data[3], data[4], data[5], data[6]);
     } else {
-        // TODO Fragment ? Or Bulkload style?
+        swmr_send_bulk(&qp->src, msg);
     }
     return SMLT_SUCCESS;
 }
@@ -239,9 +300,9 @@ void swmr_send_raw0(struct swmr_context* context)
        context->next_sync = next_sync;
     }
 
-    uintptr_t* slot_start = (uintptr_t*) context->data + (context->l_pos*SLOT_SIZE);
+    uintptr_t* header = (uintptr_t*) context->header + (context->l_pos*SLOT_SIZE);
 
-    slot_start[0] = context->next_seq;
+    header[0] = context->next_seq;
 
     context->next_seq++;
 
@@ -253,9 +314,9 @@ void swmr_send_raw0(struct swmr_context* context)
 bool swmr_can_receive(struct swmr_context* context)
 {
     uintptr_t* start;
-    start = (uintptr_t*) context->data + ((context->l_pos)*SLOT_SIZE);
+    start = (uintptr_t*) context->header + ((context->l_pos)*SLOT_SIZE);
 
-    if (context->next_seq == start[0]) {
+    if (context->next_seq == (start[0] & ~SWMR_SEQ_BULK)) {
         return true;
     } else {
         return false;
@@ -315,10 +376,18 @@ bool swmr_receive_non_blocking(struct swmr_context* context,
 bool swmr_receive_non_blocking0(struct swmr_context* context)
 {
     //assert (context!=NULL);
-    uintptr_t* start;
-    start = (uintptr_t*) context->data + ((context->l_pos)*SLOT_SIZE);
+    volatile uintptr_t* header = (uintptr_t*) context->header +
+                                     ((context->l_pos)*SLOT_SIZE);
 
-    if (context->next_seq == start[0]) {
+    // bulk messages are consumed entirely
+    if (context->next_seq == (header[0] & ~SWMR_SEQ_BULK) &&
+        (header[0] & SWMR_SEQ_BULK)) {
+        swmr_receive_bulk(context, NULL);
+        return true;
+    }
+
+    // the sequence number is in the header, also with a separate header
+    if (context->next_seq == header[0]) {
         context->l_pos++;
         context->next_seq++;
         if (context->l_pos == context->num_slots) {
@@ -356,15 +425,193 @@ void swmr_receive_raw0(struct swmr_context* context)
 }
 
 
+/*
+ * ===========================================================================
+ * Bulk messages
+ * ===========================================================================
+ */
+
+/**
+ * \brief waits until the slot with the given offset from the current write
+ * position can be written and returns a pointer to it
+ */
+static uintptr_t* swmr_wait_slot(struct swmr_context* context, uint64_t i)
+{
+    uint64_t next_sync;
+
+    // block until all readers are far enough
+    while ((context->next_seq + i) >= context->next_sync) {
+        swmr_get_next_sync(context, &next_sync);
+        context->next_sync = next_sync;
+    }
+
+    uint64_t pos = (context->l_pos + i) % context->num_slots;
+    return (uintptr_t*) context->data + pos*SLOT_SIZE;
+}
+
+/**
+ * \brief sends a message larger than a single slot
+ *
+ * The payload is split into chunks of at most half the queue size, such that
+ * the writer can stage the next chunk while the readers copy out the current
+ * one. Each chunk is written into consecutive slots and published with a
+ * single write of the header of its first slot.
+ */
+static void swmr_send_bulk(struct swmr_context* context,
+                           struct smlt_msg *msg)
+{
+    uint64_t max_slots = context->num_slots / 2;
+    uint64_t max_words = SWMR_BULK_HEAD_WORDS +
+                         (max_slots - 1) * SWMR_SLOT_PAYLOAD_WORDS;
+
+    if (context->l_pos == context->num_slots) {
+        context->l_pos = 0;
+    }
+
+    uintptr_t* payload = (uintptr_t*) msg->data;
+    uint64_t remaining = msg->words;
+    while (remaining) {
+        uint64_t words = remaining < max_words ? remaining : max_words;
+        remaining -= words;
+
+        // first slot: chunk size, remaining words and start of the payload
+        uintptr_t* head = swmr_wait_slot(context, 0);
+        uint64_t n = words < SWMR_BULK_HEAD_WORDS ? words : SWMR_BULK_HEAD_WORDS;
+        head[1] = words;
+        head[2] = remaining;
+        memcpy(&head[3], payload, n * sizeof(uintptr_t));
+        payload += n;
+
+        uint64_t slots = 1;
+        for (uint64_t w = n; w < words; w += SWMR_SLOT_PAYLOAD_WORDS) {
+            n = words - w;
+            if (n > SWMR_SLOT_PAYLOAD_WORDS) {
+                n = SWMR_SLOT_PAYLOAD_WORDS;
+            }
+            uintptr_t* slot = swmr_wait_slot(context, slots);
+            memcpy(&slot[1], payload, n * sizeof(uintptr_t));
+            payload += n;
+            slots++;
+        }
+
+        // publish the chunk
+        smlt_arch_write_barrier();
+        volatile uintptr_t* header = (uintptr_t*) context->header +
+                                         context->l_pos*SLOT_SIZE;
+        header[0] = context->next_seq | SWMR_SEQ_BULK;
+
+        context->next_seq += slots;
+        context->l_pos = (context->l_pos + slots) % context->num_slots;
+    }
+}
+
+/**
+ * \brief receives all chunks of a bulk message
+ *
+ * The header of the first chunk must already be visible. If msg is NULL, the
+ * message is only consumed.
+ */
+static errval_t swmr_receive_bulk(struct swmr_context* context,
+                                  struct smlt_msg *msg)
+{
+    uint64_t capacity = 0;
+    uint64_t offset = 0;
+    uint64_t total = 0;
+
+    if (msg && msg->data) {
+        capacity = msg->bufsize / sizeof(smlt_msg_payload_t);
+    }
+
+    while (true) {
+        volatile uintptr_t* header = (uintptr_t*) context->header +
+                                         context->l_pos*SLOT_SIZE;
+
+        // wait for the next chunk, publish our position in the meantime
+        while (context->next_seq != (header[0] & ~SWMR_SEQ_BULK)) {
+            context->readers_pos[context->id].pos = context->next_seq - 1;
+        }
+
+        volatile uintptr_t* head = (uintptr_t*) context->data +
+                                       context->l_pos*SLOT_SIZE;
+        uint64_t words = head[1];
+        uint64_t remaining = head[2];
+        if (total == 0) {
+            total = words + remaining;
+        }
+
+        uint64_t n = words < SWMR_BULK_HEAD_WORDS ? words : SWMR_BULK_HEAD_WORDS;
+        uintptr_t* src = (uintptr_t*) &head[3];
+        uint64_t slots = 1;
+        uint64_t w = 0;
+        while (true) {
+            if (offset < capacity) {
+                uint64_t c = (capacity - offset) < n ? (capacity - offset) : n;
+                memcpy(msg->data + offset, src, c * sizeof(uintptr_t));
+            }
+            offset += n;
+            w += n;
+            if (w == words) {
+                break;
+            }
+
+            n = words - w;
+            if (n > SWMR_SLOT_PAYLOAD_WORDS) {
+                n = SWMR_SLOT_PAYLOAD_WORDS;
+            }
+            uint64_t pos = (context->l_pos + slots) % context->num_slots;
+            src = (uintptr_t*) context->data + pos*SLOT_SIZE + 1;
+            slots++;
+        }
+
+        context->next_seq += slots;
+        context->l_pos = (context->l_pos + slots) % context->num_slots;
+        context->readers_pos[context->id].pos = context->next_seq - 1;
+
+        if (remaining == 0) {
+            break;
+        }
+    }
+
+    if (msg == NULL) {
+        return SMLT_SUCCESS;
+    }
+
+    if (total > capacity) {
+        msg->words = capacity;
+        return SMLT_ERR_MSG_TRUNCATED;
+    }
+
+    msg->words = total;
+    return SMLT_SUCCESS;
+}
+
 errval_t smlt_swmr_recv(struct swmr_context *context, struct smlt_msg *msg)
 {
-    if (msg->words <= 7) {
-        uintptr_t* data = (uintptr_t*) msg->data;
-        swmr_receive_raw(context, &data[0], &data[1], &data[2],
-                      &data[3], &data[4], &data[5], &data[6]);
-    } else {
-        // TODO Fragment ? Or Bulkload style?
+    volatile uintptr_t* header = (uintptr_t*) context->header +
+                                     context->l_pos*SLOT_SIZE;
+
+    // wait for the next message, publish our position in the meantime
+    while (context->next_seq != (header[0] & ~SWMR_SEQ_BULK)) {
+        if (context->readers_pos[context->id].pos != context->next_seq - 1) {
+            context->readers_pos[context->id].pos = context->next_seq - 1;
+        }
     }
+
+    if (header[0] & SWMR_SEQ_BULK) {
+        return swmr_receive_bulk(context, msg);
+    }
+
+    uintptr_t r[SWMR_SLOT_PAYLOAD_WORDS];
+    swmr_receive_raw(context, &r[0], &r[1], &r[2],
+                     &r[3], &r[4], &r[5], &r[6]);
+
+    uint32_t words = msg->words;
+    if (words > SWMR_SLOT_PAYLOAD_WORDS) {
+        words = SWMR_SLOT_PAYLOAD_WORDS;
+    }
+    memcpy(msg->data, r, words * sizeof(uintptr_t));
+    msg->words = words;
+
     return SMLT_SUCCESS;
 }
 errval_t smlt_swmr_recv0(struct swmr_context *context)
@@ -372,3 +619,79 @@ errval_t smlt_swmr_recv0(struct swmr_context *context)
     swmr_receive_raw0(context);
     return SMLT_SUCCESS;
 }
+
+/**
+ * \brief waits for the next message and lends its payload to the caller
+ *
+ * The reader position is only advanced by smlt_swmr_recv_release(), hence
+ * the writer cannot reuse the slot while it is lent. Bulk messages span
+ * several slots and cannot be lent.
+ */
+errval_t smlt_swmr_recv_borrow(struct swmr_context *context,
+                               const smlt_msg_payload_t **data,
+                               uint32_t *words)
+{
+    volatile uintptr_t* header = (uintptr_t*) context->header +
+                                     context->l_pos*SLOT_SIZE;
+
+    while (context->next_seq != (header[0] & ~SWMR_SEQ_BULK)) {
+        if (context->readers_pos[context->id].pos != context->next_seq - 1) {
+            context->readers_pos[context->id].pos = context->next_seq - 1;
+        }
+    }
+
+    if (header[0] & SWMR_SEQ_BULK) {
+        return SMLT_ERR_MSG_FRAGMENTED;
+    }
+
+    *data = (const smlt_msg_payload_t *) context->data +
+                context->l_pos*SLOT_SIZE + 1;
+    *words = SWMR_SLOT_PAYLOAD_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+errval_t smlt_swmr_recv_release(struct swmr_context *context)
+{
+    if (!swmr_receive_non_blocking0(context)) {
+        return SMLT_ERR_QUEUE_STATE;
+    }
+    return SMLT_SUCCESS;
+}
+
+/**
+ * \brief waits for a free slot and returns its payload for in-place writes
+ */
+errval_t smlt_swmr_send_prepare(struct swmr_queue *qp,
+                                smlt_msg_payload_t **data,
+                                uint32_t *words)
+{
+    struct swmr_context* context = &qp->src;
+
+    if (context->l_pos == context->num_slots) {
+        context->l_pos = 0;
+    }
+
+    *data = (smlt_msg_payload_t *) swmr_wait_slot(context, 0) + 1;
+    *words = SWMR_SLOT_PAYLOAD_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * \brief publishes the slot obtained by smlt_swmr_send_prepare()
+ */
+errval_t smlt_swmr_send_commit(struct swmr_queue *qp)
+{
+    struct swmr_context* context = &qp->src;
+
+    volatile uintptr_t* header = (uintptr_t*) context->header +
+                                     context->l_pos*SLOT_SIZE;
+
+    smlt_arch_write_barrier();
+    header[0] = context->next_seq;
+    context->next_seq++;
+    context->l_pos++;
+
+    return SMLT_SUCCESS;
+}
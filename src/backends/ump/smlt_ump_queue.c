@@ -132,3 +132,41 @@ errval_t smlt_ump_queue_init_rx(struct smlt_ump_queue *q, void *buf,
 
     return SMLT_SUCCESS;
 }
+
+/**
+ * @brief sets the ACK policy of the UMP receive queue
+ *
+ * @param q         the UMP receive queue
+ * @param policy    the ACK policy
+ * @param interval  number of messages per ACK for SMLT_UMP_ACK_EVERY_N
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the interval is not within the
+ *          size of the buffer
+ *
+ * The sender can only be ahead by the size of the buffer, an interval larger
+ * than that would never be reached.
+ */
+errval_t smlt_ump_queue_set_ack_policy(struct smlt_ump_queue *q,
+                                       smlt_ump_ack_policy_t policy,
+                                       smlt_ump_idx_t interval)
+{
+    switch(policy) {
+        case SMLT_UMP_ACK_HALF_WINDOW :
+        case SMLT_UMP_ACK_EVERY :
+            interval = 1;
+            break;
+        case SMLT_UMP_ACK_EVERY_N :
+            if (interval == 0 || interval > q->num_msg) {
+                return SMLT_ERR_INVAL;
+            }
+            break;
+        default:
+            return SMLT_ERR_INVAL;
+    }
+
+    q->ack_policy = policy;
+    q->ack_interval = interval;
+    q->ack_pending = 0;
+
+    return SMLT_SUCCESS;
+}
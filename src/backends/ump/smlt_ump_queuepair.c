@@ -94,9 +94,194 @@ errval_t smlt_ump_queuepair_init(smlt_ump_idx_t num_slots, uint8_t node_src,
 }
 
 
+/**
+ * @brief destroys one end of a UMP queuepair
+ *
+ * @param qp    the UMP queuepair
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Each end frees the buffer it receives on, which starts with the ACK word,
+ * so destroying both ends frees both directions.
+ */
 errval_t smlt_ump_queuepair_destroy(struct smlt_ump_queuepair *qp)
 {
-    // TODO how to destroy a ump queuepair?
+    if (qp->rx.last_ack) {
+        smlt_platform_free(qp->rx.last_ack);
+    }
+
+    memset(qp, 0, sizeof(*qp));
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief sets the ACK policy for the messages received on the queuepair
+ *
+ * @param qp        the UMP queuepair
+ * @param policy    the ACK policy
+ * @param interval  number of messages per ACK for SMLT_UMP_ACK_EVERY_N
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_ump_queuepair_set_ack_policy(struct smlt_ump_queuepair *qp,
+                                           smlt_ump_ack_policy_t policy,
+                                           smlt_ump_idx_t interval)
+{
+    return smlt_ump_queue_set_ack_policy(&qp->rx, policy, interval);
+}
+
+
+/*
+ * ===========================================================================
+ * fragmentation of large messages
+ * ===========================================================================
+ */
+
+/**
+ * @brief sends a message larger than a slot as a sequence of fragments
+ *
+ * @param ump   the UMP queuepair to send on
+ * @param msg   the Smelt message to send
+ *
+ * @returns SMLT_SUCCESS if the message was sent, SMLT_ERR_QUEUE_FULL if the
+ *          queue filled up before the last fragment was sent
+ *
+ * The first fragment carries the total number of words. Every slot uses its
+ * own sequence number such that the flow control works on slot granularity
+ * and messages larger than the queue are streamed through it. The progress
+ * of a partially sent message is kept in the queuepair, so the sender never
+ * waits for the receiver while holding the queue.
+ */
+static errval_t smlt_ump_queuepair_send_frag(struct smlt_ump_queuepair *ump,
+                                             struct smlt_msg *msg)
+{
+    errval_t err;
+    struct smlt_ump_message *m;
+    union smlt_ump_ctrl ctrl;
+
+    if (ump->tx_frag_offset == 0) {
+        err = smlt_ump_queuepair_prepare_send(ump, &m);
+        if (smlt_err_is_fail(err)) {
+            return SMLT_ERR_QUEUE_FULL;
+        }
+
+        m->data[0] = msg->words;
+        memcpy(&m->data[1], msg->data, SMLT_UMP_FRAG_HEAD_WORDS *
+                                       sizeof(smlt_ump_payload_word_t));
+
+        ctrl.c.epoch = SMLT_UMP_FLAG_FRAG;
+        ctrl.c.last_ack = ump->seq_id++;
+        smlt_ump_queue_send(&ump->tx, m, ctrl);
+
+        ump->tx_frag_data = msg->data;
+        ump->tx_frag_words = msg->words;
+        ump->tx_frag_offset = SMLT_UMP_FRAG_HEAD_WORDS;
+    } else if (msg->data != ump->tx_frag_data ||
+               msg->words != ump->tx_frag_words) {
+        /* the pending message has to be completed first */
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    while (ump->tx_frag_offset < ump->tx_frag_words) {
+        uint32_t words = ump->tx_frag_words - ump->tx_frag_offset;
+        if (words > SMLT_UMP_PAYLOAD_WORDS) {
+            words = SMLT_UMP_PAYLOAD_WORDS;
+        }
+
+        err = smlt_ump_queuepair_prepare_send(ump, &m);
+        if (smlt_err_is_fail(err)) {
+            return SMLT_ERR_QUEUE_FULL;
+        }
+
+        memcpy(m->data, msg->data + ump->tx_frag_offset,
+               words * sizeof(smlt_ump_payload_word_t));
+
+        smlt_ump_queuepair_send_raw(ump, m);
+
+        ump->tx_frag_offset += words;
+    }
+
+    ump->tx_frag_offset = 0;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief receives the fragments of a message and reassembles them
+ *
+ * @param ump   the UMP queuepair to receive on
+ * @param msg   the Smelt message to receive in
+ *
+ * @returns SMLT_SUCCESS if the message was received, SMLT_ERR_QUEUE_EMPTY if
+ *          the queue ran empty before the last fragment arrived or
+ *          SMLT_ERR_MSG_TRUNCATED if the message did not fit into the buffer
+ *          of msg.
+ *
+ * The next fragment must be pending on the receive queue. All fragments are
+ * consumed, even if they do not fit into the message buffer. The progress of
+ * a partially received message is kept in the queuepair.
+ */
+static errval_t smlt_ump_queuepair_recv_frag(struct smlt_ump_queuepair *ump,
+                                             struct smlt_msg *msg)
+{
+    volatile struct smlt_ump_message *m;
+    volatile smlt_ump_payload_word_t *src;
+    uint32_t words;
+
+    uint32_t capacity = msg->bufsize / sizeof(smlt_msg_payload_t);
+    if (msg->data == NULL) {
+        capacity = 0;
+    }
+
+    m = smlt_ump_queue_peek(&ump->rx);
+
+    if (ump->rx_frag_offset == 0) {
+        ump->rx_frag_words = m->data[0];
+        words = SMLT_UMP_FRAG_HEAD_WORDS;
+        src = &m->data[1];
+    } else {
+        words = SMLT_UMP_PAYLOAD_WORDS;
+        src = m->data;
+    }
+
+    uint32_t total = ump->rx_frag_words;
+
+    while (true) {
+        uint32_t offset = ump->rx_frag_offset;
+        if (words > total - offset) {
+            words = total - offset;
+        }
+
+        for (uint32_t i = 0; i < words && (offset + i) < capacity; i++) {
+            msg->data[offset + i] = src[i];
+        }
+
+        smlt_ump_queue_recv_raw(&ump->rx, NULL);
+
+        ump->rx_frag_offset += words;
+        if (ump->rx_frag_offset == total) {
+            break;
+        }
+
+        if (!smlt_ump_queuepair_can_recv_raw(ump)) {
+            return SMLT_ERR_QUEUE_EMPTY;
+        }
+
+        m = smlt_ump_queue_peek(&ump->rx);
+        words = SMLT_UMP_PAYLOAD_WORDS;
+        src = m->data;
+    }
+
+    ump->rx_frag_offset = 0;
+
+    if (total > capacity) {
+        msg->words = capacity;
+        return SMLT_ERR_MSG_TRUNCATED;
+    }
+
+    msg->words = total;
+
     return SMLT_SUCCESS;
 }
 
@@ -121,6 +306,10 @@ errval_t smlt_ump_queuepair_try_send(struct smlt_qp *qp,
 
     struct smlt_ump_queuepair *ump = &qp->q.ump;
 
+    if (ump->tx_frag_offset || msg->words > SMLT_UMP_PAYLOAD_WORDS) {
+        return smlt_ump_queuepair_send_frag(ump, msg);
+    }
+
     err = smlt_ump_queuepair_prepare_send(ump, &m);
     if (smlt_err_is_fail(err)) {
         return SMLT_ERR_QUEUE_FULL;
@@ -132,17 +321,91 @@ errval_t smlt_ump_queuepair_try_send(struct smlt_qp *qp,
 
     return smlt_ump_queuepair_send_raw(ump, m);
 }
+
+/**
+ * @brief sends a batch of messages on the queuepair
+ *
+ * @param qp      The smelt queuepair to send on
+ * @param msgs    array of Smelt messages to send
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages sent
+ *
+ * @returns SMLT_SUCCESS if at least one message was sent,
+ *          SMLT_ERR_QUEUE_FULL if none could be sent
+ */
+errval_t smlt_ump_queuepair_try_send_batch(struct smlt_qp *qp,
+                                           struct smlt_msg **msgs,
+                                           uint32_t num,
+                                           uint32_t *ret_num)
+{
+    errval_t err;
+
+    SMLT_ASSERT(qp->type == SMLT_QP_TYPE_UMP);
+
+    struct smlt_ump_queuepair *ump = &qp->q.ump;
+
+    *ret_num = 0;
+    if (num == 0) {
+        return SMLT_SUCCESS;
+    }
+
+    /* a fragmented message occupies several slots on its own */
+    if (ump->tx_frag_offset || msgs[0]->words > SMLT_UMP_PAYLOAD_WORDS) {
+        err = smlt_ump_queuepair_send_frag(ump, msgs[0]);
+        if (!smlt_err_is_fail(err)) {
+            *ret_num = 1;
+        }
+        return err;
+    }
+
+    smlt_ump_idx_t count = 0;
+    while (count < num && count < ump->tx.num_msg) {
+        struct smlt_msg *msg = msgs[count];
+
+        if (msg->words > SMLT_UMP_PAYLOAD_WORDS) {
+            break;
+        }
+
+        if (!smlt_ump_queuepair_can_send_n_raw(ump, count + 1)) {
+            break;
+        }
+
+        volatile struct smlt_ump_message *m;
+        m = smlt_ump_queue_get_nth(&ump->tx, count);
+        for (uint32_t i = 0; i < msg->words; ++i) {
+            m->data[i] = msg->data[i];
+        }
+
+        count++;
+    }
+
+    if (count == 0) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    *ret_num = count;
+
+    return smlt_ump_queuepair_send_batch_raw(ump, count);
+}
+
 /**
 * @brief sends a notification on the queuepair
 *
 * @param qp     The smelt queuepair to send on
 *
-* @returns SMELT_SUCCESS of the messessage could be sent.
+* @returns SMELT_SUCCESS of the messessage could be sent, SMLT_ERR_QUEUE_FULL
+*          if a fragmented message is partially sent and has to be completed
+*          first.
 */
 errval_t smlt_ump_queuepair_notify(struct smlt_qp *qp)
 {
     struct smlt_ump_queuepair *ump = &qp->q.ump;
 
+    /* the slot would be taken for a fragment of the pending message */
+    if (ump->tx_frag_offset) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
     while(!smlt_ump_queuepair_can_send_raw(ump))
         ;
 
@@ -154,11 +417,67 @@ errval_t smlt_ump_queuepair_notify(struct smlt_qp *qp)
 *
 * @param qp     The smelt queuepair to send on
 *
-* @returns TRUE if a message can be sent, FALSE otherwise
+* @returns TRUE if a message can be sent, FALSE otherwise or if a fragmented
+*          message is partially sent
 */
 bool smlt_ump_queuepair_can_send(struct smlt_qp *qp)
 {
-    return smlt_ump_queuepair_can_send_raw(&qp->q.ump);
+    struct smlt_ump_queuepair *ump = &qp->q.ump;
+
+    if (ump->tx_frag_offset) {
+        return false;
+    }
+
+    return smlt_ump_queuepair_can_send_raw(ump);
+}
+
+/**
+ * @brief obtains the payload of the next message slot to write into
+ *
+ * @param qp     The smelt queuepair to send on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_QUEUE_FULL if there is no free slot or
+ *          a fragmented message is partially sent
+ */
+errval_t smlt_ump_queuepair_try_send_prepare(struct smlt_qp *qp,
+                                             smlt_msg_payload_t **data,
+                                             uint32_t *words)
+{
+    errval_t err;
+    struct smlt_ump_message *m;
+
+    if (qp->q.ump.tx_frag_offset) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    err = smlt_ump_queuepair_prepare_send(&qp->q.ump, &m);
+    if (smlt_err_is_fail(err)) {
+        return SMLT_ERR_QUEUE_FULL;
+    }
+
+    *data = m->data;
+    *words = SMLT_UMP_PAYLOAD_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief sends the prepared message slot
+ *
+ * @param qp     The smelt queuepair to send on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ump_queuepair_send_commit(struct smlt_qp *qp)
+{
+    struct smlt_ump_queuepair *ump = &qp->q.ump;
+    struct smlt_ump_message *m;
+
+    m = (struct smlt_ump_message *)smlt_ump_queue_get_next(&ump->tx);
+
+    return smlt_ump_queuepair_send_raw(ump, m);
 }
 
 
@@ -173,22 +492,103 @@ bool smlt_ump_queuepair_can_send(struct smlt_qp *qp)
 errval_t smlt_ump_queuepair_try_recv(struct smlt_qp *qp,
                                      struct smlt_msg *msg)
 {
-    errval_t err;
-    struct smlt_ump_message *m;
+    volatile struct smlt_ump_message *m;
 
     SMLT_ASSERT(qp->type == SMLT_QP_TYPE_UMP);
 
     struct smlt_ump_queuepair *ump = &qp->q.ump;
 
-    err =  smlt_ump_queuepair_recv_raw(ump, &m);
-    if (smlt_err_is_fail(err)) {
-        return err;
+    if (!smlt_ump_queuepair_can_recv_raw(ump)) {
+        return SMLT_ERR_QUEUE_EMPTY;
     }
 
-    for (uint32_t i = 0; i < msg->words; ++i) {
+    m = smlt_ump_queue_peek(&ump->rx);
+    if (ump->rx_frag_offset || smlt_ump_message_is_frag(m)) {
+        return smlt_ump_queuepair_recv_frag(ump, msg);
+    }
+
+    /* copy the payload before the slot is acknowledged */
+    uint32_t words = msg->words;
+    if (words > SMLT_UMP_PAYLOAD_WORDS) {
+        words = SMLT_UMP_PAYLOAD_WORDS;
+    }
+
+    for (uint32_t i = 0; i < words; ++i) {
         msg->data[i] = m->data[i];
     }
 
+    msg->words = words;
+
+    return smlt_ump_queue_recv_raw(&ump->rx, NULL);
+}
+
+/**
+ * @brief receives a batch of messages on the queuepair
+ *
+ * @param qp      The smelt queuepair to receive on
+ * @param msgs    array of Smelt messages to receive in
+ * @param num     number of messages in the array
+ * @param ret_num returns the number of messages received
+ *
+ * @returns SMLT_SUCCESS if at least one message was received,
+ *          SMLT_ERR_QUEUE_EMPTY if there was no message
+ */
+errval_t smlt_ump_queuepair_try_recv_batch(struct smlt_qp *qp,
+                                           struct smlt_msg **msgs,
+                                           uint32_t num,
+                                           uint32_t *ret_num)
+{
+    volatile struct smlt_ump_message *m;
+
+    SMLT_ASSERT(qp->type == SMLT_QP_TYPE_UMP);
+
+    struct smlt_ump_queuepair *ump = &qp->q.ump;
+
+    *ret_num = 0;
+    if (num == 0) {
+        return SMLT_SUCCESS;
+    }
+
+    if (!smlt_ump_queuepair_can_recv_raw(ump)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    /* a fragmented message is reassembled on its own */
+    m = smlt_ump_queue_peek(&ump->rx);
+    if (ump->rx_frag_offset || smlt_ump_message_is_frag(m)) {
+        errval_t err = smlt_ump_queuepair_recv_frag(ump, msgs[0]);
+        if (err != SMLT_ERR_QUEUE_EMPTY) {
+            *ret_num = 1;
+        }
+        return err;
+    }
+
+    smlt_ump_idx_t count = 0;
+    while (count < num && count < ump->rx.num_msg) {
+        m = smlt_ump_queue_peek_nth(&ump->rx, count);
+        if (m == NULL || smlt_ump_message_is_frag(m)) {
+            break;
+        }
+
+        /* copy the payload before the slots are acknowledged */
+        struct smlt_msg *msg = msgs[count];
+        uint32_t words = msg->words;
+        if (words > SMLT_UMP_PAYLOAD_WORDS) {
+            words = SMLT_UMP_PAYLOAD_WORDS;
+        }
+
+        for (uint32_t i = 0; i < words; ++i) {
+            msg->data[i] = m->data[i];
+        }
+
+        msg->words = words;
+        count++;
+    }
+
+    smlt_ump_queue_recv_batch_raw(&ump->rx, count);
+
+    *ret_num = count;
+
     return SMLT_SUCCESS;
 }
 
@@ -219,3 +619,48 @@ bool smlt_ump_queuepair_can_recv(struct smlt_qp *qp)
 {
     return smlt_ump_queuepair_can_recv_raw(&qp->q.ump);
 }
+
+/**
+ * @brief lends the payload of the next message slot
+ *
+ * @param qp     The smelt queuepair to receive on
+ * @param data   returns the pointer to the payload of the slot
+ * @param words  returns the number of payload words in the slot
+ *
+ * @returns SMLT_SUCCESS if the slot is lent, SMLT_ERR_QUEUE_EMPTY if there is
+ *          no message or SMLT_ERR_MSG_FRAGMENTED for fragmented messages
+ */
+errval_t smlt_ump_queuepair_try_recv_borrow(struct smlt_qp *qp,
+                                            const smlt_msg_payload_t **data,
+                                            uint32_t *words)
+{
+    volatile struct smlt_ump_message *m;
+
+    struct smlt_ump_queuepair *ump = &qp->q.ump;
+
+    if (!smlt_ump_queuepair_can_recv_raw(ump)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    m = smlt_ump_queue_peek(&ump->rx);
+    if (ump->rx_frag_offset || smlt_ump_message_is_frag(m)) {
+        return SMLT_ERR_MSG_FRAGMENTED;
+    }
+
+    *data = (const smlt_msg_payload_t *)m->data;
+    *words = SMLT_UMP_PAYLOAD_WORDS;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief releases the lent message slot and acknowledges it
+ *
+ * @param qp     The smelt queuepair to receive on
+ *
+ * @returns SMELT_SUCCESS or error value
+ */
+errval_t smlt_ump_queuepair_recv_release(struct smlt_qp *qp)
+{
+    return smlt_ump_queue_recv_raw(&qp->q.ump.rx, NULL);
+}
@@ -11,8 +11,10 @@
 #include <smlt.h>
 #include <smlt_barrier.h>
 #include <smlt_channel.h>
+#include <smlt_context.h>
 #include <smlt_reduction.h>
 #include <smlt_broadcast.h>
+#include <smlt_request.h>
 #include <shm/smlt_shm.h>
 
 struct smlt_dissem_barrier {
@@ -64,6 +66,101 @@ errval_t smlt_barrier_wait(struct smlt_context *ctx)
     return smlt_broadcast_notify(ctx);
 }
 
+/**
+ * @brief advances a non-blocking barrier
+ *
+ * The notifications are reduced to the root first, the request then
+ * continues as the broadcast of the notification from the root.
+ */
+static errval_t smlt_ibarrier_progress(struct smlt_request *req)
+{
+    errval_t err;
+
+    err = smlt_reduce_progress(req);
+    if (smlt_err_is_fail(err) || !req->done) {
+        return err;
+    }
+
+    req->done = false;
+    req->state = 0;
+    req->pos = 0;
+    req->progress = smlt_broadcast_progress;
+
+    return smlt_broadcast_progress(req);
+}
+
+/**
+ * @brief enters the barrier without waiting for the other nodes
+ *
+ * @param ctx    the Smelt context
+ * @param req    returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_ibarrier(struct smlt_context *ctx, struct smlt_request **req)
+{
+    errval_t err;
+
+    if (req == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_request_start(ctx, smlt_ibarrier_progress, req);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    /* errors are reported by smlt_test() and smlt_wait() */
+    smlt_progress();
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief signals that the node has arrived at the barrier
+ *
+ * @param ctx    the Smelt context
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ */
+errval_t smlt_barrier_arrive(struct smlt_context *ctx)
+{
+    errval_t err;
+
+    if (smlt_context_get_barrier_request(ctx) != NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_request *req;
+    err = smlt_ibarrier(ctx, &req);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    smlt_context_set_barrier_request(ctx, req);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief waits until all nodes have arrived at the barrier
+ *
+ * @param ctx    the Smelt context
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ */
+errval_t smlt_barrier_depart(struct smlt_context *ctx)
+{
+    struct smlt_request *req = smlt_context_get_barrier_request(ctx);
+    if (req == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    smlt_context_set_barrier_request(ctx, NULL);
+
+    return smlt_wait(req);
+}
+
 errval_t smlt_dissem_barrier_init(uint32_t* cores, uint32_t num_cores,
                                   struct smlt_dissem_barrier** bar)
 {
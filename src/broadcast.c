@@ -10,6 +10,7 @@
 #include <smlt_channel.h>
 #include <smlt_context.h>
 #include <smlt_broadcast.h>
+#include <smlt_request.h>
 #include "smlt_debug.h"
 
 /**
@@ -126,6 +127,97 @@ errval_t smlt_broadcast(struct smlt_context *ctx,
 }
 
 
+/**
+ * @brief forwards the message to the children in chunks, receiving each
+ *        chunk from the parent first unless parent is NULL
+ */
+static errval_t smlt_broadcast_pipelined_from(struct smlt_context *ctx,
+                                              struct smlt_channel *parent,
+                                              struct smlt_msg *msg)
+{
+    errval_t err;
+
+    uint32_t count = 0;
+    struct smlt_channel *children;
+    err =  smlt_context_get_children_channels(ctx, &children, &count);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t idx = smlt_context_node_get_child_idx(ctx);
+
+    for (uint32_t offset = 0; offset < msg->words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        uint32_t words = msg->words - offset;
+        if (words > SMLT_MSG_CHUNK_WORDS) {
+            words = SMLT_MSG_CHUNK_WORDS;
+        }
+
+        struct smlt_msg chunk = {
+            .words = words,
+            .bufsize = words * sizeof(smlt_msg_payload_t),
+            .data = msg->data + offset
+        };
+
+        if (parent) {
+            err = smlt_channel_recv_index(parent, &chunk, idx);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i) {
+            err = smlt_channel_send(&children[i], &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief performs a pipelined broadcast to the nodes of the subtree rooted
+ *        at the calling node
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   the message to send
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_broadcast_pipelined_subtree(struct smlt_context *ctx,
+                                          struct smlt_msg *msg)
+{
+    return smlt_broadcast_pipelined_from(ctx, NULL, msg);
+}
+
+/**
+ * @brief performs a broadcast to all nodes, forwarding the message down the
+ *        tree in chunks
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   the message to send on the root, returns it on the others
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_broadcast_pipelined(struct smlt_context *ctx,
+                                  struct smlt_msg *msg)
+{
+    errval_t err;
+
+    struct smlt_channel *parent = NULL;
+    if (!smlt_context_is_root(ctx)) {
+        err =  smlt_context_get_parent_channel(ctx, &parent);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return smlt_broadcast_pipelined_from(ctx, parent, msg);
+}
+
+
 /**
  * @brief checks if the node can recv from his parent
  * 
@@ -186,6 +278,104 @@ errval_t smlt_broadcast_notify(struct smlt_context *ctx)
     }
 }
 
+
+/*
+ * ===========================================================================
+ * Non-blocking broadcast
+ * ===========================================================================
+ */
+
+/// phases of a non-blocking broadcast
+enum {
+    SMLT_IBROADCAST_RECV = 0,   ///< waiting for the message of the parent
+    SMLT_IBROADCAST_SEND,       ///< forwarding the message to the children
+};
+
+/**
+ * @brief advances a non-blocking broadcast
+ *
+ * @param req   the request of the broadcast
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_broadcast_progress(struct smlt_request *req)
+{
+    errval_t err;
+
+    struct smlt_context *ctx = req->ctx;
+
+    if (req->state == SMLT_IBROADCAST_RECV) {
+        if (!smlt_context_is_root(ctx)) {
+            struct smlt_channel *parent;
+            err =  smlt_context_get_parent_channel(ctx, &parent);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            uint32_t idx = smlt_context_node_get_child_idx(ctx);
+            if (!smlt_channel_can_recv_index(parent, idx)) {
+                return SMLT_SUCCESS;
+            }
+
+            if (req->msg) {
+                err = smlt_channel_recv_index(parent, req->msg, idx);
+            } else {
+                err = smlt_channel_recv_notification(parent);
+            }
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        req->state = SMLT_IBROADCAST_SEND;
+    }
+
+    if (req->msg) {
+        err = smlt_broadcast_subtree(ctx, req->msg);
+    } else {
+        err = smlt_broadcast_notify_subtree(ctx);
+    }
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    req->done = true;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief starts a broadcast to all nodes without waiting for it
+ *
+ * @param ctx   the Smelt context to broadcast on
+ * @param msg   input for the broadcast, or NULL for a notification
+ * @param req   returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+errval_t smlt_ibroadcast(struct smlt_context *ctx,
+                         struct smlt_msg *msg,
+                         struct smlt_request **req)
+{
+    errval_t err;
+
+    if (req == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_request_start(ctx, smlt_broadcast_progress, req);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    (*req)->msg = msg;
+
+    /* errors are reported by smlt_test() and smlt_wait() */
+    smlt_progress();
+
+    return SMLT_SUCCESS;
+}
+
 #if 0
 /**
  * \brief
@@ -12,6 +12,10 @@
 #include <smlt_queuepair.h>
 #include <smlt_channel.h>
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
 
 /*
  * ===========================================================================
@@ -19,6 +23,59 @@
  * ===========================================================================
  */
 
+/**
+ * @brief applies the per-queuepair attributes to both ends of a queuepair
+ */
+static errval_t smlt_channel_qp_apply_attr(struct smlt_qp *qp1,
+                                           struct smlt_qp *qp2,
+                                           struct smlt_channel_attr *attr)
+{
+    errval_t err;
+
+    if (qp1->type != SMLT_QP_TYPE_UMP) {
+        return SMLT_SUCCESS;
+    }
+
+    err = smlt_ump_queuepair_set_ack_policy(&qp1->q.ump, attr->ack_policy,
+                                            attr->ack_interval);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    return smlt_ump_queuepair_set_ack_policy(&qp2->q.ump, attr->ack_policy,
+                                             attr->ack_interval);
+}
+
+/**
+ * @brief initializes the channel attributes with the default values
+ *
+ * @param attr  the channel attributes to initialize
+ */
+void smlt_channel_attr_init(struct smlt_channel_attr *attr)
+{
+    attr->backend = SMLT_QP_TYPE_UMP;
+    attr->ack_policy = SMLT_UMP_ACK_HALF_WINDOW;
+    attr->ack_interval = 0;
+    attr->num_slots = 0;
+    attr->swmr_queue_size = 0;
+
+    char *backend = getenv("SMLT_BACKEND");
+    if (backend == NULL) {
+        return;
+    }
+
+    if (!strcmp(backend, "ump")) {
+        attr->backend = SMLT_QP_TYPE_UMP;
+    } else if (!strcmp(backend, "ffq")) {
+        attr->backend = SMLT_QP_TYPE_FFQ;
+    } else if (!strcmp(backend, "shm")) {
+        attr->backend = SMLT_QP_TYPE_SHM;
+    } else {
+        fprintf(stderr, "SMLT_BACKEND: unknown backend '%s', using ump\n",
+                backend);
+    }
+}
+
  /**
   * @brief creates the queue pair
   *
@@ -36,6 +93,41 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
                              uint16_t count_src,
                              uint16_t count_dst)
 {
+    return smlt_channel_create_with_attr(chan, src, dst, count_src,
+                                         count_dst, NULL);
+}
+
+ /**
+  * @brief creates the queue pair using the given attributes
+  *
+  * @param chan     return pointer to the channel
+  * @param src      src core ids
+  * @param dst      array of core ids to desinations
+  * @param count_src    length of array src;
+  * @param count_dst    length of array dst;
+  * @param attr     channel attributes, NULL for the defaults
+  *
+  * @returns SMLT_SUCCESS or failure
+  */
+errval_t smlt_channel_create_with_attr(struct smlt_channel **chan,
+                                       uint32_t* src,
+                                       uint32_t* dst,
+                                       uint16_t count_src,
+                                       uint16_t count_dst,
+                                       struct smlt_channel_attr *attr)
+{
+    struct smlt_channel_attr default_attr;
+    if (attr == NULL) {
+        smlt_channel_attr_init(&default_attr);
+        attr = &default_attr;
+    }
+
+    if (attr->backend != SMLT_QP_TYPE_UMP &&
+        attr->backend != SMLT_QP_TYPE_FFQ &&
+        attr->backend != SMLT_QP_TYPE_SHM) {
+        return SMLT_ERR_INVAL;
+    }
+
     uint32_t num_chan = (count_src > count_dst) ? count_src : count_dst;
 
     assert(*chan);
@@ -69,24 +161,35 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
                                 struct smlt_qp* recv = &((*chan)->c.mp.recv[0]);
             #endif
 
-            err = smlt_queuepair_create(SMLT_QP_TYPE_UMP,
-                                    &(*chan)->c.mp.send, &(*chan)->c.mp.recv, src[0], dst[0]);
+            (*chan)->c.mp.send = NULL;
+            (*chan)->c.mp.recv = NULL;
+            err = smlt_queuepair_create_sized(attr->backend,
+                                              &(*chan)->c.mp.send,
+                                              &(*chan)->c.mp.recv,
+                                              src[0], dst[0], attr->num_slots);
+            if (smlt_err_is_fail(err)) {
+                goto err_destroy;
+            }
+
+            err = smlt_channel_qp_apply_attr((*chan)->c.mp.send,
+                                             (*chan)->c.mp.recv, attr);
             if (smlt_err_is_fail(err)) {
-                return smlt_err_push(err, SMLT_ERR_CHAN_CREATE);
+                goto err_destroy;
             }
     } else {
         // 1:n
         (*chan)->use_shm = true;
+        memset(&(*chan)->c.shm, 0, sizeof((*chan)->c.shm));
         struct swmr_queue* send = &((*chan)->c.shm.send_owner);
-        swmr_queue_create(&send, src[0], dst, num_chan, false);
+        err = swmr_queue_create_sized(&send, src[0], dst, num_chan, false,
+                                      attr->swmr_queue_size);
+        if (smlt_err_is_fail(err)) {
+            goto err_destroy;
+        }
 
         ((*chan)->c.shm.dst) = (uint32_t*) smlt_platform_alloc(sizeof(uint32_t)*
                                             count_dst, SMLT_DEFAULT_ALIGNMENT, true);
 
-        for (int i = 0; i < count_dst; i++) {
-            (*chan)->c.shm.dst[i] = dst[i];
-        }
-
         ((*chan)->c.shm.recv) = (struct smlt_qp**) smlt_platform_alloc(
                             sizeof(struct smlt_qp)*num_chan,
                             SMLT_DEFAULT_ALIGNMENT, true);
@@ -95,39 +198,102 @@ errval_t smlt_channel_create(struct smlt_channel **chan,
                                                 sizeof(struct smlt_qp)*num_chan,
                                                 SMLT_DEFAULT_ALIGNMENT, true);
 
+        if ((*chan)->c.shm.dst == NULL || (*chan)->c.shm.recv == NULL ||
+            (*chan)->c.shm.recv_owner == NULL) {
+            err = SMLT_ERR_MALLOC_FAIL;
+            goto err_destroy;
+        }
+
+        for (int i = 0; i < count_dst; i++) {
+            (*chan)->c.shm.dst[i] = dst[i];
+        }
+
         for (unsigned int i = 0; i < num_chan; i++) {
-            err = smlt_queuepair_create(SMLT_QP_TYPE_UMP,
-                                        &((*chan)->c.shm.recv[i]),
-                                        &((*chan)->c.shm.recv_owner[i]),
-                                        src[0], dst[i]);
+            err = smlt_queuepair_create_sized(attr->backend,
+                                              &((*chan)->c.shm.recv[i]),
+                                              &((*chan)->c.shm.recv_owner[i]),
+                                              src[0], dst[i], attr->num_slots);
             if (smlt_err_is_fail(err)) {
-                return smlt_err_push(err, SMLT_ERR_CHAN_CREATE);
+                goto err_destroy;
+            }
+
+            err = smlt_channel_qp_apply_attr((*chan)->c.shm.recv[i],
+                                             (*chan)->c.shm.recv_owner[i],
+                                             attr);
+            if (smlt_err_is_fail(err)) {
+                goto err_destroy;
             }
         }
     }
     return SMLT_SUCCESS;
+
+    err_destroy:
+    smlt_channel_destroy(*chan);
+    return smlt_err_push(err, SMLT_ERR_CHAN_CREATE);
 }
 
  /**
-  * @brief destroys the channel
+  * @brief destroys the queuepairs and the queue of the channel
+  *
+  * @param chan     the channel to destroy, it may be partially created
   *
-  * @param
+  * The memory of the channel itself belongs to the caller.
   *
-  * @returns 0
+  * @returns SMLT_SUCCESS or failure
   */
 errval_t smlt_channel_destroy(struct smlt_channel *chan)
 {
     uint32_t num_chan = (chan->m > chan->n) ? chan->m : chan->n;
 
-    errval_t err;
-    // TODO adapt to SWMR
-    for (unsigned int i = 0; i < num_chan; i++) {
-            err = smlt_queuepair_destroy(&chan->c.mp.send[i]);
+    errval_t err, ret = SMLT_SUCCESS;
+    if (!chan->use_shm) {
+        // 1:1
+        if (chan->c.mp.send) {
+            err = smlt_queuepair_destroy(chan->c.mp.send);
+            if (smlt_err_is_fail(err)) {
+                ret = err;
+            }
+        }
+        if (chan->c.mp.recv) {
+            err = smlt_queuepair_destroy(chan->c.mp.recv);
             if (smlt_err_is_fail(err)) {
-                return smlt_err_push(err, SMLT_ERR_CHAN_DESTROY);
+                ret = err;
+            }
+        }
+        chan->c.mp.send = NULL;
+        chan->c.mp.recv = NULL;
+    } else {
+        // 1:n
+        for (unsigned int i = 0; i < num_chan; i++) {
+            if (chan->c.shm.recv && chan->c.shm.recv[i]) {
+                err = smlt_queuepair_destroy(chan->c.shm.recv[i]);
+                if (smlt_err_is_fail(err)) {
+                    ret = err;
+                }
+            }
+            if (chan->c.shm.recv_owner && chan->c.shm.recv_owner[i]) {
+                err = smlt_queuepair_destroy(chan->c.shm.recv_owner[i]);
+                if (smlt_err_is_fail(err)) {
+                    ret = err;
+                }
             }
-            smlt_platform_free(chan->c.mp.send);
-            smlt_platform_free(chan->c.mp.recv);
+        }
+
+        if (chan->c.shm.recv) {
+            smlt_platform_free(chan->c.shm.recv);
+        }
+        if (chan->c.shm.recv_owner) {
+            smlt_platform_free(chan->c.shm.recv_owner);
+        }
+        if (chan->c.shm.dst) {
+            smlt_platform_free(chan->c.shm.dst);
+        }
+        swmr_queue_destroy(&chan->c.shm.send_owner);
+        memset(&chan->c.shm, 0, sizeof(chan->c.shm));
+    }
+
+    if (smlt_err_is_fail(ret)) {
+        return smlt_err_push(ret, SMLT_ERR_CHAN_DESTROY);
     }
     return SMLT_SUCCESS;
 }
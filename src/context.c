@@ -11,6 +11,7 @@
 #include <smlt_topology.h>
 #include <smlt_context.h>
 #include <smlt_channel.h>
+#include <smlt_autotune.h>
 #include "smlt_debug.h"
 
 #include <stdio.h>
@@ -31,6 +32,15 @@ struct smlt_context_node
     struct smlt_channel *children;
     uint32_t num_children;
     uint32_t index;
+    uint32_t island_idx;       ///< index of the island headed by this node
+    uint32_t rank;             ///< position in the depth first traversal
+    uint32_t subtree_size;     ///< number of nodes in the subtree
+    struct smlt_qp **sources;  ///< queuepairs the children send on
+    uint32_t *source_sizes;    ///< subtree size of the child of each source
+    uint32_t num_sources;
+    uint32_t parent_rank;      ///< first rank served by the parent channel
+    uint32_t parent_num;       ///< number of nodes served by the parent channel
+    struct smlt_request *barrier_req;  ///< split barrier the node arrived at
 };
 
 /**
@@ -43,6 +53,9 @@ struct smlt_context
     uint32_t num_nodes;
     smlt_nid_t max_nid;
     struct smlt_context_node **nid_to_node;
+    smlt_nid_t *island_heads;  ///< head node of each island
+    uint32_t num_islands;
+    struct smlt_context_node **rank_to_node;
     struct smlt_context_node all_nodes[];
 };
 
@@ -54,6 +67,205 @@ struct smlt_context
  */
 
 
+/**
+ * @brief enumerates the shared memory groups as the islands
+ *
+ * The children on the shared memory channel of a node belong to the island
+ * of that node, every other node heads an island. The root heads the first.
+ */
+static errval_t smlt_context_find_islands(struct smlt_context *ctx)
+{
+    struct smlt_context_node *root = NULL;
+
+    for (uint32_t i = 0; i < ctx->num_nodes; i++) {
+        ctx->all_nodes[i].island_idx = SMLT_CONTEXT_IDX_INVALID;
+        if (ctx->all_nodes[i].parent == NULL) {
+            root = &ctx->all_nodes[i];
+        }
+    }
+
+    if (root == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    ctx->island_heads = (smlt_nid_t*) smlt_platform_alloc\
+        (ctx->num_nodes * sizeof(smlt_nid_t),
+         SMLT_ARCH_CACHELINE_SIZE, true);
+    if (ctx->island_heads == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    root->island_idx = 0;
+    ctx->island_heads[0] = root->node_id;
+    ctx->num_islands = 1;
+
+    for (uint32_t i = 0; i < ctx->num_nodes; i++) {
+        struct smlt_context_node *n = &ctx->all_nodes[i];
+        if (n != root && !n->parent->use_shm) {
+            n->island_idx = ctx->num_islands;
+            ctx->island_heads[ctx->num_islands++] = n->node_id;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+static uint32_t smlt_context_assign_ranks(struct smlt_context *ctx,
+                                          struct smlt_context_node *n,
+                                          uint32_t rank);
+
+/**
+ * @brief records the source of a child and numbers its subtree
+ */
+static struct smlt_context_node *
+smlt_context_add_source(struct smlt_context *ctx, struct smlt_context_node *n,
+                        struct smlt_qp *qp, smlt_nid_t child)
+{
+    struct smlt_context_node *c = ctx->nid_to_node[child];
+
+    n->sources[n->num_sources] = qp;
+    n->source_sizes[n->num_sources] =
+        smlt_context_assign_ranks(ctx, c, n->rank + n->subtree_size);
+    n->subtree_size += n->source_sizes[n->num_sources];
+    n->num_sources++;
+
+    c->parent_rank = c->rank;
+    c->parent_num = c->subtree_size;
+
+    return c;
+}
+
+/**
+ * @brief numbers the subtree of the node in depth first order
+ *
+ * @returns the number of nodes in the subtree
+ *
+ * The children are visited in the order of the channels, the children on
+ * the shared memory channel last. The subtree of each child occupies a
+ * contiguous range of ranks.
+ */
+static uint32_t smlt_context_assign_ranks(struct smlt_context *ctx,
+                                          struct smlt_context_node *n,
+                                          uint32_t rank)
+{
+    n->rank = rank;
+    n->subtree_size = 1;
+    n->num_sources = 0;
+    n->parent_rank = rank;
+    n->parent_num = 0;
+    ctx->rank_to_node[rank] = n;
+
+    for (uint32_t i = 0; i < n->num_children; i++) {
+        struct smlt_channel *chan = &n->children[i];
+        if (chan->use_shm) {
+            /* the children on the shared memory channel see all its data */
+            uint32_t first = n->rank + n->subtree_size;
+            struct smlt_context_node *c[chan->m];
+            for (uint32_t j = 0; j < chan->m; j++) {
+                c[j] = smlt_context_add_source(ctx, n,
+                                               chan->c.shm.recv_owner[j],
+                                               chan->c.shm.dst[j]);
+            }
+            for (uint32_t j = 0; j < chan->m; j++) {
+                c[j]->parent_rank = first;
+                c[j]->parent_num = n->rank + n->subtree_size - first;
+            }
+        } else {
+            smlt_context_add_source(ctx, n, &chan->c.mp.send[0], chan->trg);
+        }
+    }
+
+    return n->subtree_size;
+}
+
+/**
+ * @brief numbers the nodes in depth first order starting at the root
+ */
+static errval_t smlt_context_find_ranks(struct smlt_context *ctx)
+{
+    struct smlt_context_node *root = NULL;
+
+    ctx->rank_to_node = (struct smlt_context_node **) smlt_platform_alloc\
+        (ctx->num_nodes * sizeof(void *), SMLT_ARCH_CACHELINE_SIZE, true);
+    if (ctx->rank_to_node == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    for (uint32_t i = 0; i < ctx->num_nodes; i++) {
+        struct smlt_context_node *n = &ctx->all_nodes[i];
+        if (n->parent == NULL) {
+            root = n;
+        }
+
+        uint32_t num = 0;
+        for (uint32_t j = 0; j < n->num_children; j++) {
+            num += n->children[j].use_shm ? n->children[j].m : 1;
+        }
+
+        /* avoid zero sized allocations for the leaves */
+        n->sources = (struct smlt_qp **) smlt_platform_alloc\
+            ((num + 1) * sizeof(void *), SMLT_ARCH_CACHELINE_SIZE, true);
+        n->source_sizes = (uint32_t *) smlt_platform_alloc\
+            ((num + 1) * sizeof(uint32_t), SMLT_ARCH_CACHELINE_SIZE, true);
+        if (n->sources == NULL || n->source_sizes == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+    }
+
+    if (root == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (smlt_context_assign_ranks(ctx, root, 0) != ctx->num_nodes) {
+        return SMLT_ERR_INVAL;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief destroys the channels of the context and frees all of its memory
+ *
+ * The context may be partially created, the memory was zeroed on allocation.
+ */
+static errval_t smlt_context_free(struct smlt_context *ctx)
+{
+    errval_t err, ret = SMLT_SUCCESS;
+
+    for (uint32_t i = 0; i < ctx->num_nodes; i++) {
+        struct smlt_context_node *n = &ctx->all_nodes[i];
+        if (n->children) {
+            for (uint32_t j = 0; j < n->num_children; j++) {
+                err = smlt_channel_destroy(&n->children[j]);
+                if (smlt_err_is_fail(err)) {
+                    ret = err;
+                }
+            }
+            smlt_platform_free(n->children);
+        }
+        if (n->sources) {
+            smlt_platform_free(n->sources);
+        }
+        if (n->source_sizes) {
+            smlt_platform_free(n->source_sizes);
+        }
+    }
+
+    if (ctx->nid_to_node) {
+        smlt_platform_free(ctx->nid_to_node);
+    }
+    if (ctx->island_heads) {
+        smlt_platform_free(ctx->island_heads);
+    }
+    if (ctx->rank_to_node) {
+        smlt_platform_free(ctx->rank_to_node);
+    }
+
+    smlt_platform_free(ctx);
+
+    return ret;
+}
+
 /**
  * @brief creates a new smelt context from the topology
  *
@@ -66,13 +278,71 @@ struct smlt_context
 errval_t smlt_context_create(struct smlt_topology *topo,
                              struct smlt_context **ret_ctx)
 {
+    return smlt_context_create_with_attr(topo, NULL, ret_ctx);
+}
 
+/**
+ * @brief initializes the context attributes with the default values
+ *
+ * @param attr  the context attributes to initialize
+ */
+void smlt_context_attr_init(struct smlt_context_attr *attr)
+{
+    struct smlt_channel_attr chan_attr;
+    smlt_channel_attr_init(&chan_attr);
+
+    attr->backend = chan_attr.backend;
+    attr->autotune = smlt_autotune_enabled();
+    attr->max_msg_words = smlt_autotune_max_msg_words();
+    attr->ack_policy = chan_attr.ack_policy;
+    attr->ack_interval = chan_attr.ack_interval;
+    attr->num_slots = chan_attr.num_slots;
+    attr->leaf_num_slots = 0;
+    attr->swmr_queue_size = chan_attr.swmr_queue_size;
+}
+
+/**
+ * @brief creates a new smelt context from the topology using the attributes
+ *
+ * @param topo      Smelt topology to create the context from
+ * @param attr      context attributes, NULL for the defaults
+ * @param ret_ctx   returns the new Smelt context
+ *
+ * @return  SMLT_ERR_MALLOC_FAIL
+ *          SMLT_ERR_INVAL
+ *          SMLT_SUCCESS
+ */
+errval_t smlt_context_create_with_attr(struct smlt_topology *topo,
+                                       struct smlt_context_attr *attr,
+                                       struct smlt_context **ret_ctx)
+{
+    errval_t err;
     struct smlt_context *ctx;
+    struct smlt_context_attr default_attr;
+    struct smlt_channel_attr chan_attr;
 
     if (topo == NULL) {
         return SMLT_ERR_INVAL;
     }
 
+    if (attr == NULL) {
+        smlt_context_attr_init(&default_attr);
+        attr = &default_attr;
+    }
+
+    /* without a message size only UMP is safe, so nothing is measured */
+    static bool warned_max_msg_words = false;
+    if (attr->autotune && attr->max_msg_words == 0 && !warned_max_msg_words) {
+        SMLT_WARNING("autotune needs max_msg_words or SMLT_AUTOTUNE_MAX_WORDS,"
+                     " using UMP on all edges\n");
+        warned_max_msg_words = true;
+    }
+
+    chan_attr.backend = attr->backend;
+    chan_attr.ack_policy = attr->ack_policy;
+    chan_attr.ack_interval = attr->ack_interval;
+    chan_attr.swmr_queue_size = attr->swmr_queue_size;
+
     uint32_t num_nodes = smlt_topology_get_num_nodes(topo);
 
     ctx = (struct smlt_context*) smlt_platform_alloc(sizeof(*ctx) + num_nodes * sizeof(struct smlt_context_node),
@@ -92,7 +362,6 @@ errval_t smlt_context_create(struct smlt_topology *topo,
         uint32_t num_children = smlt_topology_node_get_num_children(tn);
 
         n->node_id = current_nid;
-        n->num_children = num_children;
         if (num_children) {
 
             // if we use shared memory need to allocate additional channel
@@ -100,13 +369,17 @@ errval_t smlt_context_create(struct smlt_topology *topo,
                 n->children = (struct smlt_channel*) smlt_platform_alloc\
                     ((num_children+1)* sizeof(*(n->children)),
                      SMLT_ARCH_CACHELINE_SIZE, true);
-                assert (n->children != NULL);
             } else {
                 n->children = (struct smlt_channel*) smlt_platform_alloc\
                     (num_children * sizeof(*(n->children)),
                      SMLT_ARCH_CACHELINE_SIZE, true);
-                assert (n->children != NULL);
             }
+            if (n->children == NULL) {
+                err = SMLT_ERR_MALLOC_FAIL;
+                goto err_free;
+            }
+            /* the channels are zeroed, unused ones are skipped on cleanup */
+            n->num_children = num_children;
 
             /* setup channels */
             struct smlt_topology_node **children;
@@ -116,8 +389,29 @@ errval_t smlt_context_create(struct smlt_topology *topo,
                 uint32_t dst = smlt_topology_node_get_id(children[i]);
                 uint32_t src = smlt_topology_node_get_id(tn);
                 struct smlt_channel * chan = &(n->children[i]);
-                smlt_channel_create(&chan, &src,
-                                    &dst, 1, 1);
+
+                chan_attr.num_slots = attr->num_slots;
+                if (attr->leaf_num_slots &&
+                    smlt_topology_node_is_leaf(children[i])) {
+                    chan_attr.num_slots = attr->leaf_num_slots;
+                }
+
+                chan_attr.backend = attr->backend;
+                if (attr->autotune) {
+                    err = smlt_autotune_edge(src, dst, attr->max_msg_words,
+                                             &chan_attr.backend);
+                    if (smlt_err_is_fail(err)) {
+                        SMLT_WARNING("autotune failed for edge %" PRIu32 " -> %"
+                                     PRIu32 ", using default backend\n", src, dst);
+                        chan_attr.backend = attr->backend;
+                    }
+                }
+
+                err = smlt_channel_create_with_attr(&chan, &src, &dst, 1, 1,
+                                                    &chan_attr);
+                if (smlt_err_is_fail(err)) {
+                    goto err_free;
+                }
             }
         }
 
@@ -125,7 +419,10 @@ errval_t smlt_context_create(struct smlt_topology *topo,
             n->children = (struct smlt_channel*)
                 smlt_platform_alloc(sizeof(*(n->children)),
                                     SMLT_ARCH_CACHELINE_SIZE, true);
-            assert (n->children!=NULL);
+            if (n->children == NULL) {
+                err = SMLT_ERR_MALLOC_FAIL;
+                goto err_free;
+            }
         }
 
         // shared memory children (TODO adds the shm channel at the end)
@@ -137,6 +434,10 @@ errval_t smlt_context_create(struct smlt_topology *topo,
                 children = smlt_topology_node_children_shm(tn, &num_children_shm);
                 uint32_t* dst = (uint32_t*) smlt_platform_alloc(num_children_shm*sizeof(uint32_t),
                                                     SMLT_ARCH_CACHELINE_SIZE, true);
+                if (dst == NULL) {
+                    err = SMLT_ERR_MALLOC_FAIL;
+                    goto err_free;
+                }
 
                 uint32_t src = smlt_topology_node_get_id(tn);
                 // num_children is of the MP children
@@ -145,8 +446,16 @@ errval_t smlt_context_create(struct smlt_topology *topo,
                     dst[i] = smlt_topology_node_get_id(children[i]);
                 }
 
-                smlt_channel_create(&chan, &src,
-                                    dst, 1, num_children_shm);
+                chan_attr.backend = attr->backend;
+                chan_attr.num_slots = attr->num_slots;
+                err = smlt_channel_create_with_attr(&chan, &src, dst, 1,
+                                                    num_children_shm,
+                                                    &chan_attr);
+                /* the channel keeps its own copy of the destinations */
+                smlt_platform_free(dst);
+                if (smlt_err_is_fail(err)) {
+                    goto err_free;
+                }
                 n->num_children++;
             }
         }
@@ -162,7 +471,10 @@ errval_t smlt_context_create(struct smlt_topology *topo,
     ctx->nid_to_node = (struct smlt_context_node**) smlt_platform_alloc\
         ((ctx->max_nid+1)  * sizeof(void *),
          SMLT_ARCH_CACHELINE_SIZE, true);
-    assert(ctx->nid_to_node!=NULL);
+    if (ctx->nid_to_node == NULL) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto err_free;
+    }
 
     for (uint32_t i = 0; i < num_nodes; ++i) {
         struct smlt_context_node *n = &ctx->all_nodes[i];
@@ -192,7 +504,7 @@ errval_t smlt_context_create(struct smlt_topology *topo,
             uint32_t num_children;
             children = smlt_topology_node_children_shm(tp, &num_children);
             for (unsigned j = 0; j < num_children; j++) {
-                if (smlt_topology_node_get_id(children[j]) == i) {
+                if (smlt_topology_node_get_id(children[j]) == current_nid) {
                     child_use_shm = true;
                 }
             }
@@ -210,8 +522,22 @@ errval_t smlt_context_create(struct smlt_topology *topo,
         tn = smlt_topology_node_next(tn);
     }
 
+    err = smlt_context_find_islands(ctx);
+    if (smlt_err_is_fail(err)) {
+        goto err_free;
+    }
+
+    err = smlt_context_find_ranks(ctx);
+    if (smlt_err_is_fail(err)) {
+        goto err_free;
+    }
+
     *ret_ctx = ctx;
     return SMLT_SUCCESS;
+
+    err_free:
+    smlt_context_free(ctx);
+    return err;
 }
 
 /**
@@ -219,17 +545,11 @@ errval_t smlt_context_create(struct smlt_topology *topo,
  *
  * @param ctx   Smelt context to destroy
  *
- * @return  SMLT_SUCCESS
+ * @return  SMLT_SUCCESS or error value
  */
 errval_t smlt_context_destroy(struct smlt_context *ctx)
 {
-    for (uint32_t i = 0; i < ctx->num_nodes; ++i) {
-        /* TODO: create the bindings */
-    }
-
-    smlt_platform_free(ctx);
-
-    return SMLT_SUCCESS;
+    return smlt_context_free(ctx);
 }
 
 
@@ -292,6 +612,279 @@ errval_t smlt_context_node_get_parent_channel(struct smlt_context *ctx,
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief obtains the queuepairs the children of the node send on
+ *
+ * @param ctx       Smelt context
+ * @param node      Smelt node
+ * @param ret_qps   returns the array of queuepairs
+ * @param ret_sizes returns the subtree size of the child of each queuepair
+ * @param ret_count returns the number of queuepairs
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+errval_t smlt_context_node_get_children_sources(struct smlt_context *ctx,
+                                                struct smlt_node *node,
+                                                struct smlt_qp ***ret_qps,
+                                                uint32_t **ret_sizes,
+                                                uint32_t *ret_count)
+{
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[node->id];
+
+    if (ret_qps) {
+        *ret_qps = n->sources;
+    }
+    if (ret_sizes) {
+        *ret_sizes = n->source_sizes;
+    }
+    if (ret_count) {
+        *ret_count = n->num_sources;
+    }
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Node enumeration
+ * ===========================================================================
+ */
+
+/**
+ * @brief obtains the number of nodes in the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of nodes
+ */
+uint32_t smlt_context_get_num_nodes(struct smlt_context *ctx)
+{
+    return ctx->num_nodes;
+}
+
+/**
+ * @brief obtains the id of a node in the context
+ *
+ * @param ctx   Smelt context
+ * @param idx   index of the node, smaller than smlt_context_get_num_nodes()
+ *
+ * @return the node id
+ */
+smlt_nid_t smlt_context_get_node_id(struct smlt_context *ctx, uint32_t idx)
+{
+    assert(idx < ctx->num_nodes);
+    return ctx->all_nodes[idx].node_id;
+}
+
+/**
+ * @brief obtains the index of the node in the context
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the index or SMLT_CONTEXT_IDX_INVALID if the node is not part of
+ *         the context
+ */
+uint32_t smlt_context_node_get_idx(struct smlt_context *ctx,
+                                   struct smlt_node *node)
+{
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_CONTEXT_IDX_INVALID;
+    }
+
+    return ctx->nid_to_node[node->id] - ctx->all_nodes;
+}
+
+/**
+ * @brief obtains the number of islands of the context
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of islands
+ */
+uint32_t smlt_context_get_num_islands(struct smlt_context *ctx)
+{
+    return ctx->num_islands;
+}
+
+/**
+ * @brief obtains the id of the head node of an island
+ *
+ * @param ctx   Smelt context
+ * @param idx   index of the island, the island of the root has index 0
+ *
+ * @return the node id of the head of the island
+ */
+smlt_nid_t smlt_context_get_island_head(struct smlt_context *ctx,
+                                        uint32_t idx)
+{
+    assert(idx < ctx->num_islands);
+    return ctx->island_heads[idx];
+}
+
+/**
+ * @brief obtains the island index of a node heading an island
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the index of the island or SMLT_CONTEXT_IDX_INVALID if the node
+ *         does not head an island
+ */
+uint32_t smlt_context_node_get_island_idx(struct smlt_context *ctx,
+                                          struct smlt_node *node)
+{
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_CONTEXT_IDX_INVALID;
+    }
+
+    return ctx->nid_to_node[node->id]->island_idx;
+}
+
+/**
+ * @brief obtains the head of the island the node belongs to
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the node id of the head, the id of the node if it heads the island
+ */
+smlt_nid_t smlt_context_node_get_island_head(struct smlt_context *ctx,
+                                             struct smlt_node *node)
+{
+    assert(node->id <= ctx->max_nid && ctx->nid_to_node[node->id] != NULL);
+
+    struct smlt_context_node *n = ctx->nid_to_node[node->id];
+    if (n->island_idx != SMLT_CONTEXT_IDX_INVALID) {
+        return n->node_id;
+    }
+
+    return n->parent->owner;
+}
+
+/**
+ * @brief obtains the other members of the island headed by the node
+ *
+ * @param ctx           Smelt context
+ * @param node          Smelt node heading the island
+ * @param ret_members   returns the node ids of the members
+ * @param ret_count     returns the number of members
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL if the node does not head an island
+ */
+errval_t smlt_context_node_get_island_members(struct smlt_context *ctx,
+                                              struct smlt_node *node,
+                                              smlt_nid_t **ret_members,
+                                              uint32_t *ret_count)
+{
+    if (smlt_context_node_get_island_idx(ctx, node) == SMLT_CONTEXT_IDX_INVALID) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_context_node *n = ctx->nid_to_node[node->id];
+
+    /* the shared memory channel is the last one */
+    *ret_members = NULL;
+    *ret_count = 0;
+    if (n->num_children && n->children[n->num_children - 1].use_shm) {
+        struct smlt_channel *chan = &n->children[n->num_children - 1];
+        *ret_members = chan->c.shm.dst;
+        *ret_count = chan->m;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the rank of the node in the context
+ *
+ * @param ctx   Smelt context
+ * @param node  Smelt node
+ *
+ * @return the rank or SMLT_CONTEXT_IDX_INVALID if the node is not part of
+ *         the context
+ */
+uint32_t smlt_context_node_get_rank(struct smlt_context *ctx,
+                                    struct smlt_node *node)
+{
+    if (ctx->max_nid < node->id || ctx->nid_to_node[node->id] == NULL) {
+        return SMLT_CONTEXT_IDX_INVALID;
+    }
+
+    return ctx->nid_to_node[node->id]->rank;
+}
+
+/**
+ * @brief obtains the id of the node with the given rank
+ *
+ * @param ctx   Smelt context
+ * @param rank  rank of the node, smaller than smlt_context_get_num_nodes()
+ *
+ * @return the node id
+ */
+smlt_nid_t smlt_context_get_node_id_by_rank(struct smlt_context *ctx,
+                                            uint32_t rank)
+{
+    assert(rank < ctx->num_nodes);
+    return ctx->rank_to_node[rank]->node_id;
+}
+
+/**
+ * @brief obtains the nodes served by the channel to the parent
+ *
+ * @param ctx       Smelt context
+ * @param ret_rank  returns the first rank served by the channel
+ * @param ret_num   returns the number of nodes served by the channel
+ */
+void smlt_context_get_parent_ranks(struct smlt_context *ctx,
+                                   uint32_t *ret_rank, uint32_t *ret_num)
+{
+    struct smlt_context_node *n = ctx->nid_to_node[smlt_node_self_id];
+
+    *ret_rank = n->parent_rank;
+    *ret_num = n->parent_num;
+}
+
+/**
+ * @brief obtains the split barrier the current node has arrived at
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the request of the barrier or NULL
+ */
+struct smlt_request *smlt_context_get_barrier_request(struct smlt_context *ctx)
+{
+    return ctx->nid_to_node[smlt_node_self_id]->barrier_req;
+}
+
+/**
+ * @brief records the split barrier the current node has arrived at
+ *
+ * @param ctx   Smelt context
+ * @param req   the request of the barrier, NULL once the node departed
+ */
+void smlt_context_set_barrier_request(struct smlt_context *ctx,
+                                      struct smlt_request *req)
+{
+    ctx->nid_to_node[smlt_node_self_id]->barrier_req = req;
+}
+
+/**
+ * @brief obtains the number of nodes in the subtree of the current node
+ *
+ * @param ctx   Smelt context
+ *
+ * @return the number of nodes including the current node
+ */
+uint32_t smlt_context_get_subtree_size(struct smlt_context *ctx)
+{
+    return ctx->nid_to_node[smlt_node_self_id]->subtree_size;
+}
+
 
 /*
  * ===========================================================================
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_broadcast.h>
+#include <smlt_gather.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/// holds the blocks of the subtree on the nodes other than the root
+static __thread struct smlt_msg *smlt_gather_scratch = NULL;
+
+/**
+ * @brief returns the subtree buffer, growing it to hold at least bufsize bytes
+ */
+static struct smlt_msg *smlt_gather_get_scratch(uint32_t bufsize)
+{
+    if (smlt_gather_scratch && smlt_gather_scratch->bufsize < bufsize) {
+        smlt_message_free(smlt_gather_scratch);
+        smlt_gather_scratch = NULL;
+    }
+
+    if (smlt_gather_scratch == NULL) {
+        smlt_gather_scratch = smlt_message_alloc(bufsize);
+    }
+
+    return smlt_gather_scratch;
+}
+
+/**
+ * @brief obtains a view of a chunk of the buffer
+ */
+static inline struct smlt_msg smlt_gather_chunk(struct smlt_msg *buf,
+                                                uint32_t offset,
+                                                uint32_t end)
+{
+    uint32_t words = end - offset;
+    if (words > SMLT_MSG_CHUNK_WORDS) {
+        words = SMLT_MSG_CHUNK_WORDS;
+    }
+
+    struct smlt_msg chunk = {
+        .words = words,
+        .bufsize = words * sizeof(smlt_msg_payload_t),
+        .data = buf->data + offset
+    };
+
+    return chunk;
+}
+
+/**
+ * @brief receives the blocks of the children's subtrees into the buffer
+ *
+ * @param ctx       The smelt context
+ * @param buf       the buffer, the block of this node comes first
+ * @param words     number of words of a block
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The subtrees are received chunk by chunk from whichever child has data.
+ */
+static errval_t smlt_gather_recv_children(struct smlt_context *ctx,
+                                          struct smlt_msg *buf,
+                                          uint32_t words)
+{
+    errval_t err;
+
+    struct smlt_qp **qps;
+    uint32_t *sizes;
+    uint32_t num_src;
+    err = smlt_context_get_children_sources(ctx, &qps, &sizes, &num_src);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (num_src == 0) {
+        return SMLT_SUCCESS;
+    }
+
+    uint32_t pos[num_src];
+    uint32_t end[num_src];
+
+    uint32_t offset = words;
+    for (uint32_t i = 0; i < num_src; i++) {
+        pos[i] = offset;
+        offset += sizes[i] * words;
+        end[i] = offset;
+    }
+
+    uint32_t num_done = 0;
+    uint32_t i = 0;
+    while (num_done < num_src) {
+        if (pos[i] < end[i] && smlt_queuepair_can_recv(qps[i])) {
+            /* single slot messages do not carry their length */
+            struct smlt_msg chunk = smlt_gather_chunk(buf, pos[i], end[i]);
+            err = smlt_queuepair_recv(qps[i], &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            pos[i] += chunk.words;
+            if (pos[i] == end[i]) {
+                num_done++;
+            }
+        }
+
+        if (++i == num_src) {
+            i = 0;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief collects a block of each node at the root
+ *
+ * @param ctx       The smelt context
+ * @param input     the block of this node
+ * @param result    returns the blocks of all nodes on the root
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_gather(struct smlt_context *ctx,
+                     struct smlt_msg *input,
+                     struct smlt_msg *result)
+{
+    errval_t err;
+
+    if (input == NULL || input->words == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t words = input->words;
+    uint32_t total = smlt_context_get_subtree_size(ctx) * words;
+    uint32_t bufsize = total * sizeof(smlt_msg_payload_t);
+
+    struct smlt_msg *buf;
+    if (smlt_context_is_root(ctx)) {
+        if (result == NULL || result->bufsize < bufsize ||
+            result == input) {
+            return SMLT_ERR_INVAL;
+        }
+        buf = result;
+    } else {
+        buf = smlt_gather_get_scratch(bufsize);
+        if (buf == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+    }
+
+    memcpy(buf->data, input->data, words * sizeof(smlt_msg_payload_t));
+
+    err = smlt_gather_recv_children(ctx, buf, words);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    buf->words = total;
+
+    struct smlt_channel *parent;
+    err =  smlt_context_get_parent_channel(ctx, &parent);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (parent == NULL) {
+        return SMLT_SUCCESS;
+    }
+
+    for (uint32_t offset = 0; offset < total;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        struct smlt_msg chunk = smlt_gather_chunk(buf, offset, total);
+        err = smlt_channel_send(parent, &chunk);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief collects a block of each node and distributes them to all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     the block of this node
+ * @param result    returns the blocks of all nodes
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_allgather(struct smlt_context *ctx,
+                        struct smlt_msg *input,
+                        struct smlt_msg *result)
+{
+    errval_t err;
+
+    if (input == NULL || result == NULL || input == result) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t total = smlt_context_get_num_nodes(ctx) * input->words;
+    if (result->bufsize < total * sizeof(smlt_msg_payload_t)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_gather(ctx, input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    result->words = total;
+
+    return smlt_broadcast_pipelined(ctx, result);
+}
@@ -10,35 +10,62 @@
 #include <smlt_error.h>
 #include <smlt_generator.h>
 #include <smlt_platform.h>
+#include <smlt_topology.h>
+#include <smlt_model_cache.h>
+#include <smlt_sparse_model.h>
 #include "smlt_debug.h"
 #include "tree_config.h"
-#include <stdio.h> // reading json string from file
+#include <stdio.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
 
 /**
- * @brief generates a model using the simulator
- *
- * @param cores         an arry of cores that contains the
- *                      cores of the model
- * @param len           length of the cores array
- * @param name          name of the tree topology generated by the
- *                      simulator
- * @param mode          encoded model (model itself, leafs, last_node)
- *
+ * @brief generates a model using the simulator or the built-in generator
  */
-errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
-                         const char* name, struct smlt_generated_model** model)
+static errval_t smlt_generate_model_uncached(coreid_t* cores, uint32_t len,
+                                             const char* name,
+                                             struct smlt_sparse_model** sparse)
 {
-    *model = (struct smlt_generated_model*) smlt_platform_alloc(
+    smlt_generator_shape_t shape;
+    uint32_t fanout;
+    bool builtin = smlt_err_is_ok(smlt_generator_shape_by_name(name, &shape,
+                                                               &fanout));
+
+    /* the simulator is only contacted if it is configured */
+    const char *host = getenv("SMLT_HOSTNAME");
+    if (host == NULL || strlen(host) == 0) {
+        if (!builtin) {
+            SMLT_WARNING("no built-in generator for topology %s\n",
+                         name ? name : "(null)");
+            return SMLT_ERR_GENERATOR;
+        }
+        return smlt_generate_tree_sparse_model(cores, len, shape, fanout,
+                                               sparse);
+    }
+
+    struct smlt_generated_model *model;
+    model = (struct smlt_generated_model*) smlt_platform_alloc(
                                                 sizeof(struct smlt_generated_model),
                                                 SMLT_DEFAULT_ALIGNMENT,
                                                 true);
     COND_PANIC(model!=NULL, "Failed to allocated memory for model");
 
     uint32_t len_model;
-    int err = smlt_tree_generate(len, cores, name, &((*model)->model),
-                                 &((*model)->num_leafs), &((*model)->leafs),
-                                 &((*model)->root), &len_model);
+    int err = smlt_tree_generate(len, cores, name, &(model->model),
+                                 &(model->num_leafs), &(model->leafs),
+                                 &(model->root), &len_model);
+    if (err && builtin) {
+        SMLT_WARNING("simulator failed, using the built-in generator\n");
+        free(model->model);
+        free(model->leafs);
+        smlt_platform_free(model);
+        return smlt_generate_tree_sparse_model(cores, len, shape, fanout,
+                                               sparse);
+    }
 
     if (len_model != sysconf(_SC_NPROCESSORS_ONLN)) {
 
@@ -50,24 +77,106 @@ errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
     bool all_zeros = true;
     for (unsigned int i = 0; i < len_model; i++) {
         for (unsigned int j = 0; j < len_model; j++) {
-            printf("%d ", (*model)->model[i*(len_model)+j]);
-            if ((*model)->model[i*(len_model)+j] != 0) {
+            printf("%d ", model->model[i*(len_model)+j]);
+            if (model->model[i*(len_model)+j] != 0) {
                 all_zeros = false;
             }
         }
         printf("\n");
     }
-    (*model)->ncores = len;
-    (*model)->len = len_model;
+    model->ncores = len;
+    model->len = len_model;
 
+    errval_t ret;
     if (err) {
-        return SMLT_ERR_GENERATOR;
+        ret = SMLT_ERR_GENERATOR;
     } else if (all_zeros) {
-        return SMLT_ERR_GENERATOR;
+        ret = SMLT_ERR_GENERATOR;
     } else {
-        return SMLT_SUCCESS;
+        ret = smlt_sparse_model_from_model(model, sparse);
+    }
+
+    /* the simulator allocates the matrix and the leafs with malloc */
+    free(model->model);
+    free(model->leafs);
+    smlt_platform_free(model);
+
+    return ret;
+}
+
+/**
+ * @brief obtains the sparse model of a topology
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        returns the sparse model
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * The model cache is tried first. On a miss, the model comes from the
+ * simulator if $SMLT_HOSTNAME is set, and from the built-in generator
+ * otherwise or if the simulator fails. A generated model is stored to the
+ * cache.
+ */
+errval_t smlt_generate_sparse_model(coreid_t* cores, uint32_t len,
+                                    const char* name,
+                                    struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+
+    /* the key needs the cores, the affinity may change between runs */
+    bool use_cache = (cores != NULL && smlt_model_cache_enabled());
+    if (use_cache) {
+        err = smlt_model_cache_lookup_sparse(cores, len, name, sparse);
+        if (smlt_err_is_ok(err)) {
+            return SMLT_SUCCESS;
+        }
+    }
+
+    err = smlt_generate_model_uncached(cores, len, name, sparse);
+    if (smlt_err_is_fail(err) || !use_cache) {
+        return err;
+    }
+
+    err = smlt_model_cache_store_sparse(cores, len, name, *sparse);
+    if (smlt_err_is_fail(err)) {
+        SMLT_WARNING("model cache: could not write the model\n");
     }
+
+    return SMLT_SUCCESS;
 }
+
+/**
+ * @brief obtains the model of a topology
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param model         returns the encoded model (model itself, leafs, root)
+ *
+ * @return SMLT_SUCCESS or error value
+ *
+ * The model is obtained by smlt_generate_sparse_model() and expanded into
+ * the topology matrix.
+ */
+errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
+                         const char* name, struct smlt_generated_model** model)
+{
+    struct smlt_sparse_model *sparse;
+    errval_t err = smlt_generate_sparse_model(cores, len, name, &sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_sparse_model_to_model(sparse, model);
+    smlt_platform_free(sparse);
+
+    return err;
+}
+
 /**
  * @brief generates a model from a file storing a json string
  *
@@ -79,44 +188,542 @@ errval_t smlt_generate_model(coreid_t* cores, uint32_t len,
 errval_t smlt_generate_modal_from_file(char* filepath, uint32_t ncores,
                                        struct smlt_generated_model** model)
 {
+    errval_t err;
+
+    int fd = open(filepath, O_RDONLY);
+    if (fd < 0) {
+        SMLT_WARNING("could not open model file %s\n", filepath);
+        return SMLT_ERR_GENERATOR;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size == 0) {
+        close(fd);
+        return SMLT_ERR_GENERATOR;
+    }
+
+    /* the parser reads the pages of the file in place */
+    void *json = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (json == MAP_FAILED) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    madvise(json, st.st_size, MADV_SEQUENTIAL);
+
+    err = smlt_generate_model_from_json(json, st.st_size, ncores, model);
+
+    munmap(json, st.st_size);
+
+    return err;
+}
+
+/*
+ * ===========================================================================
+ * Built-in model generators
+ * ===========================================================================
+ */
+
+/**
+ * @brief frees a model and its matrix and leafs
+ */
+static void smlt_generator_model_free(struct smlt_generated_model *model)
+{
+    if (model->model) {
+        smlt_platform_free(model->model);
+    }
+    if (model->leafs) {
+        smlt_platform_free(model->leafs);
+    }
+    smlt_platform_free(model);
+}
+
+/**
+ * @brief checks that the cores are distinct and below smlt_get_num_proc()
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+static errval_t smlt_generator_check_cores(coreid_t* cores, uint32_t len)
+{
+    uint32_t len_model = smlt_get_num_proc();
+
+    if (cores == NULL || len == 0 || len > len_model) {
+        return SMLT_ERR_INVAL;
+    }
+
+    bool seen[len_model];
+    memset(seen, 0, sizeof(seen));
+    for (uint32_t i = 0; i < len; i++) {
+        if (cores[i] >= len_model || seen[cores[i]]) {
+            return SMLT_ERR_INVAL;
+        }
+        seen[cores[i]] = true;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief checks the cores of a model and allocates it
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param model         returns the model with an empty matrix
+ *
+ * @return SMLT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ *
+ * The matrix covers all smlt_get_num_proc() cores, the cores have to be
+ * distinct and below that number.
+ */
+static errval_t smlt_generator_model_alloc(coreid_t* cores, uint32_t len,
+                                           struct smlt_generated_model** model)
+{
+    uint32_t len_model = smlt_get_num_proc();
+
+    errval_t err = smlt_generator_check_cores(cores, len);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
 
     *model = (struct smlt_generated_model*) smlt_platform_alloc(
                                                 sizeof(struct smlt_generated_model),
                                                 SMLT_DEFAULT_ALIGNMENT,
                                                 true);
-    assert (*model!=NULL);
+    if (*model == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    (*model)->model = (uint16_t*) smlt_platform_alloc(
+                                      len_model * len_model * sizeof(uint16_t),
+                                      SMLT_DEFAULT_ALIGNMENT, true);
+    (*model)->leafs = (uint32_t*) smlt_platform_alloc(len * sizeof(uint32_t),
+                                                      SMLT_DEFAULT_ALIGNMENT,
+                                                      true);
+    if ((*model)->model == NULL || (*model)->leafs == NULL) {
+        smlt_generator_model_free(*model);
+        *model = NULL;
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
-    (*model)->ncores = ncores;
-    char *json_string;
-    uint64_t file_size;
-    FILE *file = fopen(filepath, "rb");
+    (*model)->ncores = len;
+    (*model)->len = len_model;
+    (*model)->root = cores[0];
+    (*model)->num_leafs = 0;
 
-    // seek end
-    fseek(file, 0, SEEK_END);
-    file_size = ftell(file);
-    rewind(file);
+    return SMLT_SUCCESS;
+}
 
-    // read contents
-    json_string = (char*) smlt_platform_alloc(file_size * (sizeof(char)),
-                                       SMLT_DEFAULT_ALIGNMENT, true);
-    uint64_t read = fread(json_string, sizeof(char), file_size, file);
-    if (read <= 0) {
-       return SMLT_ERR_GENERATOR;
+/**
+ * @brief adds a message passing child after the existing children of parent
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if parent has too many children
+ */
+static errval_t smlt_generator_add_child(struct smlt_sparse_model *sparse,
+                                         uint16_t *num_children,
+                                         coreid_t parent, coreid_t child)
+{
+    if (num_children[parent] == TOPO_MATRIX_MAX_MP) {
+        return SMLT_ERR_INVAL;
     }
 
-    fclose(file);
+    num_children[parent]++;
+    sparse->nodes[child].parent = parent;
+    sparse->nodes[child].edge = num_children[parent];
 
-    uint32_t len_model;
-    int err = smlt_tree_parse(json_string, ncores, &((*model)->model),
-                              &((*model)->num_leafs), &((*model)->leafs),
-                              &((*model)->root), &len_model);
+    return SMLT_SUCCESS;
+}
 
-    (*model)->len = len_model;
-    if (err) {
-        return SMLT_ERR_GENERATOR;
+/**
+ * @brief the first core sends to the others, the last one first
+ */
+static errval_t smlt_generator_flat(struct smlt_sparse_model *sparse,
+                                    uint16_t *num_children,
+                                    coreid_t *set, uint32_t n)
+{
+    for (uint32_t i = n - 1; i > 0; i--) {
+        errval_t err = smlt_generator_add_child(sparse, num_children,
+                                                set[0], set[i]);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief core i sends to the cores fanout * i + 1 to fanout * i + fanout
+ */
+static errval_t smlt_generator_kary(struct smlt_sparse_model *sparse,
+                                    uint16_t *num_children,
+                                    coreid_t *set, uint32_t n,
+                                    uint32_t fanout)
+{
+    for (uint32_t i = 1; i < n; i++) {
+        errval_t err = smlt_generator_add_child(sparse, num_children,
+                                                set[(i - 1) / fanout], set[i]);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief core i sends to the cores i + 2^j with 2^j > i, the largest
+ *        subtree first
+ */
+static errval_t smlt_generator_binomial(struct smlt_sparse_model *sparse,
+                                        uint16_t *num_children,
+                                        coreid_t *set, uint32_t n)
+{
+    uint32_t top = 1;
+    while (top < n) {
+        top <<= 1;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t step = top; step > i; step >>= 1) {
+            if (i + step < n) {
+                errval_t err = smlt_generator_add_child(sparse, num_children,
+                                                        set[i], set[i + step]);
+                if (smlt_err_is_fail(err)) {
+                    return err;
+                }
+            }
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief groups the cores by their NUMA node
+ *
+ * @param cores         the cores, the first one is the root
+ * @param len           length of the cores array
+ * @param sorted        returns the cores grouped by NUMA node
+ * @param start         returns the index of the first core of each group,
+ *                      followed by len
+ * @param num_groups    returns the number of groups
+ *
+ * The group of the root comes first, the others follow with increasing
+ * distance to it. Within a group, the cores keep their order.
+ */
+static void smlt_generator_group_cores(coreid_t* cores, uint32_t len,
+                                       coreid_t *sorted, uint32_t *start,
+                                       uint32_t *num_groups)
+{
+    uint8_t cluster[len];
+    uint8_t groups[len];
+    uint32_t distance[len];
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < len; i++) {
+        cluster[i] = smlt_platform_cluster_of_core(cores[i]);
+
+        uint32_t g = 0;
+        while (g < n && groups[g] != cluster[i]) {
+            g++;
+        }
+
+        if (g == n) {
+            groups[n] = cluster[i];
+            distance[n] = smlt_platform_cluster_distance(groups[0],
+                                                         cluster[i]);
+            n++;
+        }
+    }
+
+    /* stable insertion sort of the remote groups by distance */
+    for (uint32_t g = 2; g < n; g++) {
+        uint8_t group = groups[g];
+        uint32_t dist = distance[g];
+        uint32_t h = g;
+        while (h > 1 && distance[h - 1] > dist) {
+            groups[h] = groups[h - 1];
+            distance[h] = distance[h - 1];
+            h--;
+        }
+        groups[h] = group;
+        distance[h] = dist;
+    }
+
+    uint32_t pos = 0;
+    for (uint32_t g = 0; g < n; g++) {
+        start[g] = pos;
+        for (uint32_t i = 0; i < len; i++) {
+            if (cluster[i] == groups[g]) {
+                sorted[pos++] = cores[i];
+            }
+        }
+    }
+    start[n] = len;
+
+    *num_groups = n;
+}
+
+/**
+ * @brief obtains the tree shape of a topology name
+ *
+ * @param name          name of the tree topology, NULL for $SMLT_TOPO
+ * @param shape         returns the shape
+ * @param fanout        returns the fanout of the k-ary tree
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_INVAL if there is no built-in shape
+ */
+errval_t smlt_generator_shape_by_name(const char *name,
+                                      smlt_generator_shape_t *shape,
+                                      uint32_t *fanout)
+{
+    if (name == NULL) {
+        name = getenv("SMLT_TOPO");
+        if (name == NULL) {
+            name = "adaptivetree";
+        }
+    }
+
+    *fanout = 2;
+
+    if (strcmp(name, "sequential") == 0) {
+        *shape = SMLT_GENERATOR_SEQUENTIAL;
+    } else if (strcmp(name, "bintree") == 0 ||
+               strcmp(name, "binary_tree") == 0) {
+        *shape = SMLT_GENERATOR_KARY;
+    } else if (strncmp(name, "kary-", 5) == 0) {
+        char *end;
+        unsigned long k = strtoul(name + 5, &end, 10);
+        if (*end != 0 || k == 0 || k > TOPO_MATRIX_MAX_MP) {
+            return SMLT_ERR_INVAL;
+        }
+        *shape = SMLT_GENERATOR_KARY;
+        *fanout = k;
+    } else if (strcmp(name, "binomial") == 0 ||
+               strcmp(name, "mst") == 0) {
+        *shape = SMLT_GENERATOR_BINOMIAL;
+    } else if (strcmp(name, "cluster") == 0) {
+        *shape = SMLT_GENERATOR_CLUSTER;
+    } else if (strncmp(name, "adaptivetree", 12) == 0) {
+        *shape = SMLT_GENERATOR_ADAPTIVE;
     } else {
-        return SMLT_SUCCESS;
+        return SMLT_ERR_INVAL;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief generates a sparse message passing model without the simulator
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, NULL for the first len cores
+ *                      the process may run on
+ * @param len           length of the cores array
+ * @param shape         the shape of the tree
+ * @param fanout        the fanout of SMLT_GENERATOR_KARY
+ * @param sparse        returns the sparse model
+ *
+ */
+errval_t smlt_generate_tree_sparse_model(coreid_t* cores, uint32_t len,
+                                         smlt_generator_shape_t shape,
+                                         uint32_t fanout,
+                                         struct smlt_sparse_model** sparse)
+{
+    errval_t err;
+
+    if (len == 0 || (shape == SMLT_GENERATOR_KARY && fanout == 0)) {
+        return SMLT_ERR_INVAL;
     }
+
+    coreid_t allowed[len];
+    if (cores == NULL) {
+        uint32_t num = len;
+        err = smlt_platform_get_affinity(allowed, &num);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+        if (num < len) {
+            return SMLT_ERR_INVAL;
+        }
+        cores = allowed;
+    }
+
+    err = smlt_generator_check_cores(cores, len);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    /* the model covers all cores, like the matrix of a generated model */
+    struct smlt_sparse_model *s = smlt_sparse_model_alloc(smlt_get_num_proc());
+    if (s == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    s->ncores = len;
+    s->root = cores[0];
+
+    coreid_t sorted[len];
+    uint32_t start[len + 1];
+    uint32_t num_groups;
+    smlt_generator_group_cores(cores, len, sorted, start, &num_groups);
+
+    /* the first core of each NUMA node */
+    coreid_t heads[num_groups];
+    for (uint32_t g = 0; g < num_groups; g++) {
+        heads[g] = sorted[start[g]];
+    }
+
+    uint16_t num_children[s->len];
+    memset(num_children, 0, sizeof(num_children));
+
+    switch (shape) {
+    case SMLT_GENERATOR_SEQUENTIAL:
+        err = smlt_generator_flat(s, num_children, sorted, len);
+        break;
+    case SMLT_GENERATOR_KARY:
+        err = smlt_generator_kary(s, num_children, sorted, len, fanout);
+        break;
+    case SMLT_GENERATOR_BINOMIAL:
+        err = smlt_generator_binomial(s, num_children, sorted, len);
+        break;
+    case SMLT_GENERATOR_CLUSTER:
+        /* the root reaches the remote NUMA nodes before its own */
+        err = smlt_generator_flat(s, num_children, heads, num_groups);
+        for (uint32_t g = 0; g < num_groups && smlt_err_is_ok(err); g++) {
+            err = smlt_generator_flat(s, num_children, sorted + start[g],
+                                      start[g + 1] - start[g]);
+        }
+        break;
+    case SMLT_GENERATOR_ADAPTIVE:
+        err = smlt_generator_binomial(s, num_children, heads, num_groups);
+        for (uint32_t g = 0; g < num_groups && smlt_err_is_ok(err); g++) {
+            err = smlt_generator_binomial(s, num_children, sorted + start[g],
+                                          start[g + 1] - start[g]);
+        }
+        break;
+    default:
+        err = SMLT_ERR_INVAL;
+        break;
+    }
+
+    if (smlt_err_is_fail(err)) {
+        smlt_platform_free(s);
+        return err;
+    }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if (num_children[cores[i]] == 0) {
+            s->nodes[cores[i]].flags |= SMLT_SPARSE_MODEL_LEAF;
+        }
+    }
+
+    *sparse = s;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief generates a message passing model without the simulator
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model, NULL for the first len cores
+ *                      the process may run on
+ * @param len           length of the cores array
+ * @param shape         the shape of the tree
+ * @param fanout        the fanout of SMLT_GENERATOR_KARY
+ * @param model         encoded model (model itself, leafs, last_node)
+ *
+ */
+errval_t smlt_generate_tree_model(coreid_t* cores, uint32_t len,
+                                  smlt_generator_shape_t shape,
+                                  uint32_t fanout,
+                                  struct smlt_generated_model** model)
+{
+    struct smlt_sparse_model *sparse;
+    errval_t err = smlt_generate_tree_sparse_model(cores, len, shape, fanout,
+                                                   &sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_sparse_model_to_model(sparse, model);
+    smlt_platform_free(sparse);
+
+    return err;
+}
+
+/**
+ * @brief generates a hybrid model of message passing and shared memory
+ *
+ * @param cores         an arry of cores that contains the
+ *                      cores of the model
+ * @param len           length of the cores array
+ * @param model         encoded model (model itself, leafs, last_node)
+ *
+ */
+errval_t smlt_generate_hybrid_model(coreid_t* cores, uint32_t len,
+                                    struct smlt_generated_model** model)
+{
+    errval_t err = smlt_generator_model_alloc(cores, len, model);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint16_t *m = (*model)->model;
+    uint32_t len_model = (*model)->len;
+
+    /* the island of each core, in the order of the first core */
+    uint32_t island[len];
+    uint32_t island_size[len];
+    uint8_t island_cluster[len];
+    coreid_t heads[len];
+    uint32_t num_islands = 0;
+
+    for (uint32_t i = 0; i < len; i++) {
+        uint8_t cluster = smlt_platform_cluster_of_core(cores[i]);
+
+        uint32_t j = 0;
+        while (j < num_islands && (island_cluster[j] != cluster ||
+               island_size[j] == SMLT_GENERATOR_ISLAND_MAX_CORES)) {
+            j++;
+        }
+
+        if (j == num_islands) {
+            island_cluster[j] = cluster;
+            island_size[j] = 0;
+            heads[j] = cores[i];
+            num_islands++;
+        } else {
+            /* the head is the master of the shared memory channel */
+            uint16_t tag = j % TOPO_MATRIX_SHM_MAX;
+            m[heads[j] * len_model + cores[i]] = TOPO_MATRIX_SHM_MASTER_START + tag;
+            m[cores[i] * len_model + heads[j]] = TOPO_MATRIX_SHM_SLAVE_START + tag;
+        }
+
+        island[i] = j;
+        island_size[j]++;
+    }
+
+    /* binary tree of message passing channels between the heads */
+    for (uint32_t j = 1; j < num_islands; j++) {
+        coreid_t parent = heads[(j - 1) / 2];
+        m[parent * len_model + heads[j]] = (j - 1) % 2 + 1;
+        m[heads[j] * len_model + parent] = TOPO_MATRIX_PARENT;
+    }
+
+    uint32_t num_leafs = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        bool is_head = (heads[island[i]] == cores[i]);
+        if (!is_head || (island_size[island[i]] == 1 &&
+                         2 * island[i] + 1 >= num_islands)) {
+            (*model)->leafs[num_leafs++] = cores[i];
+        }
+    }
+
+    (*model)->num_leafs = num_leafs;
+
+    return SMLT_SUCCESS;
 }
 
 /**
@@ -0,0 +1,381 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_platform.h>
+#include <smlt_generator.h>
+#include <smlt_model_cache.h>
+#include <smlt_sparse_model.h>
+#include "smlt_debug.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SMLT_MODEL_CACHE_PATH_MAX 512
+
+#define SMLT_MODEL_CACHE_CPU_MODEL_MAX 128
+
+/*
+ * ===========================================================================
+ * Fingerprint
+ * ===========================================================================
+ */
+
+#define SMLT_MODEL_CACHE_FNV_OFFSET 0xcbf29ce484222325ULL
+#define SMLT_MODEL_CACHE_FNV_PRIME  0x100000001b3ULL
+
+/**
+ * @brief adds the bytes to the FNV-1a hash
+ */
+static uint64_t smlt_model_cache_hash(uint64_t hash, const void *data,
+                                      size_t size)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= SMLT_MODEL_CACHE_FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief adds the 32-bit value to the FNV-1a hash
+ */
+static inline uint64_t smlt_model_cache_hash_u32(uint64_t hash, uint32_t val)
+{
+    return smlt_model_cache_hash(hash, &val, sizeof(val));
+}
+
+/**
+ * @brief adds the string including its terminator to the FNV-1a hash
+ */
+static inline uint64_t smlt_model_cache_hash_str(uint64_t hash,
+                                                 const char *str)
+{
+    return smlt_model_cache_hash(hash, str, strlen(str) + 1);
+}
+
+/**
+ * @brief computes the key of a model
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ *
+ * @returns the fingerprint of the machine, the cores and the name
+ */
+uint64_t smlt_model_cache_fingerprint(coreid_t *cores, uint32_t len,
+                                      const char *name)
+{
+    uint64_t hash = SMLT_MODEL_CACHE_FNV_OFFSET;
+
+    hash = smlt_model_cache_hash_u32(hash, SMLT_MODEL_CACHE_VERSION);
+
+    char cpu[SMLT_MODEL_CACHE_CPU_MODEL_MAX];
+    if (smlt_err_is_fail(smlt_platform_cpu_model(cpu, sizeof(cpu)))) {
+        cpu[0] = 0;
+    }
+    hash = smlt_model_cache_hash_str(hash, cpu);
+
+    /* the NUMA layout */
+    uint32_t num_cores = smlt_platform_num_cores();
+    hash = smlt_model_cache_hash_u32(hash, num_cores);
+    for (coreid_t c = 0; c < num_cores; c++) {
+        hash = smlt_model_cache_hash_u32(hash,
+                                         smlt_platform_cluster_of_core(c));
+    }
+
+    uint32_t num_clusters = smlt_platform_num_clusters();
+    hash = smlt_model_cache_hash_u32(hash, num_clusters);
+    for (uint32_t i = 0; i < num_clusters; i++) {
+        for (uint32_t j = 0; j < num_clusters; j++) {
+            hash = smlt_model_cache_hash_u32(hash,
+                        smlt_platform_cluster_distance(i, j));
+        }
+    }
+
+    /* the generator, the simulator and the built-in one differ */
+    const char *host = getenv("SMLT_HOSTNAME");
+    hash = smlt_model_cache_hash_str(hash, host ? host : "");
+
+    if (name == NULL) {
+        name = getenv("SMLT_TOPO");
+    }
+    hash = smlt_model_cache_hash_str(hash, name ? name : "");
+
+    hash = smlt_model_cache_hash_u32(hash, smlt_get_num_proc());
+    hash = smlt_model_cache_hash_u32(hash, len);
+    for (uint32_t i = 0; i < len; i++) {
+        hash = smlt_model_cache_hash_u32(hash, cores[i]);
+    }
+
+    return hash;
+}
+
+
+/*
+ * ===========================================================================
+ * Model files
+ * ===========================================================================
+ */
+
+/**
+ * @brief checks whether the model cache is enabled
+ *
+ * @returns FALSE if SMLT_MODEL_CACHE is set to 0
+ */
+bool smlt_model_cache_enabled(void)
+{
+    char *env = getenv("SMLT_MODEL_CACHE");
+
+    return (env == NULL || strcmp(env, "0"));
+}
+
+/**
+ * @brief obtains the path of the model file of the key
+ */
+static errval_t smlt_model_cache_file(uint64_t fingerprint, char *path,
+                                      size_t len)
+{
+    char name[sizeof(SMLT_MODEL_CACHE_FILE) + 16];
+    snprintf(name, sizeof(name), SMLT_MODEL_CACHE_FILE "%016" PRIx64,
+             fingerprint);
+
+    return smlt_platform_cache_path(name, path, len);
+}
+
+/**
+ * @brief looks up a sparse model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        returns the cached model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_CACHE_MISS, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_model_cache_lookup_sparse(coreid_t *cores, uint32_t len,
+                                        const char *name,
+                                        struct smlt_sparse_model **sparse)
+{
+    errval_t err;
+    char path[SMLT_MODEL_CACHE_PATH_MAX];
+
+    uint64_t fingerprint = smlt_model_cache_fingerprint(cores, len, name);
+    err = smlt_model_cache_file(fingerprint, path, sizeof(path));
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return SMLT_ERR_CACHE_MISS;
+    }
+
+    struct stat st;
+    size_t offset = sizeof(struct smlt_model_cache_header) +
+                    len * sizeof(uint32_t);
+    if (fstat(fd, &st) || (size_t) st.st_size < offset) {
+        close(fd);
+        return SMLT_ERR_CACHE_MISS;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return SMLT_ERR_CACHE_MISS;
+    }
+
+    struct smlt_model_cache_header *hdr = map;
+    uint32_t *file_cores = (uint32_t *) (hdr + 1);
+
+    /* the serialized model is checked by the deserialization */
+    struct smlt_sparse_model *file_model;
+    if (hdr->magic != SMLT_MODEL_CACHE_MAGIC ||
+        hdr->version != SMLT_MODEL_CACHE_VERSION ||
+        hdr->fingerprint != fingerprint || hdr->ncores != len ||
+        memcmp(file_cores, cores, len * sizeof(uint32_t)) ||
+        smlt_err_is_fail(smlt_sparse_model_deserialize((uint8_t *) map + offset,
+                                                       st.st_size - offset,
+                                                       &file_model))) {
+        SMLT_WARNING("model cache: ignoring stale file %s\n", path);
+        munmap(map, st.st_size);
+        return SMLT_ERR_CACHE_MISS;
+    }
+
+    /* the nodes are copied, the mapping does not outlive the lookup */
+    *sparse = smlt_sparse_model_alloc(file_model->len);
+    if (*sparse == NULL) {
+        smlt_platform_free(file_model);
+        munmap(map, st.st_size);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    (*sparse)->ncores = file_model->ncores;
+    (*sparse)->root = file_model->root;
+    memcpy((*sparse)->nodes, file_model->nodes,
+           file_model->len * sizeof(struct smlt_sparse_model_node));
+
+    smlt_platform_free(file_model);
+    munmap(map, st.st_size);
+
+    SMLT_DEBUG(SMLT_DBG__INIT, "model cache: loaded %s\n", path);
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief looks up a generated model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param model         returns the cached model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_CACHE_MISS, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_model_cache_lookup(coreid_t *cores, uint32_t len,
+                                 const char *name,
+                                 struct smlt_generated_model **model)
+{
+    struct smlt_sparse_model *sparse;
+    errval_t err = smlt_model_cache_lookup_sparse(cores, len, name, &sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_sparse_model_to_model(sparse, model);
+    smlt_platform_free(sparse);
+
+    return err;
+}
+
+/**
+ * @brief writes the buffer to the file descriptor
+ */
+static bool smlt_model_cache_write(int fd, const void *buf, size_t size)
+{
+    const char *p = buf;
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+/**
+ * @brief stores a sparse model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param sparse        the model to store
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_model_cache_store_sparse(coreid_t *cores, uint32_t len,
+                                       const char *name,
+                                       struct smlt_sparse_model *sparse)
+{
+    errval_t err;
+    char path[SMLT_MODEL_CACHE_PATH_MAX];
+    char tmp[SMLT_MODEL_CACHE_PATH_MAX + 16];
+
+    if (sparse->ncores != len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_model_cache_header hdr = {
+        .magic = SMLT_MODEL_CACHE_MAGIC,
+        .version = SMLT_MODEL_CACHE_VERSION,
+        .fingerprint = smlt_model_cache_fingerprint(cores, len, name),
+        .ncores = len,
+        .reserved = 0,
+    };
+
+    err = smlt_model_cache_file(hdr.fingerprint, path, sizeof(path));
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    size_t size = smlt_sparse_model_size(sparse);
+    void *buf = smlt_platform_alloc(size, SMLT_DEFAULT_ALIGNMENT, false);
+    if (buf == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    err = smlt_sparse_model_serialize(sparse, buf, size);
+    if (smlt_err_is_fail(err)) {
+        smlt_platform_free(buf);
+        return err;
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s.%ld", path, (long) getpid());
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        smlt_platform_free(buf);
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    bool ok = smlt_model_cache_write(fd, &hdr, sizeof(hdr)) &&
+              smlt_model_cache_write(fd, cores, len * sizeof(uint32_t)) &&
+              smlt_model_cache_write(fd, buf, size);
+
+    smlt_platform_free(buf);
+
+    if (close(fd) || !ok || rename(tmp, path)) {
+        unlink(tmp);
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief stores a generated model in the cache
+ *
+ * @param cores         the cores of the model
+ * @param len           length of the cores array
+ * @param name          name of the tree topology
+ * @param model         the model to store
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL, SMLT_ERR_CACHE_PATH or
+ *          SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_model_cache_store(coreid_t *cores, uint32_t len,
+                                const char *name,
+                                struct smlt_generated_model *model)
+{
+    if (model->ncores != len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_sparse_model *sparse;
+    errval_t err = smlt_sparse_model_from_model(model, &sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_model_cache_store_sparse(cores, len, name, sparse);
+    smlt_platform_free(sparse);
+
+    return err;
+}
@@ -0,0 +1,457 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_platform.h>
+#include <smlt_generator.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/*
+ * ===========================================================================
+ * JSON tokenizer
+ * ===========================================================================
+ */
+
+/// the maximum nesting of the values that are skipped
+#define SMLT_JSON_MAX_DEPTH 64
+
+/**
+ * the input of the parser, it is never copied
+ */
+struct smlt_json
+{
+    const char *pos;    ///< the next character
+    const char *end;    ///< the end of the input
+};
+
+/**
+ * @brief skips white space
+ */
+static inline void smlt_json_skip_ws(struct smlt_json *js)
+{
+    while (js->pos < js->end && (*js->pos == ' ' || *js->pos == '\t' ||
+                                 *js->pos == '\n' || *js->pos == '\r')) {
+        js->pos++;
+    }
+}
+
+/**
+ * @brief consumes the character if it is next after the white space
+ *
+ * @returns TRUE if the character was consumed
+ */
+static inline bool smlt_json_accept(struct smlt_json *js, char c)
+{
+    smlt_json_skip_ws(js);
+    if (js->pos < js->end && *js->pos == c) {
+        js->pos++;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief reads a string, escape sequences are kept as they are
+ *
+ * @param js    the input
+ * @param str   returns the first character of the string
+ * @param len   returns the length of the string
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_GENERATOR
+ */
+static errval_t smlt_json_string(struct smlt_json *js, const char **str,
+                                 size_t *len)
+{
+    if (!smlt_json_accept(js, '"')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    const char *start = js->pos;
+    while (js->pos < js->end && *js->pos != '"') {
+        if (*js->pos == '\\') {
+            js->pos++;
+        }
+        js->pos++;
+    }
+
+    if (js->pos >= js->end) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    *str = start;
+    *len = js->pos - start;
+    js->pos++;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief reads a non-negative integer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_GENERATOR
+ */
+static errval_t smlt_json_uint(struct smlt_json *js, uint32_t *val)
+{
+    smlt_json_skip_ws(js);
+
+    uint64_t v = 0;
+    const char *start = js->pos;
+    while (js->pos < js->end && *js->pos >= '0' && *js->pos <= '9') {
+        v = v * 10 + (*js->pos - '0');
+        if (v > UINT32_MAX) {
+            return SMLT_ERR_GENERATOR;
+        }
+        js->pos++;
+    }
+
+    /* fractions and exponents are not expected in a model */
+    if (js->pos == start || (js->pos < js->end &&
+        (*js->pos == '.' || *js->pos == 'e' || *js->pos == 'E'))) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    *val = v;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief skips a value of any type
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_GENERATOR
+ *
+ * Inside the value, every separator has to follow a value, and a value may
+ * not follow another value without a separator.
+ */
+static errval_t smlt_json_skip_value(struct smlt_json *js)
+{
+    uint32_t depth = 0;
+    bool has_value = false;     ///< the last token completed a value
+    bool is_open = false;       ///< the last token opened a container
+
+    do {
+        smlt_json_skip_ws(js);
+        if (js->pos >= js->end) {
+            return SMLT_ERR_GENERATOR;
+        }
+
+        const char *str;
+        size_t len;
+        switch (*js->pos) {
+        case ',':
+        case ':':
+            if (depth == 0 || !has_value) {
+                return SMLT_ERR_GENERATOR;
+            }
+            has_value = false;
+            is_open = false;
+            js->pos++;
+            break;
+        case ']':
+        case '}':
+            if (depth == 0 || !(has_value || is_open)) {
+                return SMLT_ERR_GENERATOR;
+            }
+            depth--;
+            has_value = true;
+            is_open = false;
+            js->pos++;
+            break;
+        default:
+            if (has_value) {
+                return SMLT_ERR_GENERATOR;
+            }
+            if (*js->pos == '"') {
+                if (smlt_err_is_fail(smlt_json_string(js, &str, &len))) {
+                    return SMLT_ERR_GENERATOR;
+                }
+                has_value = true;
+            } else if (*js->pos == '[' || *js->pos == '{') {
+                if (++depth > SMLT_JSON_MAX_DEPTH) {
+                    return SMLT_ERR_GENERATOR;
+                }
+                is_open = true;
+                js->pos++;
+                break;
+            } else {
+                /* numbers and literals */
+                const char *start = js->pos;
+                while (js->pos < js->end && *js->pos != '\0' &&
+                       !strchr(",:[]{}\" \t\r\n", *js->pos)) {
+                    js->pos++;
+                }
+                if (js->pos == start) {
+                    return SMLT_ERR_GENERATOR;
+                }
+                has_value = true;
+            }
+            is_open = false;
+            break;
+        }
+    } while (depth > 0);
+
+    return SMLT_SUCCESS;
+}
+
+/*
+ * ===========================================================================
+ * Model schema
+ * ===========================================================================
+ */
+
+/**
+ * the parts of the model, sized by the first pass and filled by the second
+ */
+struct smlt_json_model
+{
+    bool has_root;          ///< the root was found
+    uint32_t root;          ///< the root node
+    uint32_t num_leafs;     ///< number of leaf nodes
+    uint32_t len;           ///< number of rows of the matrix
+    uint32_t *leafs;        ///< the leafs, NULL in the first pass
+    uint16_t *model;        ///< the matrix, NULL in the first pass
+};
+
+/**
+ * @brief checks whether the string is the key
+ */
+static inline bool smlt_json_is_key(const char *str, size_t len,
+                                    const char *key)
+{
+    return (strlen(key) == len && !memcmp(str, key, len));
+}
+
+/**
+ * @brief reads the array of leaf nodes
+ */
+static errval_t smlt_json_leafs(struct smlt_json *js,
+                                struct smlt_json_model *m)
+{
+    if (!smlt_json_accept(js, '[')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    uint32_t n = 0;
+    if (!smlt_json_accept(js, ']')) {
+        do {
+            uint32_t val;
+            if (smlt_err_is_fail(smlt_json_uint(js, &val))) {
+                return SMLT_ERR_GENERATOR;
+            }
+            if (m->leafs) {
+                if (n >= m->num_leafs) {
+                    return SMLT_ERR_GENERATOR;
+                }
+                m->leafs[n] = val;
+            }
+            n++;
+        } while (smlt_json_accept(js, ','));
+
+        if (!smlt_json_accept(js, ']')) {
+            return SMLT_ERR_GENERATOR;
+        }
+    }
+
+    m->num_leafs = n;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief reads the matrix, an array of rows of the same length as the array
+ */
+static errval_t smlt_json_matrix(struct smlt_json *js,
+                                 struct smlt_json_model *m)
+{
+    if (!smlt_json_accept(js, '[')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    uint32_t rows = 0;
+    uint32_t row_len = 0;
+    if (!smlt_json_accept(js, ']')) {
+        do {
+            if (!smlt_json_accept(js, '[')) {
+                return SMLT_ERR_GENERATOR;
+            }
+
+            uint32_t y = 0;
+            if (!smlt_json_accept(js, ']')) {
+                do {
+                    uint32_t val;
+                    if (smlt_err_is_fail(smlt_json_uint(js, &val)) ||
+                        val > UINT16_MAX) {
+                        return SMLT_ERR_GENERATOR;
+                    }
+                    if (m->model) {
+                        if (rows >= m->len || y >= m->len) {
+                            return SMLT_ERR_GENERATOR;
+                        }
+                        m->model[rows * m->len + y] = val;
+                    }
+                    y++;
+                } while (smlt_json_accept(js, ','));
+
+                if (!smlt_json_accept(js, ']')) {
+                    return SMLT_ERR_GENERATOR;
+                }
+            }
+
+            if (rows == 0) {
+                row_len = y;
+            } else if (y != row_len) {
+                return SMLT_ERR_GENERATOR;
+            }
+            rows++;
+        } while (smlt_json_accept(js, ','));
+
+        if (!smlt_json_accept(js, ']')) {
+            return SMLT_ERR_GENERATOR;
+        }
+    }
+
+    if (rows != row_len) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    m->len = rows;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief walks over the top level object
+ *
+ * Without the output arrays, the walk only sizes the leafs and the matrix.
+ * Keys other than "root", "leaf_nodes" and "model" are skipped.
+ */
+static errval_t smlt_json_walk(const char *json, size_t size,
+                               struct smlt_json_model *m)
+{
+    errval_t err;
+    struct smlt_json js = { .pos = json, .end = json + size };
+
+    if (!smlt_json_accept(&js, '{')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    if (smlt_json_accept(&js, '}')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    do {
+        const char *key;
+        size_t len;
+        err = smlt_json_string(&js, &key, &len);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        if (!smlt_json_accept(&js, ':')) {
+            return SMLT_ERR_GENERATOR;
+        }
+
+        if (smlt_json_is_key(key, len, "root")) {
+            err = smlt_json_uint(&js, &m->root);
+            m->has_root = true;
+        } else if (smlt_json_is_key(key, len, "leaf_nodes")) {
+            err = smlt_json_leafs(&js, m);
+        } else if (smlt_json_is_key(key, len, "model")) {
+            err = smlt_json_matrix(&js, m);
+        } else {
+            err = smlt_json_skip_value(&js);
+        }
+
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    } while (smlt_json_accept(&js, ','));
+
+    if (!smlt_json_accept(&js, '}')) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief generates a model from a json string
+ *
+ * @param json          the json string, it does not need to be terminated
+ * @param size          length of the json string
+ * @param ncores        number of cores in model
+ * @param model         (return value) in struct encoded model
+ *                      (last_node, leafs, model)
+ *
+ * @return              SMLT_SUCCESS, SMLT_ERR_GENERATOR if the string is not
+ *                      a valid model or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_generate_model_from_json(const char *json, size_t size,
+                                       uint32_t ncores,
+                                       struct smlt_generated_model** model)
+{
+    errval_t err;
+    struct smlt_json_model m;
+
+    memset(&m, 0, sizeof(m));
+    err = smlt_json_walk(json, size, &m);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (!m.has_root || m.len == 0 || m.root >= m.len) {
+        return SMLT_ERR_GENERATOR;
+    }
+
+    *model = (struct smlt_generated_model*) smlt_platform_alloc(
+                                                sizeof(struct smlt_generated_model),
+                                                SMLT_DEFAULT_ALIGNMENT,
+                                                true);
+    if (*model == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    /* avoid zero sized allocations without leafs */
+    m.leafs = (uint32_t*) smlt_platform_alloc((m.num_leafs + 1) *
+                                              sizeof(uint32_t),
+                                              SMLT_DEFAULT_ALIGNMENT, true);
+    m.model = (uint16_t*) smlt_platform_alloc((size_t) m.len * m.len *
+                                              sizeof(uint16_t),
+                                              SMLT_DEFAULT_ALIGNMENT, true);
+    if (m.leafs == NULL || m.model == NULL) {
+        err = SMLT_ERR_MALLOC_FAIL;
+        goto err_free;
+    }
+
+    err = smlt_json_walk(json, size, &m);
+    if (smlt_err_is_fail(err)) {
+        goto err_free;
+    }
+
+    (*model)->ncores = ncores;
+    (*model)->len = m.len;
+    (*model)->root = m.root;
+    (*model)->model = m.model;
+    (*model)->num_leafs = m.num_leafs;
+    (*model)->leafs = m.leafs;
+
+    return SMLT_SUCCESS;
+
+    err_free:
+    if (m.model) {
+        smlt_platform_free(m.model);
+    }
+    if (m.leafs) {
+        smlt_platform_free(m.leafs);
+    }
+    smlt_platform_free(*model);
+    *model = NULL;
+    return err;
+}
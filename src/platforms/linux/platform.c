@@ -12,6 +12,13 @@
 #include "../../internal.h"
 
 #include <numa.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 
 /**
@@ -113,6 +120,45 @@ uint32_t smlt_platform_num_cores(void)
     return (uint32_t) numa_num_configured_cpus();
 }
 
+/**
+ * @brief obtains the name of the processor model
+ *
+ * @param buf           buffer to store the name in
+ * @param len           length of the buffer
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PLATFORM_INIT if the name is unknown
+ */
+errval_t smlt_platform_cpu_model(char *buf, size_t len)
+{
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    if (f == NULL) {
+        return SMLT_ERR_PLATFORM_INIT;
+    }
+
+    errval_t err = SMLT_ERR_PLATFORM_INIT;
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, "model name", 10) != 0) {
+            continue;
+        }
+
+        char *value = strchr(line, ':');
+        if (value == NULL) {
+            continue;
+        }
+        value += strspn(value + 1, " \t") + 1;
+        value[strcspn(value, "\n")] = 0;
+
+        snprintf(buf, len, "%s", value);
+        err = SMLT_SUCCESS;
+        break;
+    }
+
+    fclose(f);
+
+    return err;
+}
+
 /**
  * @brief  obtains the number of cores on a cluster
  *
@@ -133,6 +179,51 @@ uint32_t smlt_platform_num_cores_of_cluster(uint8_t cluster_id)
     return core_count;
 }
 
+/**
+ * @brief returns the distance between two clusters
+ *
+ * @param from          the id of the first NUMA node
+ * @param to            the id of the second NUMA node
+ *
+ * @return the relative distance, 10 within a NUMA node
+ */
+uint32_t smlt_platform_cluster_distance(uint8_t from, uint8_t to)
+{
+    int distance = numa_distance(from, to);
+    if (distance <= 0) {
+        /* the distances are not known */
+        return (from == to) ? 10 : 20;
+    }
+    return (uint32_t) distance;
+}
+
+/**
+ * @brief obtains the cores the process is allowed to run on
+ *
+ * @param cores         array to store the core ids in
+ * @param num           the length of the array, returns the number of cores
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_PLATFORM_INIT
+ */
+errval_t smlt_platform_get_affinity(coreid_t *cores, uint32_t *num)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set)) {
+        return SMLT_ERR_PLATFORM_INIT;
+    }
+
+    uint32_t count = 0;
+    for (int i = 0; i < CPU_SETSIZE && count < *num; i++) {
+        if (CPU_ISSET(i, &set)) {
+            cores[count++] = i;
+        }
+    }
+    *num = count;
+
+    return SMLT_SUCCESS;
+}
+
 /**
  * @brief getting the NUMA node id of a core id
  *
@@ -144,3 +235,99 @@ uint8_t smlt_platform_cluster_of_core(coreid_t core_id)
 {
     return numa_node_of_cpu(core_id);
 }
+
+
+/*
+ * ===========================================================================
+ * Persistent cache
+ * ===========================================================================
+ */
+
+#define SMLT_PLATFORM_MACHINE_NAME_MAX 64
+
+/**
+ * @brief creates the directory if it does not exist yet
+ */
+static errval_t smlt_platform_mkdir(const char *dir)
+{
+    if (mkdir(dir, 0755) && errno != EEXIST) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief obtains the path of a file in the machine specific cache directory
+ *
+ * @param name  name of the cache file
+ * @param path  buffer to store the path in
+ * @param len   length of the buffer
+ *
+ * @return SMLT_SUCCESS or SMLT_ERR_CACHE_PATH
+ */
+errval_t smlt_platform_cache_path(const char *name, char *path, size_t len)
+{
+    errval_t err;
+    int n;
+
+    char *dir = getenv("SMLT_CACHE_DIR");
+    if (dir != NULL) {
+        n = snprintf(path, len, "%s", dir);
+    } else if ((dir = getenv("XDG_CACHE_HOME")) != NULL) {
+        n = snprintf(path, len, "%s/smelt", dir);
+    } else if ((dir = getenv("HOME")) != NULL) {
+        n = snprintf(path, len, "%s/.cache", dir);
+        if (n < 0 || (size_t) n >= len) {
+            return SMLT_ERR_CACHE_PATH;
+        }
+        err = smlt_platform_mkdir(path);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+        n = snprintf(path, len, "%s/.cache/smelt", dir);
+    } else {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    if (n < 0 || (size_t) n >= len) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    err = smlt_platform_mkdir(path);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    char machine[SMLT_PLATFORM_MACHINE_NAME_MAX];
+    char *env = getenv("SMLT_MACHINE");
+    if (env != NULL) {
+        snprintf(machine, sizeof(machine), "%s", env);
+    } else if (gethostname(machine, sizeof(machine))) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+    machine[sizeof(machine) - 1] = 0;
+
+    /* the machine name ends up in the path */
+    if (strchr(machine, '/') != NULL) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    size_t dirlen = strlen(path);
+    n = snprintf(path + dirlen, len - dirlen, "/%s", machine);
+    if (n < 0 || (size_t) n >= len - dirlen) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    err = smlt_platform_mkdir(path);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    dirlen = strlen(path);
+    n = snprintf(path + dirlen, len - dirlen, "/%s", name);
+    if (n < 0 || (size_t) n >= len - dirlen) {
+        return SMLT_ERR_CACHE_PATH;
+    }
+
+    return SMLT_SUCCESS;
+}
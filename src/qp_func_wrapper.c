@@ -12,6 +12,8 @@
 #include "qp_func_wrapper.h"
 #include "smlt_debug.h"
 
+#include <string.h>
+
 
 /* ===========================================================
  * FFQ wrapper functions
@@ -74,7 +76,9 @@ bool smlt_ffq_can_send(struct smlt_qp *qp)
 errval_t smlt_shm_send(struct smlt_qp *qp, struct smlt_msg *msg)
 {
     if (msg->words <= 7) {
-        uintptr_t* data = (uintptr_t*) msg->data;
+        /* the slot always holds 7 words, do not read past the message */
+        uintptr_t data[7] = { 0 };
+        memcpy(data, msg->data, msg->words * sizeof(uintptr_t));
         shm_q_send(&qp->queue_tx.shm.src,
                     data[0], data[1], data[2],
                     data[3], data[4], data[5], data[6]);
@@ -90,10 +94,14 @@ errval_t smlt_shm_recv(struct smlt_qp *qp, struct smlt_msg *msg)
     // TODO msg struct must be allocated i.e. where to encode msg
     //      size that is allocated
     // TODO Fragmentation
-    uintptr_t* data = (uintptr_t*) msg->data;
+    uintptr_t data[7];
 
     shm_q_recv(&qp->queue_rx.shm.dst, &data[0], &data[1],
                &data[2], &data[3], &data[4], &data[5], &data[6]);
+
+    /* do not write past the words the caller expects */
+    uint32_t words = msg->words < 7 ? msg->words : 7;
+    memcpy(msg->data, data, words * sizeof(uintptr_t));
     return SMLT_SUCCESS;
 }
 
@@ -119,3 +127,126 @@ bool smlt_shm_can_send(struct smlt_qp *qp)
 {
     return shm_q_can_send(&qp->queue_tx.shm.src);
 }
+
+errval_t smlt_shm_recv_borrow(struct smlt_qp *qp,
+                              const smlt_msg_payload_t **data,
+                              uint32_t *words)
+{
+    struct shm_context *context = &qp->queue_rx.shm.dst;
+
+    if (!shm_q_can_recv(context)) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    // the first word of the slot holds the sequence number
+    *data = (const smlt_msg_payload_t *) context->data +
+                context->l_pos*(CACHELINE_SIZE/sizeof(uintptr_t)) + 1;
+    *words = 7;
+
+    return SMLT_SUCCESS;
+}
+
+errval_t smlt_shm_send_prepare(struct smlt_qp *qp,
+                               smlt_msg_payload_t **data,
+                               uint32_t *words)
+{
+    struct shm_context *context = &qp->queue_tx.shm.src;
+
+    if (context->l_pos == context->num_slots) {
+        context->l_pos = 0;
+    }
+
+    if (context->next_seq == context->next_sync) {
+        uint64_t next_sync = context->reader_pos->pos + (context->num_slots-1);
+        if (context->next_seq == next_sync) {
+            return SMLT_ERR_QUEUE_FULL;
+        }
+        context->next_sync = next_sync;
+    }
+
+    // the first word of the slot holds the sequence number
+    *data = (smlt_msg_payload_t *) context->data +
+                context->l_pos*(CACHELINE_SIZE/sizeof(uintptr_t)) + 1;
+    *words = 7;
+
+    return SMLT_SUCCESS;
+}
+
+errval_t smlt_shm_send_commit(struct smlt_qp *qp)
+{
+    struct shm_context *context = &qp->queue_tx.shm.src;
+
+    uintptr_t* slot_start = (uintptr_t*) context->data +
+                context->l_pos*(CACHELINE_SIZE/sizeof(uintptr_t));
+
+    smlt_arch_write_barrier();
+    slot_start[0] = context->next_seq;
+    context->next_seq++;
+    context->l_pos++;
+
+    return SMLT_SUCCESS;
+}
+
+/* ===========================================================
+ * Generic wrapper functions
+ * ===========================================================
+ */
+
+/*
+ * used by the backends that cannot amortize the costs of a batch,
+ * sends the messages one by one until the queue is full
+ */
+errval_t smlt_generic_try_send_batch(struct smlt_qp *qp,
+                                     struct smlt_msg **msgs,
+                                     uint32_t num,
+                                     uint32_t *ret_num)
+{
+    errval_t err = SMLT_SUCCESS;
+    uint32_t count;
+
+    for (count = 0; count < num; count++) {
+        err = qp->f.send.try_send(qp, msgs[count]);
+        if (smlt_err_is_fail(err)) {
+            break;
+        }
+    }
+
+    *ret_num = count;
+
+    if (count > 0 && err == SMLT_ERR_QUEUE_FULL) {
+        return SMLT_SUCCESS;
+    }
+
+    return err;
+}
+
+/*
+ * receives the messages one by one until the queue is empty
+ */
+errval_t smlt_generic_try_recv_batch(struct smlt_qp *qp,
+                                     struct smlt_msg **msgs,
+                                     uint32_t num,
+                                     uint32_t *ret_num)
+{
+    uint32_t count;
+
+    for (count = 0; count < num; count++) {
+        if (!qp->f.recv.can_recv(qp)) {
+            break;
+        }
+
+        errval_t err = qp->f.recv.try_recv(qp, msgs[count]);
+        if (smlt_err_is_fail(err)) {
+            *ret_num = count;
+            return err;
+        }
+    }
+
+    *ret_num = count;
+
+    if (count == 0 && num > 0) {
+        return SMLT_ERR_QUEUE_EMPTY;
+    }
+
+    return SMLT_SUCCESS;
+}
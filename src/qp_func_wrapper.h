@@ -10,6 +10,7 @@
 #define QP_FUNC_WRAPPER_H 1
 
 #include <smlt_error.h>
+#include <smlt_message.h>
 
 struct smlt_qp;
 
@@ -21,4 +22,20 @@ errval_t smlt_shm_send0(struct smlt_qp *qp);
 errval_t smlt_shm_recv0(struct smlt_qp *qp);
 bool smlt_shm_can_send (struct smlt_qp *qp);
 bool smlt_shm_can_recv(struct smlt_qp *qp);
+errval_t smlt_shm_send_prepare(struct smlt_qp *qp,
+                               smlt_msg_payload_t **data,
+                               uint32_t *words);
+errval_t smlt_shm_send_commit(struct smlt_qp *qp);
+errval_t smlt_shm_recv_borrow(struct smlt_qp *qp,
+                              const smlt_msg_payload_t **data,
+                              uint32_t *words);
+
+errval_t smlt_generic_try_send_batch(struct smlt_qp *qp,
+                                     struct smlt_msg **msgs,
+                                     uint32_t num,
+                                     uint32_t *ret_num);
+errval_t smlt_generic_try_recv_batch(struct smlt_qp *qp,
+                                     struct smlt_msg **msgs,
+                                     uint32_t num,
+                                     uint32_t *ret_num);
 #endif /* QP_FUNC_WRAPPER_H */
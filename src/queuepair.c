@@ -30,8 +30,50 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
                                struct smlt_qp **qp2,
                                coreid_t core_src,
                                coreid_t core_dst)
+{
+    return smlt_queuepair_create_sized(type, qp1, qp2, core_src, core_dst, 0);
+}
+
+/**
+  * @brief creates the queue pair with the given number of slots
+  *
+  * @param qp1:       Forward channel
+  * @param qp2:       Backward channel
+  * @param num_slots: slots of each direction, 0 for the backend default
+  *
+  * @returns SMLT_SUCCESS or error value
+  */
+errval_t smlt_queuepair_create_sized(smlt_qp_type_t type,
+                                     struct smlt_qp **qp1,
+                                     struct smlt_qp **qp2,
+                                     coreid_t core_src,
+                                     coreid_t core_dst,
+                                     uint32_t num_slots)
 {
     errval_t err;
+    struct shm_qp *shm_tx, *shm_rx;
+
+    switch(type) {
+        case SMLT_QP_TYPE_UMP :
+            if (num_slots == 0) {
+                num_slots = SMLT_UMP_DEFAULT_SLOTS;
+            }
+            if (num_slots < 2 || num_slots > SMLT_UMP_MAX_SLOTS) {
+                return SMLT_ERR_INVAL;
+            }
+            break;
+        case SMLT_QP_TYPE_FFQ :
+            if (num_slots == 0) {
+                num_slots = SMLT_FFQ_DEFAULT_SLOTS;
+            }
+            if (num_slots < 2 || num_slots > SMLT_FFQ_MAX_SLOTS) {
+                return SMLT_ERR_INVAL;
+            }
+            break;
+        default:
+            /* the shared memory queuepair has a fixed size */
+            break;
+    }
 
     SMLT_DEBUG(SMLT_DBG__GENERAL, "creating qp src=%" PRIu32 " dst =% " PRIu32 " \n",
                core_src, core_dst);
@@ -55,6 +97,7 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
                                                          dst_affinity, true);
     if (!qp_dst) {
         printf("malloc failed, affinities: %u, %u\n", src_affinity, dst_affinity);
+        smlt_platform_free(qp_src);
         return SMLT_ERR_MALLOC_FAIL;
     }
 
@@ -63,46 +106,62 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
     (qp_dst)->type = type;
     switch(type) {
         case SMLT_QP_TYPE_UMP :
-            err = smlt_ump_queuepair_init(SMLT_UMP_DEFAULT_SLOTS,
+            err = smlt_ump_queuepair_init(num_slots,
                                           src_affinity, dst_affinity,
                                           &(qp_src)->q.ump, &(qp_dst)->q.ump);
             if (smlt_err_is_fail(err)) {
-                return err;
+                goto err_free;
             }
 
             // set function pointers
             (qp_src)->f.send.try_send = smlt_ump_queuepair_try_send;
             (qp_src)->f.send.notify = smlt_ump_queuepair_notify;
             (qp_src)->f.send.can_send = smlt_ump_queuepair_can_send;
+            (qp_src)->f.send.prepare = smlt_ump_queuepair_try_send_prepare;
+            (qp_src)->f.send.commit = smlt_ump_queuepair_send_commit;
+            (qp_src)->f.send.batch = smlt_ump_queuepair_try_send_batch;
             (qp_src)->f.recv.try_recv = smlt_ump_queuepair_try_recv;
             (qp_src)->f.recv.can_recv = smlt_ump_queuepair_can_recv;
             (qp_src)->f.recv.notify = smlt_ump_queuepair_recv_notify;
+            (qp_src)->f.recv.borrow = smlt_ump_queuepair_try_recv_borrow;
+            (qp_src)->f.recv.release = smlt_ump_queuepair_recv_release;
+            (qp_src)->f.recv.batch = smlt_ump_queuepair_try_recv_batch;
             (qp_dst)->f = (qp_src)->f;
 
             break;
         case SMLT_QP_TYPE_FFQ :
             // create two queues
-            err = smlt_ffq_queuepair_init(SMLT_FFQ_DEFAULT_SLOTS,
+            err = smlt_ffq_queuepair_init(num_slots,
                                           src_affinity, dst_affinity,
                                           &(qp_src)->q.ffq, &(qp_dst)->q.ffq);
             if (smlt_err_is_fail(err)) {
-                return err;
+                goto err_free;
             }
 
             // set function pointers
             (qp_src)->f.send.try_send = smlt_ffq_queuepair_send;
             (qp_src)->f.send.notify = smlt_ffq_queuepair_notify;
             (qp_src)->f.send.can_send = smlt_ffq_queuepair_can_send;
+            (qp_src)->f.send.prepare = smlt_ffq_queuepair_try_send_prepare;
+            (qp_src)->f.send.commit = smlt_ffq_queuepair_send_commit;
+            (qp_src)->f.send.batch = smlt_generic_try_send_batch;
             (qp_src)->f.recv.try_recv = smlt_ffq_queuepair_recv;
             (qp_src)->f.recv.can_recv = smlt_ffq_queuepair_can_recv;
             (qp_src)->f.recv.notify = smlt_ffq_queuepair_recv_notify;
+            (qp_src)->f.recv.borrow = smlt_ffq_queuepair_try_recv_borrow;
+            (qp_src)->f.recv.release = smlt_ffq_queuepair_recv_release;
+            (qp_src)->f.recv.batch = smlt_generic_try_recv_batch;
 
             (qp_dst)->f = (qp_src)->f;
             break;
         case SMLT_QP_TYPE_SHM :
             // create two queues
-            (qp_src)->queue_tx.shm = *shm_queuepair_create(core_src, core_dst);
-            (qp_src)->queue_rx.shm = *shm_queuepair_create(core_dst, core_src);
+            shm_tx = shm_queuepair_create(core_src, core_dst);
+            shm_rx = shm_queuepair_create(core_dst, core_src);
+            (qp_src)->queue_tx.shm = *shm_tx;
+            (qp_src)->queue_rx.shm = *shm_rx;
+            free(shm_tx);
+            free(shm_rx);
 
             (qp_dst)->queue_rx.shm = (qp_src)->queue_tx.shm;
             (qp_dst)->queue_tx.shm = (qp_src)->queue_rx.shm;
@@ -111,9 +170,15 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
             (qp_src)->f.send.try_send = smlt_shm_send;
             (qp_src)->f.send.notify = smlt_shm_send0;
             (qp_src)->f.send.can_send = smlt_shm_can_send;
+            (qp_src)->f.send.prepare = smlt_shm_send_prepare;
+            (qp_src)->f.send.commit = smlt_shm_send_commit;
+            (qp_src)->f.send.batch = smlt_generic_try_send_batch;
             (qp_src)->f.recv.try_recv = smlt_shm_recv;
             (qp_src)->f.recv.can_recv = smlt_shm_can_recv;
             (qp_src)->f.recv.notify = smlt_shm_recv0;
+            (qp_src)->f.recv.borrow = smlt_shm_recv_borrow;
+            (qp_src)->f.recv.release = smlt_shm_recv0;
+            (qp_src)->f.recv.batch = smlt_generic_try_recv_batch;
 
             (qp_dst)->f = (qp_src)->f;
             break;
@@ -125,36 +190,45 @@ errval_t smlt_queuepair_create(smlt_qp_type_t type,
     *qp2 = qp_dst;
 
     return SMLT_SUCCESS;
+
+    err_free:
+    smlt_platform_free(qp_src);
+    smlt_platform_free(qp_dst);
+    return err;
 }
 
 /**
- * @brief destroys the queuepair
+ * @brief destroys one end of the queuepair
  *
- * @param
+ * @param qp    the end of the queuepair to destroy
  *
- * @returns 0
+ * @returns SMLT_SUCCESS or error value
  */
 errval_t smlt_queuepair_destroy(struct smlt_qp *qp)
 {
-    //int ret;
+    errval_t err;
+
     switch(qp->type) {
         case SMLT_QP_TYPE_UMP :
-            // TODO destroy always returns 0
-            //ret = ump_queuepair_destroy(&(qp->queue_tx.ump));
-            //ret = ump_queuepair_destroy(&(qp->queue_rx.ump));
-            //if (ret) {
-                return SMLT_ERR_DESTROY_UMP;
-            //}
+            err = smlt_ump_queuepair_destroy(&qp->q.ump);
+            if (smlt_err_is_fail(err)) {
+                return smlt_err_push(err, SMLT_ERR_DESTROY_UMP);
+            }
             break;
         case SMLT_QP_TYPE_FFQ :
-            // TODO do destroy
+            err = smlt_ffq_queuepair_destroy(&qp->q.ffq);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
             break;
         case SMLT_QP_TYPE_SHM :
-            // TODO do destroy
+            shm_queuepair_destroy(&qp->queue_rx.shm);
             break;
         default:
             break;
     }
 
+    smlt_platform_free(qp);
+
     return SMLT_SUCCESS;
 }
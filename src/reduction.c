@@ -11,61 +11,135 @@
 #include <smlt_context.h>
 #include <smlt_reduction.h>
 #include <smlt_broadcast.h>
+#include <smlt_request.h>
 #include "smlt_debug.h"
 #include <shm/smlt_shm.h>
 #include <string.h>
 
 
+/*
+ * ===========================================================================
+ * Reduction tree
+ * ===========================================================================
+ */
+
 /**
- * @brief performs a reduction on the current instance
- *
- * @param ctx       The smelt context
- * @param msg        input for the reduction
- * @param result     returns the result of the reduction
- * @param operation  function to be called to calculate the aggregate
- *
- * @returns TODO:errval
+ * describes how the messages of the children are combined
  */
-errval_t smlt_reduce(struct smlt_context *ctx,
-                     struct smlt_msg *input,
-                     struct smlt_msg *result,
-                     smlt_reduce_fn_t operation)
+struct smlt_reduce_desc
 {
-    errval_t err;
+    smlt_reduce_fn_t fn;        ///< user supplied operation, or NULL
+    smlt_reduce_op_t op;        ///< builtin operation if fn is NULL
+    smlt_reduce_dtype_t dtype;  ///< element type of the builtin operation
+};
 
-    if (!operation) {
-        return smlt_reduce_notify(ctx);
+/// receive buffer for the messages of the children
+static __thread struct smlt_msg *smlt_reduce_scratch = NULL;
+
+/**
+ * @brief returns the receive buffer, growing it to hold at least bufsize bytes
+ */
+static struct smlt_msg *smlt_reduce_get_scratch(uint32_t bufsize)
+{
+    if (smlt_reduce_scratch && smlt_reduce_scratch->bufsize < bufsize) {
+        smlt_message_free(smlt_reduce_scratch);
+        smlt_reduce_scratch = NULL;
     }
 
-    // --------------------------------------------------
-    // Message passing
+    if (smlt_reduce_scratch == NULL) {
+        smlt_reduce_scratch = smlt_message_alloc(bufsize);
+    }
 
-    /*
-     * Each client receives (potentially from several children) and
-     * sends only ONCE. On which level of the tree hierarchy this is
-     * does not matter. If a client would send several messages, we
-     * would have circles in the tree.
-     */
+    return smlt_reduce_scratch;
+}
 
+static inline errval_t smlt_reduce_combine(struct smlt_reduce_desc *desc,
+                                           struct smlt_msg *dest,
+                                           struct smlt_msg *src)
+{
+    if (desc->fn) {
+        return desc->fn(dest, src);
+    }
 
-    operation(result, input);
+    return smlt_reduce_op_apply(desc->op, desc->dtype, dest, src);
+}
 
-    uint32_t count = 0;
-    struct smlt_channel *children;
-    err =  smlt_context_get_children_channels(ctx, &children, &count);
-    if (smlt_err_is_fail(err)) {
-        return err; // TODO: adding more error values
+/**
+ * @brief returns the number of queuepairs the children send their messages on
+ */
+static uint32_t smlt_reduce_num_sources(struct smlt_channel *children,
+                                        uint32_t count)
+{
+    uint32_t num = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        num += children[i].use_shm ? children[i].m : 1;
     }
+    return num;
+}
 
-    // Receive (this will be from several children)
-    // --------------------------------------------------
-    bool recv[count];
-    memset(recv, 0, sizeof(bool)*count);
+/**
+ * @brief collects the queuepairs to receive the children's messages from
+ *
+ * @param children  the channels to the children
+ * @param count     the number of channels
+ * @param qps       returns the queuepairs, must hold smlt_reduce_num_sources()
+ *
+ * The shared memory channel to the children of a hybrid node has one
+ * queuepair per child for the messages towards the owner.
+ */
+static void smlt_reduce_get_sources(struct smlt_channel *children,
+                                    uint32_t count, struct smlt_qp **qps)
+{
+    uint32_t num = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        struct smlt_channel *chan = &children[i];
+        if (chan->use_shm) {
+            for (uint32_t j = 0; j < chan->m; j++) {
+                qps[num++] = chan->c.shm.recv_owner[j];
+            }
+        } else if (chan->owner == smlt_node_self_id) {
+            qps[num++] = &chan->c.mp.send[0];
+        } else {
+            qps[num++] = &chan->c.mp.recv[0];
+        }
+    }
+}
+
+/**
+ * @brief receives one message from each source and combines it into dest
+ *
+ * @param qps       the queuepairs to receive from
+ * @param num_src   the number of queuepairs
+ * @param dest      the partial result to combine the messages into
+ * @param msg       receive buffer, large enough to hold dest
+ * @param desc      the combining operation
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The messages are combined in the order they arrive.
+ */
+static errval_t smlt_reduce_recv_sources(struct smlt_qp **qps,
+                                         uint32_t num_src,
+                                         struct smlt_msg *dest,
+                                         struct smlt_msg *msg,
+                                         struct smlt_reduce_desc *desc)
+{
+    errval_t err;
+
+    bool recv[num_src];
+    memset(recv, 0, sizeof(bool)*num_src);
     unsigned num_recv = 0;
     unsigned i = 0;
-    while( num_recv < count) {
-        if (!recv[i] && smlt_channel_can_recv(&children[i])) {
-            err = smlt_channel_recv(&children[i], result);
+    while( num_recv < num_src) {
+        if (!recv[i] && smlt_queuepair_can_recv(qps[i])) {
+            /* single slot messages do not carry their length */
+            msg->words = dest->words;
+            err = smlt_queuepair_recv(qps[i], msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            err = smlt_reduce_combine(desc, dest, msg);
             if (smlt_err_is_fail(err)) {
                 return err;
             }
@@ -75,25 +149,60 @@ errval_t smlt_reduce(struct smlt_context *ctx,
 
         i++;
 
-        if (i == count) {
+        if (i == num_src) {
             i = 0;
         }
     }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief combines the messages of the children into the result and sends
+ *        it to the parent
+ *
+ * @param ctx       The smelt context
+ * @param result    the contribution of this node, returns the partial result
+ * @param desc      the combining operation
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+static errval_t smlt_reduce_tree(struct smlt_context *ctx,
+                                 struct smlt_msg *result,
+                                 struct smlt_reduce_desc *desc)
+{
+    errval_t err;
+
     /*
-    for (uint32_t i = 0; i < count; ++i) {
+     * Each client receives (potentially from several children) and
+     * sends only ONCE. On which level of the tree hierarchy this is
+     * does not matter. If a client would send several messages, we
+     * would have circles in the tree.
+     */
 
-        err = smlt_channel_recv(&children[i], result);
-        if (smlt_err_is_fail(err)) {
-            // TODO: error handling
-        }
+    uint32_t count = 0;
+    struct smlt_channel *children;
+    err =  smlt_context_get_children_channels(ctx, &children, &count);
+    if (smlt_err_is_fail(err)) {
+        return err; // TODO: adding more error values
+    }
 
-        err = operation(input, result);
+    // Receive (this will be from several children)
+    // --------------------------------------------------
+    uint32_t num_src = smlt_reduce_num_sources(children, count);
+    if (num_src) {
+        struct smlt_qp *qps[num_src];
+        smlt_reduce_get_sources(children, count, qps);
+
+        struct smlt_msg *msg = smlt_reduce_get_scratch(result->bufsize);
+
+        err = smlt_reduce_recv_sources(qps, num_src, result, msg, desc);
         if (smlt_err_is_fail(err)) {
-            // TODO: error handling
+            return err;
         }
     }
-    */
-    // Receive (this will be from several children)
+
+    // Send (this should only be sending one message)
     // --------------------------------------------------
     struct smlt_channel *parent;
     err =  smlt_context_get_parent_channel(ctx, &parent);
@@ -102,12 +211,267 @@ errval_t smlt_reduce(struct smlt_context *ctx,
     }
 
     if (parent) {
-        smlt_channel_send(parent, result);
+        return smlt_channel_send(parent, result);
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief combines the messages of the children into the result chunk by
+ *        chunk, forwarding each chunk to the parent once it is complete
+ *
+ * @param ctx       The smelt context
+ * @param result    the contribution of this node, returns the partial result
+ * @param desc      the combining operation
+ * @param to_parent forward the chunks to the parent
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * The chunks are views into the result buffer, only the chunks of the
+ * children are copied into a single slot sized buffer.
+ */
+static errval_t smlt_reduce_tree_pipelined(struct smlt_context *ctx,
+                                           struct smlt_msg *result,
+                                           struct smlt_reduce_desc *desc,
+                                           bool to_parent)
+{
+    errval_t err;
+
+    uint32_t count = 0;
+    struct smlt_channel *children;
+    err =  smlt_context_get_children_channels(ctx, &children, &count);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_channel *parent = NULL;
+    if (to_parent) {
+        err =  smlt_context_get_parent_channel(ctx, &parent);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    uint32_t num_src = smlt_reduce_num_sources(children, count);
+    struct smlt_qp *qps[num_src + 1];  // avoid a zero length array
+    smlt_reduce_get_sources(children, count, qps);
+
+    smlt_msg_payload_t buf[SMLT_MSG_CHUNK_WORDS];
+    struct smlt_msg msg = {
+        .words = SMLT_MSG_CHUNK_WORDS,
+        .bufsize = sizeof(buf),
+        .data = buf
+    };
+
+    for (uint32_t offset = 0; offset < result->words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        uint32_t words = result->words - offset;
+        if (words > SMLT_MSG_CHUNK_WORDS) {
+            words = SMLT_MSG_CHUNK_WORDS;
+        }
+
+        struct smlt_msg chunk = {
+            .words = words,
+            .bufsize = words * sizeof(smlt_msg_payload_t),
+            .data = result->data + offset
+        };
+
+        if (num_src) {
+            err = smlt_reduce_recv_sources(qps, num_src, &chunk, &msg, desc);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        if (parent) {
+            err = smlt_channel_send(parent, &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Reductions
+ * ===========================================================================
+ */
+
+/**
+ * @brief initializes the result with the input of this node
+ *
+ * @param input     input for the reduction
+ * @param result    returns a copy of the input, may be the input itself
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the result buffer is too small
+ */
+errval_t smlt_reduce_copy_input(struct smlt_msg *input,
+                                struct smlt_msg *result)
+{
+    if (input == result) {
+        return SMLT_SUCCESS;
     }
 
+    if (result->bufsize < input->words * sizeof(smlt_msg_payload_t)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    memcpy(result->data, input->data,
+           input->words * sizeof(smlt_msg_payload_t));
+    result->words = input->words;
+
     return SMLT_SUCCESS;
 }
 
+/**
+ * @brief performs a reduction on the current instance
+ *
+ * @param ctx       The smelt context
+ * @param msg        input for the reduction
+ * @param result     returns the result of the reduction
+ * @param operation  function to be called to calculate the aggregate
+ *
+ * @returns TODO:errval
+ */
+errval_t smlt_reduce(struct smlt_context *ctx,
+                     struct smlt_msg *input,
+                     struct smlt_msg *result,
+                     smlt_reduce_fn_t operation)
+{
+    if (!operation) {
+        return smlt_reduce_notify(ctx);
+    }
+
+    operation(result, input);
+
+    struct smlt_reduce_desc desc = {
+        .fn = operation
+    };
+
+    return smlt_reduce_tree(ctx, result, &desc);
+}
+
+/**
+ * @brief performs a reduction using a builtin operation
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_builtin(struct smlt_context *ctx,
+                             struct smlt_msg *input,
+                             struct smlt_msg *result,
+                             smlt_reduce_op_t op,
+                             smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_reduce_copy_input(input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_reduce_desc desc = {
+        .fn = NULL,
+        .op = op,
+        .dtype = dtype
+    };
+
+    return smlt_reduce_tree(ctx, result, &desc);
+}
+
+/**
+ * @brief performs a reduction using a builtin operation, streaming the
+ *        message up the tree in chunks
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_pipelined(struct smlt_context *ctx,
+                               struct smlt_msg *input,
+                               struct smlt_msg *result,
+                               smlt_reduce_op_t op,
+                               smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_reduce_copy_input(input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_reduce_desc desc = {
+        .fn = NULL,
+        .op = op,
+        .dtype = dtype
+    };
+
+    return smlt_reduce_tree_pipelined(ctx, result, &desc, true);
+}
+
+/**
+ * @brief performs a pipelined reduction of the subtree rooted at the
+ *        calling node
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction of the subtree
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_pipelined_subtree(struct smlt_context *ctx,
+                                       struct smlt_msg *input,
+                                       struct smlt_msg *result,
+                                       smlt_reduce_op_t op,
+                                       smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_reduce_copy_input(input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_reduce_desc desc = {
+        .fn = NULL,
+        .op = op,
+        .dtype = dtype
+    };
+
+    return smlt_reduce_tree_pipelined(ctx, result, &desc, false);
+}
+
 /**
  * @brief checks if the children already send something for the reduction
  *
@@ -237,3 +601,227 @@ errval_t smlt_reduce_all(struct smlt_context *ctx,
 
     return smlt_broadcast(ctx, result);
 }
+
+/**
+ * @brief performs a reduction using a builtin operation and distributes the
+ *        result to all nodes
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_all_builtin(struct smlt_context *ctx,
+                                 struct smlt_msg *input,
+                                 struct smlt_msg *result,
+                                 smlt_reduce_op_t op,
+                                 smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    err = smlt_reduce_builtin(ctx, input, result, op, dtype);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    return smlt_broadcast(ctx, result);
+}
+
+/**
+ * @brief performs a pipelined reduction using a builtin operation and
+ *        distributes the result to all nodes with a pipelined broadcast
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_reduce_all_pipelined(struct smlt_context *ctx,
+                                   struct smlt_msg *input,
+                                   struct smlt_msg *result,
+                                   smlt_reduce_op_t op,
+                                   smlt_reduce_dtype_t dtype)
+{
+    errval_t err;
+
+    err = smlt_reduce_pipelined(ctx, input, result, op, dtype);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    return smlt_broadcast_pipelined(ctx, result);
+}
+
+
+/*
+ * ===========================================================================
+ * Non-blocking reduction
+ * ===========================================================================
+ */
+
+/// phases of a non-blocking reduction
+enum {
+    SMLT_IREDUCE_START = 0,     ///< the sources have not been polled yet
+    SMLT_IREDUCE_RECV,          ///< receiving the messages of the children
+};
+
+/// the sources received from, only one request of a node progresses at a time
+static __thread bool *smlt_reduce_recvd = NULL;
+static __thread uint32_t smlt_reduce_recvd_size = 0;
+
+/**
+ * @brief advances a non-blocking reduction
+ *
+ * @param req   the request of the reduction
+ *
+ * @returns SMLT_SUCCESS or error value
+ *
+ * Every source that has not delivered its message yet is polled on each
+ * call, the messages are combined in the order they arrive.
+ */
+errval_t smlt_reduce_progress(struct smlt_request *req)
+{
+    errval_t err;
+
+    struct smlt_qp **qps;
+    uint32_t *sizes;
+    uint32_t num_src;
+    err = smlt_context_get_children_sources(req->ctx, &qps, &sizes, &num_src);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_msg *msg = NULL;
+    if (req->result) {
+        msg = smlt_reduce_get_scratch(req->result->bufsize);
+        if (msg == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+    }
+
+    if (req->state == SMLT_IREDUCE_START) {
+        if (num_src > smlt_reduce_recvd_size) {
+            if (smlt_reduce_recvd) {
+                smlt_platform_free(smlt_reduce_recvd);
+            }
+            smlt_reduce_recvd_size = 0;
+            smlt_reduce_recvd = (bool *) smlt_platform_alloc\
+                (num_src * sizeof(bool), SMLT_DEFAULT_ALIGNMENT, false);
+            if (smlt_reduce_recvd == NULL) {
+                return SMLT_ERR_MALLOC_FAIL;
+            }
+            smlt_reduce_recvd_size = num_src;
+        }
+        if (num_src) {
+            memset(smlt_reduce_recvd, 0, num_src * sizeof(bool));
+        }
+        req->state = SMLT_IREDUCE_RECV;
+    }
+
+    /* pos counts the sources received from */
+    for (uint32_t i = 0; i < num_src && req->pos < num_src; i++) {
+        struct smlt_qp *qp = qps[i];
+        if (smlt_reduce_recvd[i] || !smlt_queuepair_can_recv(qp)) {
+            continue;
+        }
+
+        if (req->result == NULL) {
+            err = smlt_queuepair_recv0(qp);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        } else {
+            /* single slot messages do not carry their length */
+            msg->words = req->result->words;
+            err = smlt_queuepair_recv(qp, msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+
+            err = smlt_reduce_op_apply(req->op, req->dtype, req->result, msg);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        smlt_reduce_recvd[i] = true;
+        req->pos++;
+    }
+
+    if (req->pos < num_src) {
+        return SMLT_SUCCESS;
+    }
+
+    struct smlt_channel *parent;
+    err =  smlt_context_get_parent_channel(req->ctx, &parent);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (parent) {
+        if (req->result) {
+            err = smlt_channel_send(parent, req->result);
+        } else {
+            err = smlt_channel_notify(parent);
+        }
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    req->done = true;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief starts a reduction using a builtin operation without waiting for it
+ *
+ * @param ctx       The smelt context
+ * @param input     input for the reduction
+ * @param result    returns the result of the reduction
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param req       returns the request to pass to smlt_test() or smlt_wait()
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value
+ */
+errval_t smlt_ireduce(struct smlt_context *ctx,
+                      struct smlt_msg *input,
+                      struct smlt_msg *result,
+                      smlt_reduce_op_t op,
+                      smlt_reduce_dtype_t dtype,
+                      struct smlt_request **req)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL || req == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    err = smlt_reduce_copy_input(input, result);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    err = smlt_request_start(ctx, smlt_reduce_progress, req);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    (*req)->result = result;
+    (*req)->op = op;
+    (*req)->dtype = dtype;
+
+    /* errors are reported by smlt_test() and smlt_wait() */
+    smlt_progress();
+
+    return SMLT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_message.h>
+#include <smlt_reduction.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+/*
+ * ===========================================================================
+ * Kernels
+ * ===========================================================================
+ */
+
+/*
+ * The kernels are plain loops the compiler vectorizes. On x86_64 a clone is
+ * built for AVX-512 and AVX2 and the best one is selected at load time.
+ */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define SMLT_REDUCE_KERNEL_ATTR \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define SMLT_REDUCE_KERNEL_ATTR
+#endif
+
+typedef void (*smlt_reduce_kernel_t)(void *dst, const void *src, size_t num);
+
+#define SMLT_REDUCE_KERNEL(_name, _type, _expr)                             \
+    static SMLT_REDUCE_KERNEL_ATTR void _name(void *dst, const void *src,   \
+                                             size_t num)                    \
+    {                                                                       \
+        _type *restrict d = (_type *) dst;                                  \
+        const _type *restrict s = (const _type *) src;                      \
+        for (size_t i = 0; i < num; i++) {                                  \
+            _type a = d[i];                                                 \
+            _type b = s[i];                                                 \
+            d[i] = (_expr);                                                 \
+        }                                                                   \
+    }
+
+#define SMLT_REDUCE_KERNELS_ARITH(_suffix, _type)                           \
+    SMLT_REDUCE_KERNEL(smlt_reduce_sum_##_suffix, _type, a + b)             \
+    SMLT_REDUCE_KERNEL(smlt_reduce_min_##_suffix, _type, b < a ? b : a)     \
+    SMLT_REDUCE_KERNEL(smlt_reduce_max_##_suffix, _type, b > a ? b : a)
+
+#define SMLT_REDUCE_KERNELS_BITWISE(_suffix, _type)                         \
+    SMLT_REDUCE_KERNEL(smlt_reduce_band_##_suffix, _type, a & b)            \
+    SMLT_REDUCE_KERNEL(smlt_reduce_bor_##_suffix, _type, a | b)             \
+    SMLT_REDUCE_KERNEL(smlt_reduce_bxor_##_suffix, _type, a ^ b)
+
+SMLT_REDUCE_KERNELS_ARITH(u32, uint32_t)
+SMLT_REDUCE_KERNELS_ARITH(u64, uint64_t)
+SMLT_REDUCE_KERNELS_ARITH(i64, int64_t)
+SMLT_REDUCE_KERNELS_ARITH(f32, float)
+SMLT_REDUCE_KERNELS_ARITH(f64, double)
+
+SMLT_REDUCE_KERNELS_BITWISE(u32, uint32_t)
+SMLT_REDUCE_KERNELS_BITWISE(u64, uint64_t)
+SMLT_REDUCE_KERNELS_BITWISE(i64, int64_t)
+
+/// kernels indexed by operation and data type, NULL if not supported
+static const smlt_reduce_kernel_t
+smlt_reduce_kernels[SMLT_REDUCE_OP_NUM][SMLT_REDUCE_DTYPE_NUM] = {
+    [SMLT_REDUCE_OP_SUM] = {
+        smlt_reduce_sum_u32, smlt_reduce_sum_u64, smlt_reduce_sum_i64,
+        smlt_reduce_sum_f32, smlt_reduce_sum_f64
+    },
+    [SMLT_REDUCE_OP_MIN] = {
+        smlt_reduce_min_u32, smlt_reduce_min_u64, smlt_reduce_min_i64,
+        smlt_reduce_min_f32, smlt_reduce_min_f64
+    },
+    [SMLT_REDUCE_OP_MAX] = {
+        smlt_reduce_max_u32, smlt_reduce_max_u64, smlt_reduce_max_i64,
+        smlt_reduce_max_f32, smlt_reduce_max_f64
+    },
+    [SMLT_REDUCE_OP_BAND] = {
+        smlt_reduce_band_u32, smlt_reduce_band_u64, smlt_reduce_band_i64,
+        NULL, NULL
+    },
+    [SMLT_REDUCE_OP_BOR] = {
+        smlt_reduce_bor_u32, smlt_reduce_bor_u64, smlt_reduce_bor_i64,
+        NULL, NULL
+    },
+    [SMLT_REDUCE_OP_BXOR] = {
+        smlt_reduce_bxor_u32, smlt_reduce_bxor_u64, smlt_reduce_bxor_i64,
+        NULL, NULL
+    },
+};
+
+/// size of the elements in bytes indexed by data type
+static const size_t smlt_reduce_dtype_size[SMLT_REDUCE_DTYPE_NUM] = {
+    [SMLT_REDUCE_DTYPE_U32] = sizeof(uint32_t),
+    [SMLT_REDUCE_DTYPE_U64] = sizeof(uint64_t),
+    [SMLT_REDUCE_DTYPE_I64] = sizeof(int64_t),
+    [SMLT_REDUCE_DTYPE_F32] = sizeof(float),
+    [SMLT_REDUCE_DTYPE_F64] = sizeof(double),
+};
+
+
+/*
+ * ===========================================================================
+ * Operator interface
+ * ===========================================================================
+ */
+
+/**
+ * @brief checks whether the operation is defined for the data type
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns TRUE if the operation can be applied to the data type
+ */
+bool smlt_reduce_op_is_valid(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype)
+{
+    if (op >= SMLT_REDUCE_OP_NUM || dtype >= SMLT_REDUCE_DTYPE_NUM) {
+        return false;
+    }
+
+    return smlt_reduce_kernels[op][dtype] != NULL;
+}
+
+/**
+ * @brief combines the elements of two messages using a builtin operation
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param dest      the first operand, returns the result
+ * @param src       the second operand
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+errval_t smlt_reduce_op_apply(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype,
+                              struct smlt_msg *dest, struct smlt_msg *src)
+{
+    if (!smlt_reduce_op_is_valid(op, dtype)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (dest->words != src->words || dest->data == src->data) {
+        return SMLT_ERR_INVAL;
+    }
+
+    size_t num = (dest->words * sizeof(smlt_msg_payload_t))
+                    / smlt_reduce_dtype_size[dtype];
+
+    smlt_reduce_kernels[op][dtype](dest->data, src->data, num);
+
+    return SMLT_SUCCESS;
+}
+
+#define SMLT_REDUCE_FILL(_type, _data, _num, _val)                          \
+    do {                                                                    \
+        _type *d = (_type *) (_data);                                       \
+        for (size_t i = 0; i < (_num); i++) {                               \
+            d[i] = (_val);                                                  \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief fills the message with the identity element of the operation
+ *
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param msg       the message to fill, msg->words words are written
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL
+ */
+errval_t smlt_reduce_op_identity(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype,
+                                 struct smlt_msg *msg)
+{
+    if (!smlt_reduce_op_is_valid(op, dtype)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    size_t bytes = msg->words * sizeof(smlt_msg_payload_t);
+    size_t num = bytes / smlt_reduce_dtype_size[dtype];
+
+    switch(op) {
+        case SMLT_REDUCE_OP_SUM :
+        case SMLT_REDUCE_OP_BOR :
+        case SMLT_REDUCE_OP_BXOR :
+            /* all zero bits are 0 and +0.0 */
+            memset(msg->data, 0, bytes);
+            break;
+        case SMLT_REDUCE_OP_BAND :
+            memset(msg->data, 0xff, bytes);
+            break;
+        case SMLT_REDUCE_OP_MIN :
+            switch(dtype) {
+                case SMLT_REDUCE_DTYPE_U32 :
+                    SMLT_REDUCE_FILL(uint32_t, msg->data, num, UINT32_MAX);
+                    break;
+                case SMLT_REDUCE_DTYPE_U64 :
+                    SMLT_REDUCE_FILL(uint64_t, msg->data, num, UINT64_MAX);
+                    break;
+                case SMLT_REDUCE_DTYPE_I64 :
+                    SMLT_REDUCE_FILL(int64_t, msg->data, num, INT64_MAX);
+                    break;
+                case SMLT_REDUCE_DTYPE_F32 :
+                    SMLT_REDUCE_FILL(float, msg->data, num, INFINITY);
+                    break;
+                default:
+                    SMLT_REDUCE_FILL(double, msg->data, num, INFINITY);
+                    break;
+            }
+            break;
+        default:
+            switch(dtype) {
+                case SMLT_REDUCE_DTYPE_U32 :
+                case SMLT_REDUCE_DTYPE_U64 :
+                    memset(msg->data, 0, bytes);
+                    break;
+                case SMLT_REDUCE_DTYPE_I64 :
+                    SMLT_REDUCE_FILL(int64_t, msg->data, num, INT64_MIN);
+                    break;
+                case SMLT_REDUCE_DTYPE_F32 :
+                    SMLT_REDUCE_FILL(float, msg->data, num, -INFINITY);
+                    break;
+                default:
+                    SMLT_REDUCE_FILL(double, msg->data, num, -INFINITY);
+                    break;
+            }
+            break;
+    }
+
+    return SMLT_SUCCESS;
+}
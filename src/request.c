@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_node.h>
+#include <smlt_platform.h>
+#include <smlt_request.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/// the pending requests of the node, in the order they were started
+static __thread struct smlt_request *smlt_request_head = NULL;
+static __thread struct smlt_request *smlt_request_tail = NULL;
+
+/// released requests to be reused
+static __thread struct smlt_request *smlt_request_free = NULL;
+
+/**
+ * @brief returns a completed request to the free list
+ */
+static void smlt_request_release(struct smlt_request *req)
+{
+    req->next = smlt_request_free;
+    smlt_request_free = req;
+}
+
+/**
+ * @brief starts a non-blocking operation on the calling node
+ *
+ * @param ctx       the context of the operation
+ * @param progress  the function advancing the operation
+ * @param req       returns the request, its state is cleared
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_request_start(struct smlt_context *ctx,
+                            smlt_request_fn_t progress,
+                            struct smlt_request **req)
+{
+    struct smlt_request *r = smlt_request_free;
+    if (r) {
+        smlt_request_free = r->next;
+    } else {
+        r = smlt_platform_alloc(sizeof(struct smlt_request),
+                                SMLT_ARCH_CACHELINE_SIZE, false);
+        if (r == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+    }
+
+    memset(r, 0, sizeof(*r));
+    r->ctx = ctx;
+    r->progress = progress;
+    r->err = SMLT_SUCCESS;
+
+    if (smlt_request_tail) {
+        smlt_request_tail->next = r;
+    } else {
+        smlt_request_head = r;
+    }
+    smlt_request_tail = r;
+
+    *req = r;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief advances the pending requests of the calling node
+ *
+ * @returns SMLT_SUCCESS or the error value of a failed request
+ */
+errval_t smlt_progress(void)
+{
+    while (smlt_request_head) {
+        struct smlt_request *req = smlt_request_head;
+
+        errval_t err = req->progress(req);
+        if (smlt_err_is_fail(err)) {
+            SMLT_DEBUG(SMLT_DBG__GENERAL, "Node %d: request %p failed\n",
+                       smlt_node_get_id(), (void *) req);
+            req->err = err;
+            req->done = true;
+        }
+
+        if (!req->done) {
+            return SMLT_SUCCESS;
+        }
+
+        smlt_request_head = req->next;
+        if (smlt_request_head == NULL) {
+            smlt_request_tail = NULL;
+        }
+        req->next = NULL;
+
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief checks whether a request is completed
+ *
+ * @param req       the request
+ * @param done      returns true if the request is completed
+ *
+ * @returns SMLT_SUCCESS or the error value of the operation
+ */
+errval_t smlt_test(struct smlt_request *req, bool *done)
+{
+    if (req == NULL || done == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    if (!req->done) {
+        smlt_progress();
+    }
+
+    *done = req->done;
+    if (!req->done) {
+        return SMLT_SUCCESS;
+    }
+
+    errval_t err = req->err;
+    smlt_request_release(req);
+
+    return err;
+}
+
+/**
+ * @brief waits until a request is completed
+ *
+ * @param req       the request
+ *
+ * @returns SMLT_SUCCESS or the error value of the operation
+ */
+errval_t smlt_wait(struct smlt_request *req)
+{
+    if (req == NULL) {
+        return SMLT_ERR_INVAL;
+    }
+
+    while (!req->done) {
+        smlt_progress();
+    }
+
+    errval_t err = req->err;
+    smlt_request_release(req);
+
+    return err;
+}
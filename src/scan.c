@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_reduction.h>
+#include <smlt_scan.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/// holds the partial results of the children and the prefixes
+static __thread struct smlt_msg *smlt_scan_scratch = NULL;
+
+/**
+ * @brief returns the scratch buffer, growing it to hold at least bufsize bytes
+ */
+static struct smlt_msg *smlt_scan_get_scratch(uint32_t bufsize)
+{
+    if (smlt_scan_scratch && smlt_scan_scratch->bufsize < bufsize) {
+        smlt_message_free(smlt_scan_scratch);
+        smlt_scan_scratch = NULL;
+    }
+
+    if (smlt_scan_scratch == NULL) {
+        smlt_scan_scratch = smlt_message_alloc(bufsize);
+    }
+
+    return smlt_scan_scratch;
+}
+
+/**
+ * @brief obtains a message view of the words starting at data
+ */
+static inline struct smlt_msg smlt_scan_view(smlt_msg_payload_t *data,
+                                             uint32_t words)
+{
+    struct smlt_msg msg = {
+        .words = words,
+        .bufsize = words * sizeof(smlt_msg_payload_t),
+        .data = data
+    };
+
+    return msg;
+}
+
+/**
+ * @brief combines src into dest, both holding words words
+ */
+static inline errval_t smlt_scan_combine(smlt_reduce_op_t op,
+                                         smlt_reduce_dtype_t dtype,
+                                         smlt_msg_payload_t *dest,
+                                         smlt_msg_payload_t *src,
+                                         uint32_t words)
+{
+    struct smlt_msg d = smlt_scan_view(dest, words);
+    struct smlt_msg s = smlt_scan_view(src, words);
+
+    return smlt_reduce_op_apply(op, dtype, &d, &s);
+}
+
+/*
+ * ===========================================================================
+ * Chunked transfers
+ * ===========================================================================
+ */
+
+static errval_t smlt_scan_send(struct smlt_channel *chan,
+                               smlt_msg_payload_t *data, uint32_t words)
+{
+    errval_t err;
+
+    for (uint32_t offset = 0; offset < words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        uint32_t num = words - offset;
+        if (num > SMLT_MSG_CHUNK_WORDS) {
+            num = SMLT_MSG_CHUNK_WORDS;
+        }
+
+        struct smlt_msg chunk = smlt_scan_view(data + offset, num);
+        err = smlt_channel_send(chan, &chunk);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief receives from a child if qp is set, from the parent otherwise
+ */
+static errval_t smlt_scan_recv(struct smlt_qp *qp, struct smlt_channel *parent,
+                               uint32_t idx, smlt_msg_payload_t *data,
+                               uint32_t words)
+{
+    errval_t err;
+
+    for (uint32_t offset = 0; offset < words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        uint32_t num = words - offset;
+        if (num > SMLT_MSG_CHUNK_WORDS) {
+            num = SMLT_MSG_CHUNK_WORDS;
+        }
+
+        /* single slot messages do not carry their length */
+        struct smlt_msg chunk = smlt_scan_view(data + offset, num);
+        if (qp) {
+            err = smlt_queuepair_recv(qp, &chunk);
+        } else {
+            err = smlt_channel_recv_index(parent, &chunk, idx);
+        }
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Up-sweep / down-sweep
+ * ===========================================================================
+ */
+
+/**
+ * @brief computes the prefix reduction over the tree
+ *
+ * @param ctx       The smelt context
+ * @param input     the contribution of this node
+ * @param result    returns the prefix
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ * @param inclusive include the contribution of this node
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ *
+ * Up-sweep: every node combines its input with the partial results of the
+ * subtrees of its children and sends it to its parent. Down-sweep: every
+ * node receives the prefix of the ranks before it from its parent and
+ * sends each child the prefix extended by its own input and the subtrees
+ * of the children before it. The children on a shared memory channel
+ * receive the prefixes of all of them and pick their own.
+ */
+static errval_t smlt_scan_tree(struct smlt_context *ctx,
+                               struct smlt_msg *input,
+                               struct smlt_msg *result,
+                               smlt_reduce_op_t op,
+                               smlt_reduce_dtype_t dtype,
+                               bool inclusive)
+{
+    errval_t err;
+
+    if (!smlt_reduce_op_is_valid(op, dtype) || input == NULL ||
+        result == NULL || input->words == 0 ||
+        result->bufsize < input->words * sizeof(smlt_msg_payload_t)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t words = input->words;
+
+    uint32_t count = 0;
+    struct smlt_channel *children;
+    err =  smlt_context_get_children_channels(ctx, &children, &count);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_qp **qps;
+    uint32_t num_src;
+    err = smlt_context_get_children_sources(ctx, &qps, NULL, &num_src);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    struct smlt_channel *parent;
+    err =  smlt_context_get_parent_channel(ctx, &parent);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    /* the number of prefixes sent on one channel */
+    uint32_t num_tmp = 1;
+    if (parent && parent->use_shm) {
+        num_tmp = parent->m;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (children[i].use_shm && children[i].m > num_tmp) {
+            num_tmp = children[i].m;
+        }
+    }
+
+    struct smlt_msg *buf = smlt_scan_get_scratch
+        ((num_src + 2 + num_tmp) * words * sizeof(smlt_msg_payload_t));
+    if (buf == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    smlt_msg_payload_t *sums = buf->data;           // subtrees of children
+    smlt_msg_payload_t *prefix = sums + num_src * words;
+    smlt_msg_payload_t *own = prefix + words;
+    smlt_msg_payload_t *tmp = own + words;
+
+    memcpy(own, input->data, words * sizeof(smlt_msg_payload_t));
+
+    // Up-sweep
+    // --------------------------------------------------
+    for (uint32_t i = 0; i < num_src; i++) {
+        err = smlt_scan_recv(qps[i], NULL, 0, sums + i * words, words);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    if (parent) {
+        memcpy(tmp, own, words * sizeof(smlt_msg_payload_t));
+        for (uint32_t i = 0; i < num_src; i++) {
+            err = smlt_scan_combine(op, dtype, tmp, sums + i * words, words);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        err = smlt_scan_send(parent, tmp, words);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    // Down-sweep
+    // --------------------------------------------------
+    if (parent) {
+        uint32_t idx = smlt_context_node_get_child_idx(ctx);
+        if (parent->use_shm) {
+            err = smlt_scan_recv(NULL, parent, idx, tmp, parent->m * words);
+            memcpy(prefix, tmp + idx * words,
+                   words * sizeof(smlt_msg_payload_t));
+        } else {
+            err = smlt_scan_recv(NULL, parent, idx, prefix, words);
+        }
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    } else {
+        struct smlt_msg p = smlt_scan_view(prefix, words);
+        err = smlt_reduce_op_identity(op, dtype, &p);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    if (!inclusive) {
+        memcpy(result->data, prefix, words * sizeof(smlt_msg_payload_t));
+    }
+
+    /* the prefix of the first child: the prefix of this node and its input */
+    err = smlt_scan_combine(op, dtype, prefix, own, words);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    if (inclusive) {
+        memcpy(result->data, prefix, words * sizeof(smlt_msg_payload_t));
+    }
+    result->words = words;
+
+    uint32_t src = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (children[i].use_shm) {
+            for (uint32_t j = 0; j < children[i].m; j++) {
+                memcpy(tmp + j * words, prefix,
+                       words * sizeof(smlt_msg_payload_t));
+                err = smlt_scan_combine(op, dtype, prefix,
+                                        sums + src++ * words, words);
+                if (smlt_err_is_fail(err)) {
+                    return err;
+                }
+            }
+            err = smlt_scan_send(&children[i], tmp, children[i].m * words);
+        } else {
+            err = smlt_scan_send(&children[i], prefix, words);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+            err = smlt_scan_combine(op, dtype, prefix, sums + src++ * words,
+                                    words);
+        }
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+
+/*
+ * ===========================================================================
+ * Smelt prefix reductions
+ * ===========================================================================
+ */
+
+/**
+ * @brief computes the inclusive prefix reduction in the order of the ranks
+ *
+ * @param ctx       The smelt context
+ * @param input     the contribution of this node
+ * @param result    returns the reduction of the nodes up to this one
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_scan(struct smlt_context *ctx,
+                   struct smlt_msg *input,
+                   struct smlt_msg *result,
+                   smlt_reduce_op_t op,
+                   smlt_reduce_dtype_t dtype)
+{
+    return smlt_scan_tree(ctx, input, result, op, dtype, true);
+}
+
+/**
+ * @brief computes the exclusive prefix reduction in the order of the ranks
+ *
+ * @param ctx       The smelt context
+ * @param input     the contribution of this node
+ * @param result    returns the reduction of the nodes before this one
+ * @param op        the reduction operation
+ * @param dtype     the type of the elements
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_exscan(struct smlt_context *ctx,
+                     struct smlt_msg *input,
+                     struct smlt_msg *result,
+                     smlt_reduce_op_t op,
+                     smlt_reduce_dtype_t dtype)
+{
+    return smlt_scan_tree(ctx, input, result, op, dtype, false);
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_channel.h>
+#include <smlt_context.h>
+#include <smlt_scatter.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/// holds the blocks received from the parent on the interior nodes
+static __thread struct smlt_msg *smlt_scatter_scratch = NULL;
+
+/**
+ * @brief returns the receive buffer, growing it to hold at least bufsize bytes
+ */
+static struct smlt_msg *smlt_scatter_get_scratch(uint32_t bufsize)
+{
+    if (smlt_scatter_scratch && smlt_scatter_scratch->bufsize < bufsize) {
+        smlt_message_free(smlt_scatter_scratch);
+        smlt_scatter_scratch = NULL;
+    }
+
+    if (smlt_scatter_scratch == NULL) {
+        smlt_scatter_scratch = smlt_message_alloc(bufsize);
+    }
+
+    return smlt_scatter_scratch;
+}
+
+/**
+ * @brief obtains a view of a chunk of the buffer
+ */
+static inline struct smlt_msg smlt_scatter_chunk(smlt_msg_payload_t *data,
+                                                 uint32_t offset,
+                                                 uint32_t end)
+{
+    uint32_t words = end - offset;
+    if (words > SMLT_MSG_CHUNK_WORDS) {
+        words = SMLT_MSG_CHUNK_WORDS;
+    }
+
+    struct smlt_msg chunk = {
+        .words = words,
+        .bufsize = words * sizeof(smlt_msg_payload_t),
+        .data = data + offset
+    };
+
+    return chunk;
+}
+
+/**
+ * @brief receives the blocks served by the parent channel
+ */
+static errval_t smlt_scatter_recv_parent(struct smlt_context *ctx,
+                                         smlt_msg_payload_t *data,
+                                         uint32_t words)
+{
+    errval_t err;
+
+    struct smlt_channel *parent;
+    err =  smlt_context_get_parent_channel(ctx, &parent);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t idx = smlt_context_node_get_child_idx(ctx);
+
+    for (uint32_t offset = 0; offset < words;
+         offset += SMLT_MSG_CHUNK_WORDS) {
+        /* single slot messages do not carry their length */
+        struct smlt_msg chunk = smlt_scatter_chunk(data, offset, words);
+        err = smlt_channel_recv_index(parent, &chunk, idx);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief sends each child channel the blocks of the subtrees it serves
+ *
+ * @param ctx       The smelt context
+ * @param data      the blocks of the subtree of this node, its own first
+ * @param words     number of words of a block
+ *
+ * @returns SMLT_SUCCESS or error value
+ */
+static errval_t smlt_scatter_send_children(struct smlt_context *ctx,
+                                           smlt_msg_payload_t *data,
+                                           uint32_t words)
+{
+    errval_t err;
+
+    uint32_t count = 0;
+    struct smlt_channel *children;
+    err =  smlt_context_get_children_channels(ctx, &children, &count);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t *sizes;
+    err = smlt_context_get_children_sources(ctx, NULL, &sizes, NULL);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
+
+    uint32_t src = 0;
+    uint32_t start = words;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t num = children[i].use_shm ? children[i].m : 1;
+        uint32_t end = start;
+        for (uint32_t j = 0; j < num; j++) {
+            end += sizes[src++] * words;
+        }
+
+        for (uint32_t offset = start; offset < end;
+             offset += SMLT_MSG_CHUNK_WORDS) {
+            struct smlt_msg chunk = smlt_scatter_chunk(data, offset, end);
+            err = smlt_channel_send(&children[i], &chunk);
+            if (smlt_err_is_fail(err)) {
+                return err;
+            }
+        }
+
+        start = end;
+    }
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief distributes a block of the root's buffer to each node
+ *
+ * @param ctx           The smelt context
+ * @param sendbuf       the blocks of all nodes, only used on the root
+ * @param block_words   number of words of a block, the same on all nodes
+ * @param recvbuf       returns the block of this node
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL or error value of the channels
+ */
+errval_t smlt_scatter(struct smlt_context *ctx,
+                      struct smlt_msg *sendbuf,
+                      uint32_t block_words,
+                      struct smlt_msg *recvbuf)
+{
+    errval_t err;
+
+    size_t block_size = block_words * sizeof(smlt_msg_payload_t);
+    if (block_words == 0 || recvbuf == NULL || recvbuf->bufsize < block_size) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint32_t rank = smlt_context_get_rank(ctx);
+    smlt_msg_payload_t *data;
+
+    if (smlt_context_is_root(ctx)) {
+        uint32_t num_nodes = smlt_context_get_num_nodes(ctx);
+        if (sendbuf == NULL || sendbuf == recvbuf ||
+            sendbuf->bufsize < num_nodes * block_size) {
+            return SMLT_ERR_INVAL;
+        }
+        data = sendbuf->data;
+    } else {
+        uint32_t first, num;
+        smlt_context_get_parent_ranks(ctx, &first, &num);
+
+        if (num == 1) {
+            /* a leaf on a message passing channel gets its block only */
+            recvbuf->words = block_words;
+            return smlt_scatter_recv_parent(ctx, recvbuf->data, block_words);
+        }
+
+        struct smlt_msg *buf = smlt_scatter_get_scratch(num * block_size);
+        if (buf == NULL) {
+            return SMLT_ERR_MALLOC_FAIL;
+        }
+
+        err = smlt_scatter_recv_parent(ctx, buf->data, num * block_words);
+        if (smlt_err_is_fail(err)) {
+            return err;
+        }
+
+        data = buf->data + (rank - first) * block_words;
+    }
+
+    memcpy(recvbuf->data, data, block_size);
+    recvbuf->words = block_words;
+
+    return smlt_scatter_send_children(ctx, data, block_words);
+}
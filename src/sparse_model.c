@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2016 ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+#include <smlt.h>
+#include <smlt_platform.h>
+#include <smlt_topology.h>
+#include <smlt_generator.h>
+#include <smlt_sparse_model.h>
+#include "smlt_debug.h"
+
+#include <string.h>
+
+/**
+ * @brief checks whether the value is the entry of a parent for its child
+ */
+static inline bool smlt_sparse_model_is_edge(uint16_t val)
+{
+    return (val >= 1 && val <= TOPO_MATRIX_MAX_MP) ||
+           (val >= TOPO_MATRIX_SHM_MASTER_START &&
+            val <= TOPO_MATRIX_SHM_MASTER_MAX);
+}
+
+/**
+ * @brief allocates a sparse model whose nodes have no parents
+ *
+ * @param len           number of nodes
+ *
+ * @returns the model or NULL if the allocation failed
+ */
+struct smlt_sparse_model *smlt_sparse_model_alloc(uint32_t len)
+{
+    struct smlt_sparse_model *sparse = (struct smlt_sparse_model *)
+        smlt_platform_alloc(sizeof(*sparse) +
+                            len * sizeof(struct smlt_sparse_model_node),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (sparse == NULL) {
+        return NULL;
+    }
+
+    sparse->len = len;
+    sparse->nodes = (struct smlt_sparse_model_node *) (sparse + 1);
+    for (uint32_t i = 0; i < len; i++) {
+        sparse->nodes[i].parent = SMLT_SPARSE_MODEL_NO_PARENT;
+    }
+
+    return sparse;
+}
+
+/**
+ * @brief converts a topology matrix into a sparse model
+ *
+ * @param model         the model with the topology matrix
+ * @param sparse        returns the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the matrix is malformed or
+ *          SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_from_model(struct smlt_generated_model *model,
+                                      struct smlt_sparse_model **sparse)
+{
+    uint32_t len = model->len;
+
+    if (model->root >= len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_sparse_model *s = smlt_sparse_model_alloc(len);
+    if (s == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    s->ncores = model->ncores;
+    s->root = model->root;
+
+    for (uint32_t x = 0; x < len; x++) {
+        for (uint32_t y = 0; y < len; y++) {
+            uint16_t val = model->model[x * len + y];
+            if (val == 0) {
+                continue;
+            }
+
+            uint16_t rev = model->model[y * len + x];
+
+            bool ok;
+            if (val <= TOPO_MATRIX_MAX_MP) {
+                ok = (rev == TOPO_MATRIX_PARENT);
+            } else if (val == TOPO_MATRIX_PARENT) {
+                ok = (rev >= 1 && rev <= TOPO_MATRIX_MAX_MP);
+            } else if (val >= TOPO_MATRIX_SHM_MASTER_START &&
+                       val <= TOPO_MATRIX_SHM_MASTER_MAX) {
+                ok = (rev >= TOPO_MATRIX_SHM_SLAVE_START &&
+                      rev <= TOPO_MATRIX_SHM_SLAVE_MAX);
+            } else if (val >= TOPO_MATRIX_SHM_SLAVE_START &&
+                       val <= TOPO_MATRIX_SHM_SLAVE_MAX) {
+                ok = (rev >= TOPO_MATRIX_SHM_MASTER_START &&
+                      rev <= TOPO_MATRIX_SHM_MASTER_MAX);
+            } else {
+                ok = false;
+            }
+
+            if (!ok) {
+                SMLT_WARNING("sparse model: bad entry %" PRIu16 " at %" PRIu32
+                             ", %" PRIu32 "\n", val, x, y);
+                smlt_platform_free(s);
+                return SMLT_ERR_INVAL;
+            }
+
+            if (!smlt_sparse_model_is_edge(val)) {
+                /* the child side of the edge */
+                continue;
+            }
+
+            if (s->nodes[y].parent != SMLT_SPARSE_MODEL_NO_PARENT) {
+                SMLT_WARNING("sparse model: node %" PRIu32 " has two "
+                             "parents\n", y);
+                smlt_platform_free(s);
+                return SMLT_ERR_INVAL;
+            }
+
+            s->nodes[y].parent = x;
+            s->nodes[y].edge = val;
+        }
+    }
+
+    if (s->nodes[s->root].parent != SMLT_SPARSE_MODEL_NO_PARENT) {
+        smlt_platform_free(s);
+        return SMLT_ERR_INVAL;
+    }
+
+    for (uint32_t i = 0; i < model->num_leafs; i++) {
+        if (model->leafs[i] < len) {
+            s->nodes[model->leafs[i]].flags |= SMLT_SPARSE_MODEL_LEAF;
+        }
+    }
+
+    *sparse = s;
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief expands a sparse model into a topology matrix
+ *
+ * @param sparse        the sparse model
+ * @param model         returns the model with the topology matrix
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_to_model(struct smlt_sparse_model *sparse,
+                                    struct smlt_generated_model **model)
+{
+    uint32_t len = sparse->len;
+
+    uint32_t num_leafs = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        if (sparse->nodes[i].flags & SMLT_SPARSE_MODEL_LEAF) {
+            num_leafs++;
+        }
+    }
+
+    struct smlt_generated_model *m = (struct smlt_generated_model*)
+        smlt_platform_alloc(sizeof(struct smlt_generated_model),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (m == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    /* avoid zero sized allocations without leafs */
+    m->model = (uint16_t*) smlt_platform_alloc((size_t) len * len *
+                                               sizeof(uint16_t),
+                                               SMLT_DEFAULT_ALIGNMENT, true);
+    m->leafs = (uint32_t*) smlt_platform_alloc((num_leafs + 1) *
+                                               sizeof(uint32_t),
+                                               SMLT_DEFAULT_ALIGNMENT, true);
+    if (m->model == NULL || m->leafs == NULL) {
+        if (m->model) {
+            smlt_platform_free(m->model);
+        }
+        if (m->leafs) {
+            smlt_platform_free(m->leafs);
+        }
+        smlt_platform_free(m);
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    m->ncores = sparse->ncores;
+    m->len = len;
+    m->root = sparse->root;
+
+    for (uint32_t i = 0; i < len; i++) {
+        struct smlt_sparse_model_node *sn = &sparse->nodes[i];
+        if (sn->flags & SMLT_SPARSE_MODEL_LEAF) {
+            m->leafs[m->num_leafs++] = i;
+        }
+        if (sn->parent == SMLT_SPARSE_MODEL_NO_PARENT) {
+            continue;
+        }
+
+        m->model[sn->parent * len + i] = sn->edge;
+        if (sn->edge <= TOPO_MATRIX_MAX_MP) {
+            m->model[i * len + sn->parent] = TOPO_MATRIX_PARENT;
+        } else {
+            m->model[i * len + sn->parent] = TOPO_MATRIX_SHM_SLAVE_START +
+                (sn->edge - TOPO_MATRIX_SHM_MASTER_START);
+        }
+    }
+
+    *model = m;
+
+    return SMLT_SUCCESS;
+}
+
+/// the states of the nodes while checking the tree
+enum {
+    SMLT_SPARSE_MODEL_UNSEEN = 0,   ///< not visited yet
+    SMLT_SPARSE_MODEL_ON_PATH,      ///< on the path currently walked up
+    SMLT_SPARSE_MODEL_REACHES_ROOT, ///< the root is an ancestor
+};
+
+/**
+ * @brief checks that the parents of the sparse model form a tree
+ *
+ * @param sparse        the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if a node with a parent does not
+ *          reach the root or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_check(struct smlt_sparse_model *sparse)
+{
+    struct smlt_sparse_model_node *nodes = sparse->nodes;
+    uint32_t len = sparse->len;
+
+    if (sparse->root >= len ||
+        nodes[sparse->root].parent != SMLT_SPARSE_MODEL_NO_PARENT) {
+        return SMLT_ERR_INVAL;
+    }
+
+    uint8_t *state = (uint8_t *) smlt_platform_alloc(len, SMLT_DEFAULT_ALIGNMENT,
+                                                     true);
+    if (state == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    state[sparse->root] = SMLT_SPARSE_MODEL_REACHES_ROOT;
+
+    errval_t err = SMLT_SUCCESS;
+    for (uint32_t i = 0; i < len; i++) {
+        if (nodes[i].parent == SMLT_SPARSE_MODEL_NO_PARENT) {
+            continue;
+        }
+
+        /* walk up until a node that was seen before */
+        uint32_t n = i;
+        while (n != SMLT_SPARSE_MODEL_NO_PARENT &&
+               state[n] == SMLT_SPARSE_MODEL_UNSEEN) {
+            if (nodes[n].parent != SMLT_SPARSE_MODEL_NO_PARENT &&
+                nodes[n].parent >= len) {
+                err = SMLT_ERR_INVAL;
+                goto out;
+            }
+            state[n] = SMLT_SPARSE_MODEL_ON_PATH;
+            n = nodes[n].parent;
+        }
+
+        /* a cycle or a node without parent that is not the root */
+        if (n == SMLT_SPARSE_MODEL_NO_PARENT ||
+            state[n] == SMLT_SPARSE_MODEL_ON_PATH) {
+            SMLT_WARNING("sparse model: node %" PRIu32 " does not reach the "
+                         "root\n", i);
+            err = SMLT_ERR_INVAL;
+            goto out;
+        }
+
+        for (n = i; state[n] == SMLT_SPARSE_MODEL_ON_PATH; n = nodes[n].parent) {
+            state[n] = SMLT_SPARSE_MODEL_REACHES_ROOT;
+        }
+    }
+
+    out:
+    smlt_platform_free(state);
+    return err;
+}
+
+/**
+ * @brief returns the size of the serialized sparse model in bytes
+ *
+ * @param sparse        the sparse model
+ *
+ * @returns the number of bytes
+ */
+size_t smlt_sparse_model_size(struct smlt_sparse_model *sparse)
+{
+    return sizeof(struct smlt_sparse_model_header) +
+           sparse->len * sizeof(struct smlt_sparse_model_node);
+}
+
+/**
+ * @brief serializes the sparse model into the buffer
+ *
+ * @param sparse        the sparse model
+ * @param buf           the buffer
+ * @param size          size of the buffer
+ *
+ * @returns SMLT_SUCCESS or SMLT_ERR_INVAL if the buffer is too small
+ */
+errval_t smlt_sparse_model_serialize(struct smlt_sparse_model *sparse,
+                                     void *buf, size_t size)
+{
+    if (buf == NULL || size < smlt_sparse_model_size(sparse)) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_sparse_model_header hdr = {
+        .magic = SMLT_SPARSE_MODEL_MAGIC,
+        .version = SMLT_SPARSE_MODEL_VERSION,
+        .ncores = sparse->ncores,
+        .len = sparse->len,
+        .root = sparse->root,
+        .reserved = 0,
+    };
+
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy((uint8_t *) buf + sizeof(hdr), sparse->nodes,
+           sparse->len * sizeof(struct smlt_sparse_model_node));
+
+    return SMLT_SUCCESS;
+}
+
+/**
+ * @brief reads a serialized sparse model
+ *
+ * @param buf           the buffer, 4-byte aligned
+ * @param size          size of the buffer
+ * @param sparse        returns the sparse model
+ *
+ * @returns SMLT_SUCCESS, SMLT_ERR_INVAL if the buffer does not hold a valid
+ *          model or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_sparse_model_deserialize(void *buf, size_t size,
+                                       struct smlt_sparse_model **sparse)
+{
+    struct smlt_sparse_model_header *hdr = buf;
+
+    if (buf == NULL || size < sizeof(*hdr) ||
+        hdr->magic != SMLT_SPARSE_MODEL_MAGIC ||
+        hdr->version != SMLT_SPARSE_MODEL_VERSION ||
+        size != sizeof(*hdr) + (size_t) hdr->len *
+                sizeof(struct smlt_sparse_model_node) ||
+        hdr->root >= hdr->len) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_sparse_model_node *nodes =
+        (struct smlt_sparse_model_node *) (hdr + 1);
+
+    for (uint32_t i = 0; i < hdr->len; i++) {
+        if (nodes[i].parent == SMLT_SPARSE_MODEL_NO_PARENT) {
+            continue;
+        }
+        if (nodes[i].parent >= hdr->len || i == hdr->root ||
+            !smlt_sparse_model_is_edge(nodes[i].edge) ||
+            (nodes[i].flags & ~SMLT_SPARSE_MODEL_LEAF)) {
+            return SMLT_ERR_INVAL;
+        }
+    }
+
+    *sparse = (struct smlt_sparse_model *)
+        smlt_platform_alloc(sizeof(struct smlt_sparse_model),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (*sparse == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    (*sparse)->ncores = hdr->ncores;
+    (*sparse)->len = hdr->len;
+    (*sparse)->root = hdr->root;
+    (*sparse)->nodes = nodes;
+
+    errval_t err = smlt_sparse_model_check(*sparse);
+    if (smlt_err_is_fail(err)) {
+        smlt_platform_free(*sparse);
+        *sparse = NULL;
+        return err;
+    }
+
+    return SMLT_SUCCESS;
+}
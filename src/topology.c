@@ -9,6 +9,7 @@
 #include <smlt.h>
 #include <smlt_topology.h>
 #include <smlt_generator.h>
+#include <smlt_sparse_model.h>
 #include <smlt_queuepair.h>
 #include "smlt_debug.h"
 #include <stdio.h>
@@ -46,10 +47,10 @@ struct smlt_topology
 };
 
 //prototypes
-static void smlt_topology_create_binary_tree(struct smlt_topology **topology,
-                                             uint32_t num_threads);
-static void smlt_topology_parse_model(struct smlt_generated_model* model,
-                                      struct smlt_topology** topo);
+static errval_t smlt_topology_binary_tree(uint32_t num_threads,
+                                          struct smlt_sparse_model **sparse);
+static errval_t smlt_topology_build_sparse(struct smlt_sparse_model *sparse,
+                                           struct smlt_topology **topo);
 /**
  * @brief initializes the topology subsystem
  *
@@ -70,33 +71,67 @@ errval_t smlt_topology_init(void)
  *
  * @return SMELT_SUCCESS or error value
  *
- * If the model is NULL, then a binary tree will be generated
+ * If the model is NULL, then a binary tree will be generated. Both are
+ * converted to a sparse model and built by smlt_topology_create_sparse().
  */
 errval_t smlt_topology_create(struct smlt_generated_model* model,
                               const char *name,
                               struct smlt_topology **ret_topology)
 {
+    errval_t err;
+    struct smlt_sparse_model *sparse;
 
     if (model == NULL) {
-
-        *ret_topology = (struct smlt_topology*)
-                        smlt_platform_alloc(sizeof(struct smlt_topology)+
-                                            sizeof(struct smlt_topology_node)*
-                                            smlt_get_num_proc(),
-                                            SMLT_DEFAULT_ALIGNMENT, true);
-        smlt_topology_create_binary_tree(ret_topology, smlt_get_num_proc());
-        (*ret_topology)->num_nodes = smlt_get_num_proc();
+        err = smlt_topology_binary_tree(smlt_get_num_proc(), &sparse);
     } else {
-        *ret_topology = (struct smlt_topology*)
-                        smlt_platform_alloc(sizeof(struct smlt_topology)+
-                                            sizeof(struct smlt_topology_node)*
-                                            model->len,
-                                            SMLT_DEFAULT_ALIGNMENT, true);
-        smlt_topology_parse_model(model, ret_topology);
-        (*ret_topology)->num_nodes = model->len;
+        err = smlt_sparse_model_from_model(model, &sparse);
+    }
+    if (smlt_err_is_fail(err)) {
+        return err;
     }
 
-    (*ret_topology)->name = name;
+    err = smlt_topology_create_sparse(sparse, name, ret_topology);
+    smlt_platform_free(sparse);
+
+    return err;
+}
+
+/**
+ * @brief creates a new Smelt topology out of a sparse model
+ *
+ * @param model         the sparse model
+ * @param name          name of the topology
+ * @param ret_topology  returned pointer to the topology
+ *
+ * @return SMELT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ */
+errval_t smlt_topology_create_sparse(struct smlt_sparse_model* model,
+                                     const char *name,
+                                     struct smlt_topology **ret_topology)
+{
+    if (model == NULL || model->len == 0) {
+        return SMLT_ERR_INVAL;
+    }
+
+    struct smlt_topology *topo = (struct smlt_topology*)
+                    smlt_platform_alloc(sizeof(struct smlt_topology)+
+                                        sizeof(struct smlt_topology_node)*
+                                        model->len,
+                                        SMLT_DEFAULT_ALIGNMENT, true);
+    if (topo == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
+
+    errval_t err = smlt_topology_build_sparse(model, &topo);
+    if (smlt_err_is_fail(err)) {
+        smlt_platform_free(topo);
+        return err;
+    }
+
+    topo->num_nodes = model->len;
+    topo->name = name;
+    *ret_topology = topo;
+
     return SMLT_SUCCESS;
 }
 
@@ -109,6 +144,10 @@ errval_t smlt_topology_create(struct smlt_generated_model* model,
  */
 errval_t smlt_topology_destroy(struct smlt_topology *topology)
 {
+    /* the children arrays of all nodes start with the ones of the first */
+    smlt_platform_free(topology->all_nodes[0].children);
+    smlt_platform_free(topology);
+
     return SMLT_SUCCESS;
 }
 
@@ -127,200 +166,165 @@ smlt_nid_t smlt_topology_get_root_id(struct smlt_topology* topology)
 /**
  * \brief Build a binary tree model for the current machine.
  *
- * @param topology      returned pointer to the topology
  * @param num_threads   number of threads/processes in the model
- * @param name          name of the topology
+ * @param sparse        returned pointer to the sparse model
  *
- * @return SMELT_SUCCESS or error value
+ * @return SMELT_SUCCESS or SMLT_ERR_MALLOC_FAIL
  */
-static void smlt_topology_create_binary_tree(struct smlt_topology **topology,
-                                             uint32_t num_threads)
+static errval_t smlt_topology_binary_tree(uint32_t num_threads,
+                                          struct smlt_sparse_model **sparse)
 {
-    assert (topology!=NULL);
-    // Fill model
-    (*topology)->root = &((*topology)->all_nodes[0]);
-
-    for (unsigned int i = 0; i < num_threads;i++) {
-
-        struct smlt_topology_node* node = &(*topology)->all_nodes[i];
-        node->topology = *topology;
-        node->use_shm = false;
-        if (i == 0) {
-            node->parent = NULL;
-            node->node_id = 0;
-        } else {
-            if ((i % 2) == 0) {
-                node->parent = &((*topology)->all_nodes[(i/2)-1]);
-                node->array_index = 1;
-            } else {
-                node->parent = &((*topology)->all_nodes[(i/2)]);
-                node->array_index = 0;
-            }
-        }
+    *sparse = smlt_sparse_model_alloc(num_threads);
+    if (*sparse == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
-        if (i*2+1 < num_threads) {
-            node->children = (struct smlt_topology_node**)
-                             smlt_platform_alloc(sizeof(struct smlt_topology_node*)*2,
-                                                 SMLT_DEFAULT_ALIGNMENT, true);
-            node->children[0] = &(*topology)->all_nodes[i*2+1];
-            node->node_id = i;
-            node->num_children = 1;
-            if (i*2+2 < num_threads) {
-                node->children[1] = &(*topology)->all_nodes[i*2+2];
-                node->num_children = 2;
-            }
-            // TODO set chanel type;
-        } else {
-            node->children = NULL;
-            node->num_children = 0;
-            node->node_id = i;
-            node->is_leaf = true;
+    (*sparse)->ncores = num_threads;
+    (*sparse)->root = 0;
+
+    // node i sends to 2i+1 and 2i+2
+    for (uint32_t i = 0; i < num_threads; i++) {
+        if (i > 0) {
+            (*sparse)->nodes[i].parent = (i - 1) / 2;
+            (*sparse)->nodes[i].edge = (i - 1) % 2 + 1;
+        }
+        if (i * 2 + 1 >= num_threads) {
+            (*sparse)->nodes[i].flags = SMLT_SPARSE_MODEL_LEAF;
         }
     }
-    for (unsigned int i = 0; i < num_threads; i++) {
-        SMLT_DEBUG(SMLT_DBG__INIT, "Parent of node %d %p \n",
-        i, (*topology)->all_nodes[i].parent);
-    }
+
+    return SMLT_SUCCESS;
 }
 
 /**
- * \brief build topology from model.
+ * \brief build topology from a sparse model.
  *
+ * @param sparse        the sparse model
  * @param topology      returned pointer to the topology
  *
- * @return SMELT_SUCCESS or error value
+ * @return SMELT_SUCCESS, SMLT_ERR_INVAL or SMLT_ERR_MALLOC_FAIL
+ *
+ * Every node is visited a constant number of times, the children arrays of
+ * all nodes are carved out of a single allocation. The model leafs are the
+ * nodes flagged with SMLT_SPARSE_MODEL_LEAF, except for the root.
  */
-static void smlt_topology_parse_model(struct smlt_generated_model* model,
-                                      struct smlt_topology** topo)
+static errval_t smlt_topology_build_sparse(struct smlt_sparse_model *sparse,
+                                           struct smlt_topology **topo)
 {
+    struct smlt_topology_node *nodes = (*topo)->all_nodes;
+    uint32_t len = sparse->len;
 
-    assert (topo!=NULL);
-    // Fill model
-    (*topo)->root = &((*topo)->all_nodes[model->root]);
-    (*topo)->root->parent = NULL;
-    // TODO use node ids instead of cores ids
-    for (unsigned int x = 0; x < model->len;x++){
-        struct smlt_topology_node* node = &((*topo)->all_nodes[x]);
-
-        // find number of children (for MP) and allocate accordingly
-        int max_child = 0;
-        for(unsigned int y = 0; y < model->len; y++){
-            int tmp = model->model[x*model->len+y];
-            if ((tmp > max_child) && (tmp <= TOPO_MATRIX_MAX_MP)){
-                max_child = model->model[x*model->len+y];
-            }
-        }
+    /* walks over a cyclic topology would never terminate */
+    errval_t err = smlt_sparse_model_check(sparse);
+    if (smlt_err_is_fail(err)) {
+        return err;
+    }
 
+    for (uint32_t i = 0; i < len; i++) {
+        nodes[i].topology = *topo;
+        nodes[i].node_id = i;
+    }
 
-        node->node_id = x;
-        node->children = (struct smlt_topology_node**)
-                             smlt_platform_alloc(sizeof(struct smlt_topology_node*)*
-                                                 max_child, SMLT_DEFAULT_ALIGNMENT,
-                                                 true);
-        assert (node->children!=NULL);
-        node->num_children = max_child;
-
-        // find number of children (for SHM) and allocate accordingly
-        int shm_children = 0;
-        for (unsigned z = 0; z < model->len; z++) {
-            int val = model->model[x*(model->len)+z];
-            if ((val <= TOPO_MATRIX_SHM_SLAVE_MAX) && \
-                           (val >= TOPO_MATRIX_SHM_SLAVE_START)) {
-                shm_children++;
-            }
+    // count the children, the message passing ones by their position
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        struct smlt_sparse_model_node *sn = &sparse->nodes[i];
+        if (sn->parent == SMLT_SPARSE_MODEL_NO_PARENT) {
+            continue;
+        }
+        if (sn->parent >= len || i == sparse->root) {
+            return SMLT_ERR_INVAL;
         }
 
-        node->children_shm = (struct smlt_topology_node**)
-                             smlt_platform_alloc(sizeof(struct smlt_topology_node*)*
-                                                 shm_children, SMLT_DEFAULT_ALIGNMENT,
-                                                 true);
-        assert (node->children_shm!=NULL);
-        node->num_children_shm = shm_children;
-
-        // set model
-        for(unsigned int y = 0; y < model->len; y++){
-            int val = model->model[x*(model->len)+y];
-            if (val > 0) {
-
-                if (val == TOPO_MATRIX_PARENT) {
-
-                    // message passing (parent)
-                    // --------------------------------------------------
-
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Parent of %d is %d \n", x, y);
-                    node->parent = &((*topo)->all_nodes[y]);
-
-                    // Check symetry
-                    int val = model->model[y*(model->len)+x];
-                    assert (val>0 && // there should be a connection
-                            val <+ TOPO_MATRIX_MAX_MP); // .. and it should be message-passing one
-
-                } else if (val <= TOPO_MATRIX_MAX_MP) {
-
-                    // message passing (child)
-                    // --------------------------------------------------
-
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Child of %d is %d at pos %d \n",
-                               x, y, val-1);
-                    node->topology = *topo;
-                    node->children[val-1] = &((*topo)->all_nodes[y]);
-                    node->node_id = x; // TODO change to real node ID
-                    (*topo)->all_nodes[y].array_index = val-1;
-
-                } else if ((val >= TOPO_MATRIX_SHM_MASTER_START) &&
-                           (val <= TOPO_MATRIX_SHM_MASTER_MAX)) {
-
-                    // shared memory regions (masters)
-                    // --------------------------------------------------
-
-                    assert (!"NYI Hybrid models");
-                    // master of shared memory channel
-                    /* node->use_shm = true; */
-                    /* SMLT_DEBUG(SMLT_DBG__GENERAL,"Child (SHM) of %d is %d at pos %d \n", */
-                    /*            x, y, shm_child_index); */
-                    /* node->topology = *topo; */
-                    /* node->children_shm[shm_child_index] = &((*topo)->all_nodes[y]); */
-                    /* node->node_id = x; // TODO change to real node ID */
-                    /* (*topo)->all_nodes[y].array_index_shm = shm_child_index; */
-                    /* shm_child_index++; */
-                } else if ((val <= TOPO_MATRIX_SHM_SLAVE_MAX) && \
-                           (val >= TOPO_MATRIX_SHM_SLAVE_START)) {
+        struct smlt_topology_node *p = &nodes[sn->parent];
+        if (sn->edge >= 1 && sn->edge <= TOPO_MATRIX_MAX_MP) {
+            if (sn->edge > p->num_children) {
+                total += sn->edge - p->num_children;
+                p->num_children = sn->edge;
+            }
+        } else if (sn->edge >= TOPO_MATRIX_SHM_MASTER_START &&
+                   sn->edge <= TOPO_MATRIX_SHM_MASTER_MAX) {
+            p->use_shm = true;
+            p->num_children_shm++;
+            total++;
+        } else {
+            return SMLT_ERR_INVAL;
+        }
+    }
 
-                    // shared memory regions (slave)
-                    // --------------------------------------------------
+    struct smlt_topology_node **base = (struct smlt_topology_node **)
+        smlt_platform_alloc((total + 1) * sizeof(struct smlt_topology_node *),
+                            SMLT_DEFAULT_ALIGNMENT, true);
+    if (base == NULL) {
+        return SMLT_ERR_MALLOC_FAIL;
+    }
 
-                    SMLT_DEBUG(SMLT_DBG__INIT,"Parent (SHM) of %d is %d \n",
-                               x,y);
-                    node->parent = &((*topo)->all_nodes[y]);
+    struct smlt_topology_node **pool = base;
 
-                } else  {
+    for (uint32_t i = 0; i < len; i++) {
+        nodes[i].children = pool;
+        pool += nodes[i].num_children;
+        nodes[i].children_shm = pool;
+        pool += nodes[i].num_children_shm;
 
-                    panic("Encountered unexpected integer value in "
-                          "topology matrix - cannot parse");
+        // counted up again while filling in the children
+        nodes[i].num_children_shm = 0;
+    }
 
-                }
+    // the shared memory children are ordered by their node id
+    for (uint32_t i = 0; i < len; i++) {
+        struct smlt_sparse_model_node *sn = &sparse->nodes[i];
+        if (sn->parent == SMLT_SPARSE_MODEL_NO_PARENT) {
+            continue;
+        }
 
-            } else if (val==0) {
-                // Nothing to do here, no connection
-            }
-            else {
-                panic("Encountered unexpected integer value in "
-                      "topology matrix - cannot parse");
+        struct smlt_topology_node *p = &nodes[sn->parent];
+        nodes[i].parent = p;
 
+        if (sn->edge <= TOPO_MATRIX_MAX_MP) {
+            SMLT_DEBUG(SMLT_DBG__INIT,"Child of %d is %d at pos %d \n",
+                       sn->parent, i, sn->edge - 1);
+            if (p->children[sn->edge - 1] != NULL) {
+                err = SMLT_ERR_INVAL;
+                goto err_free;
             }
+            p->children[sn->edge - 1] = &nodes[i];
+            nodes[i].array_index = sn->edge - 1;
+        } else {
+            SMLT_DEBUG(SMLT_DBG__INIT,"Child (SHM) of %d is %d at pos %d \n",
+                       sn->parent, i, p->num_children_shm);
+            p->children_shm[p->num_children_shm] = &nodes[i];
+            nodes[i].array_index_shm = p->num_children_shm;
+            p->num_children_shm++;
+        }
+    }
 
+    // every message passing position up to the last one is taken
+    for (uint32_t i = 0; i < total; i++) {
+        if (base[i] == NULL) {
+            err = SMLT_ERR_INVAL;
+            goto err_free;
         }
-        node->num_children = max_child;
     }
-    for (unsigned i = 0; i < model->len; i++) {
-        for (unsigned j = 0; j < model->num_leafs; j++) {
-            if ((model->leafs[j] == i) && (i != 0)) {
-                SMLT_DEBUG(SMLT_DBG__INIT,"%d is a leaf \n", i)
-                (*topo)->all_nodes[i].is_leaf = true;
-            }
+
+    for (uint32_t i = 0; i < len; i++) {
+        if ((sparse->nodes[i].flags & SMLT_SPARSE_MODEL_LEAF) &&
+            i != sparse->root) {
+            SMLT_DEBUG(SMLT_DBG__INIT,"%d is a leaf \n", i)
+            nodes[i].is_leaf = true;
         }
     }
+
+    (*topo)->root = &nodes[sparse->root];
+    (*topo)->root->parent = NULL;
+
+    return SMLT_SUCCESS;
+
+    err_free:
+    smlt_platform_free(base);
+    return err;
 }
+
 /*
  * ===========================================================================
  * topology nodes
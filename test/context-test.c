@@ -13,17 +13,28 @@
 #include <smlt.h>
 #include <smlt_broadcast.h>
 #include <smlt_reduction.h>
+#include <smlt_barrier.h>
+#include <smlt_allreduce.h>
+#include <smlt_gather.h>
+#include <smlt_scatter.h>
+#include <smlt_scan.h>
+#include <smlt_alltoall.h>
+#include <smlt_request.h>
 #include <smlt_topology.h>
 #include <smlt_context.h>
 #include <smlt_generator.h>
 #include <pthread.h>
 
 #define NUM_RUNS 10000000
+#define NUM_RUNS_VEC 10000
+#define VEC_WORDS 1024
 
 struct smlt_context *context = NULL;
+static size_t num_threads;
 
 static const char *name = "binary_tree";
 static pthread_barrier_t bar;
+static volatile uint64_t *arrived;
 
 
 errval_t operation(struct smlt_msg* m1, struct smlt_msg* m2)
@@ -66,13 +77,225 @@ void* thr_worker(void* arg)
     }
     printf("%ld :Reduction 0 Payload Finished \n", (uint64_t) arg);
     pthread_barrier_wait(&bar);
+    struct smlt_msg* vec = smlt_message_alloc(VEC_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+    uint64_t n = num_threads;
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        for (uint64_t w = 0; w < VEC_WORDS; w++) {
+            vec->data[w] = id + w + i;
+        }
+        smlt_reduce_pipelined(context, vec, vec, SMLT_REDUCE_OP_SUM,
+                              SMLT_REDUCE_DTYPE_U64);
+        if (!smlt_context_is_root(context)) {
+            continue;
+        }
+        for (uint64_t w = 0; w < VEC_WORDS; w++) {
+            if (vec->data[w] != n * (n - 1) / 2 + n * (w + i)) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       vec->data[w], n * (n - 1) / 2 + n * (w + i));
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Pipelined Reduction Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        if (smlt_context_is_root(context)) {
+            for (uint64_t w = 0; w < VEC_WORDS; w++) {
+                vec->data[w] = w + i;
+            }
+        }
+        smlt_broadcast_pipelined(context, vec);
+        for (uint64_t w = 0; w < VEC_WORDS; w++) {
+            if (vec->data[w] != w + i) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       vec->data[w], w + i);
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Pipelined Broadcast Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    smlt_allreduce_algo_t algos[] = {
+        SMLT_ALLREDUCE_TREE,
+        SMLT_ALLREDUCE_RECURSIVE_DOUBLING,
+        SMLT_ALLREDUCE_HYBRID,
+        SMLT_ALLREDUCE_AUTO
+    };
+    for (int a = 0; a < 4; a++) {
+        for(int i = 0; i < NUM_RUNS_VEC; i++) {
+            /* alternate between single slot and pipelined messages */
+            uint32_t words = (i % 2) ? 1 + i % 7 : VEC_WORDS;
+            for (uint64_t w = 0; w < words; w++) {
+                vec->data[w] = id + w + i;
+            }
+            vec->words = words;
+            smlt_allreduce_with_algo(context, vec, vec, SMLT_REDUCE_OP_SUM,
+                                     SMLT_REDUCE_DTYPE_U64, algos[a]);
+            for (uint64_t w = 0; w < words; w++) {
+                if (vec->data[w] != n * (n - 1) / 2 + n * (w + i)) {
+                    printf("Node %ld: Test failed %ld should be %ld \n", id,
+                           vec->data[w], n * (n - 1) / 2 + n * (w + i));
+                    exit(1);
+                }
+            }
+        }
+    }
+    printf("%ld :Allreduce Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    struct smlt_msg* block = smlt_message_alloc(3 * sizeof(smlt_msg_payload_t));
+    struct smlt_msg* all = smlt_message_alloc(n * 3 * sizeof(smlt_msg_payload_t));
+    uint64_t rank = smlt_context_get_rank(context);
+    block->words = 3;
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        for (uint64_t w = 0; w < 3; w++) {
+            block->data[w] = (rank << 32) | (w + i);
+        }
+        smlt_allgather(context, block, all);
+        for (uint64_t r = 0; r < n; r++) {
+            for (uint64_t w = 0; w < 3; w++) {
+                if (all->data[r * 3 + w] != ((r << 32) | (w + i))) {
+                    printf("Node %ld: Test failed %lx should be %lx \n", id,
+                           all->data[r * 3 + w], (r << 32) | (w + i));
+                    exit(1);
+                }
+            }
+        }
+    }
+    printf("%ld :Allgather Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        if (smlt_context_is_root(context)) {
+            for (uint64_t w = 0; w < n * 3; w++) {
+                all->data[w] = ((w / 3) << 32) | (w % 3 + i);
+            }
+        }
+        smlt_scatter(context, all, 3, block);
+        for (uint64_t w = 0; w < 3; w++) {
+            if (block->data[w] != ((rank << 32) | (w + i))) {
+                printf("Node %ld: Test failed %lx should be %lx \n", id,
+                       block->data[w], (rank << 32) | (w + i));
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Scatter Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    struct smlt_msg* prefix = smlt_message_alloc(3 * sizeof(smlt_msg_payload_t));
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        for (uint64_t w = 0; w < 3; w++) {
+            block->data[w] = rank + 1 + w + i;
+        }
+        smlt_scan(context, block, prefix, SMLT_REDUCE_OP_SUM,
+                  SMLT_REDUCE_DTYPE_U64);
+        for (uint64_t w = 0; w < 3; w++) {
+            uint64_t expected = (rank + 1) * (rank + 2) / 2 + (rank + 1) * (w + i);
+            if (prefix->data[w] != expected) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       prefix->data[w], expected);
+                exit(1);
+            }
+        }
+        smlt_exscan(context, block, prefix, SMLT_REDUCE_OP_SUM,
+                    SMLT_REDUCE_DTYPE_U64);
+        for (uint64_t w = 0; w < 3; w++) {
+            uint64_t expected = rank * (rank + 1) / 2 + rank * (w + i);
+            if (prefix->data[w] != expected) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       prefix->data[w], expected);
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Scan Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    struct smlt_msg* recvd = smlt_message_alloc(n * 3 * sizeof(smlt_msg_payload_t));
+    smlt_alltoall_algo_t a2a_algos[] = {
+        SMLT_ALLTOALL_DIRECT,
+        SMLT_ALLTOALL_PAIRWISE,
+        SMLT_ALLTOALL_TWO_PHASE,
+        SMLT_ALLTOALL_AUTO
+    };
+    for (int a = 0; a < 4; a++) {
+        for(int i = 0; i < NUM_RUNS_VEC; i++) {
+            for (uint64_t w = 0; w < n * 3; w++) {
+                all->data[w] = (rank << 48) | ((w / 3) << 32) | (w % 3 + i);
+            }
+            all->words = n * 3;
+            smlt_alltoall_with_algo(context, all, 3, recvd, a2a_algos[a]);
+            for (uint64_t w = 0; w < n * 3; w++) {
+                uint64_t expected = ((w / 3) << 48) | (rank << 32) | (w % 3 + i);
+                if (recvd->data[w] != expected) {
+                    printf("Node %ld: Test failed %lx should be %lx \n", id,
+                           recvd->data[w], expected);
+                    exit(1);
+                }
+            }
+        }
+    }
+    printf("%ld :Alltoall Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        struct smlt_request *req_bar, *req_red, *req_bc;
+        for (uint64_t w = 0; w < 3; w++) {
+            block->data[w] = id + w + i;
+            if (smlt_context_is_root(context)) {
+                prefix->data[w] = w + i;
+            }
+        }
+        prefix->words = 3;
+        smlt_ibarrier(context, &req_bar);
+        smlt_ireduce(context, block, recvd, SMLT_REDUCE_OP_SUM,
+                     SMLT_REDUCE_DTYPE_U64, &req_red);
+        smlt_ibroadcast(context, prefix, &req_bc);
+        bool done = false;
+        while (!done) {
+            smlt_test(req_bc, &done);
+        }
+        if (smlt_err_is_fail(smlt_wait(req_red)) ||
+            smlt_err_is_fail(smlt_wait(req_bar))) {
+            printf("Node %ld: Test failed, request error \n", id);
+            exit(1);
+        }
+        for (uint64_t w = 0; w < 3; w++) {
+            if (prefix->data[w] != w + i) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       prefix->data[w], w + i);
+                exit(1);
+            }
+            if (smlt_context_is_root(context) &&
+                recvd->data[w] != n * (n - 1) / 2 + n * (w + i)) {
+                printf("Node %ld: Test failed %ld should be %ld \n", id,
+                       recvd->data[w], n * (n - 1) / 2 + n * (w + i));
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Non-blocking Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
+    for(int i = 0; i < NUM_RUNS_VEC; i++) {
+        arrived[rank] = i + 1;
+        smlt_barrier_arrive(context);
+        smlt_progress();
+        smlt_barrier_depart(context);
+        for (uint64_t r = 0; r < n; r++) {
+            if (arrived[r] < (uint64_t) i + 1) {
+                printf("Node %ld: Test failed, node %ld did not arrive \n",
+                       id, r);
+                exit(1);
+            }
+        }
+    }
+    printf("%ld :Split barrier Finished \n", (uint64_t) arg);
+    pthread_barrier_wait(&bar);
     return 0;
 }
 
 int main(int argc, char **argv)
 {
-    size_t num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = sysconf(_SC_NPROCESSORS_ONLN);
     pthread_barrier_init(&bar, NULL, num_threads);
+    arrived = calloc(num_threads, sizeof(uint64_t));
     errval_t err;
     err = smlt_init(num_threads, true);
     if (smlt_err_is_fail(err)) {
@@ -27,10 +27,14 @@ static const char *name = "binary_tree";
 static pthread_barrier_t bar;
 
 
-static uint16_t model[16] = { 0, 70, 70, 1,
-                              50, 0, 0, 0,
-                              50, 0, 0, 0,
-                              99, 0, 0, 0 };
+#define MA TOPO_MATRIX_SHM_MASTER_START
+#define SL TOPO_MATRIX_SHM_SLAVE_START
+#define PA TOPO_MATRIX_PARENT
+
+static uint16_t model[16] = {  0, MA, MA,  1,
+                              SL,  0,  0,  0,
+                              SL,  0,  0,  0,
+                              PA,  0,  0,  0 };
 
 static uint32_t leafs[4] = {1,2,3,0};
 
@@ -115,6 +119,7 @@ int main(int argc, char **argv)
     m = (struct smlt_generated_model*) malloc(sizeof(struct smlt_generated_model));
     m->model = model;
     m->leafs = leafs;
+    m->num_leafs = 3;
     m->root = 0;
     m->ncores = 4;
     m->len = 4;
@@ -139,5 +144,38 @@ int main(int argc, char **argv)
         smlt_node_join(node);
     }
 
+    printf("Creating generated hybrid tree \n");
+
+    coreid_t cores[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++) {
+        cores[i] = i;
+    }
+
+    err = smlt_generate_hybrid_model(cores, NUM_THREADS, &m);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO GENERATE MODEL !\n");
+        return 1;
+    }
+    smlt_topology_create(m, name, &topo);
+
+    err = smlt_context_create(topo, &context);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO INITIALIZE CONTEXT !\n");
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < NUM_THREADS; i++) {
+        node = smlt_get_node_by_id(i);
+        err = smlt_node_start(node, thr_worker, (void*) i);
+        if (smlt_err_is_fail(err)) {
+            printf("Staring node failed \n");
+        }
+    }
+
+    for (int i=0; i < NUM_THREADS; i++) {
+        node = smlt_get_node_by_id(i);
+        smlt_node_join(node);
+    }
+
     return 0;
 }
@@ -26,6 +26,8 @@
 #define NUM_RUNS 10000000             // << default number of runs
 static uint64_t num_runs = NUM_RUNS;  // << can be configured via param #2
 
+#define NUM_BATCH 100                 // << larger than the queues
+
 volatile uint8_t signal = 0;
 
 void* thr_worker1(void* arg)
@@ -42,9 +44,18 @@ void* thr_worker1(void* arg)
 
     int num_wrong = 0;
     for (uint64_t i = 0; i < num_runs; i++) {
-        msg->data[0] = i;
-        msg->words = 1;
-        smlt_queuepair_send(qp, msg);
+        // every other message is written directly into the queue
+        if (i & 1) {
+            smlt_msg_payload_t *data;
+            uint32_t words;
+            smlt_queuepair_send_prepare(qp, &data, &words);
+            data[0] = i;
+            smlt_queuepair_send_commit(qp);
+        } else {
+            msg->data[0] = i;
+            msg->words = 1;
+            smlt_queuepair_send(qp, msg);
+        }
         signal = 1;
         msg->words = 1;
         smlt_queuepair_recv(qp, msg);
@@ -59,6 +70,15 @@ void* thr_worker1(void* arg)
         //smlt_queuepair_recv0(qp); // TODO does not work for UMP
     }
 
+    // Test batched send
+    struct smlt_msg *batch[NUM_BATCH];
+    for (uint64_t i = 0; i < NUM_BATCH; i++) {
+        batch[i] = smlt_message_alloc(7);
+        batch[i]->data[0] = i;
+        batch[i]->words = 1;
+    }
+    smlt_queuepair_send_batch(qp, batch, NUM_BATCH);
+
     if (!num_wrong) {
        printf("Core 0 Test Success \n");
     } else {
@@ -81,9 +101,17 @@ void* thr_worker2(void* arg)
 
     int num_wrong = 0;
     for (uint64_t i = 0; i < num_runs; i++) {
-        msg->words = 1;
-        // test send/receive
-        smlt_queuepair_recv(qp, msg);
+        // test send/receive, every other message is borrowed from the queue
+        if (i & 1) {
+            const smlt_msg_payload_t *data;
+            uint32_t words;
+            smlt_queuepair_recv_borrow(qp, &data, &words);
+            msg->data[0] = data[0];
+            smlt_queuepair_recv_release(qp);
+        } else {
+            msg->words = 1;
+            smlt_queuepair_recv(qp, msg);
+        }
         if (msg->data[0] != i) {
             printf("wrong: %lu / %lu\n", msg->data[0], i);
            num_wrong++;
@@ -98,6 +126,26 @@ void* thr_worker2(void* arg)
         //smlt_queuepair_recv0(qp); // TODO does not work for UMP
     }
 
+    // Test batched send and receive
+    struct smlt_msg *batch[NUM_BATCH];
+    for (uint64_t i = 0; i < NUM_BATCH; i++) {
+        batch[i] = smlt_message_alloc(7);
+        batch[i]->words = 1;
+    }
+    uint32_t received = 0;
+    while (received < NUM_BATCH) {
+        uint32_t got;
+        smlt_queuepair_recv_batch(qp, batch + received,
+                                  NUM_BATCH - received, &got);
+        received += got;
+    }
+    for (uint64_t i = 0; i < NUM_BATCH; i++) {
+        if (batch[i]->data[0] != i) {
+            printf("wrong batch: %lu / %lu\n", batch[i]->data[0], i);
+            num_wrong++;
+        }
+    }
+
     if (!num_wrong) {
        printf("Core 1 Test Success \n");
     } else {
@@ -0,0 +1,246 @@
+/**
+ * \brief Testing the builtin reduction operations
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <smlt.h>
+#include <smlt_message.h>
+#include <smlt_reduction.h>
+
+#define MAX_WORDS 1029
+
+static uint32_t msg_words[] = { 1, 2, 7, 8, 9, 31, 64, 257, MAX_WORDS };
+
+#define NUM_SIZES (sizeof(msg_words) / sizeof(msg_words[0]))
+
+static const char *op_names[SMLT_REDUCE_OP_NUM] = {
+    "sum", "min", "max", "band", "bor", "bxor"
+};
+
+static const char *dtype_names[SMLT_REDUCE_DTYPE_NUM] = {
+    "u32", "u64", "i64", "f32", "f64"
+};
+
+#define REF_ARITH(_type, _op, _a, _b)                       \
+    switch (_op) {                                          \
+        case SMLT_REDUCE_OP_SUM: return (_type)(_a + _b);   \
+        case SMLT_REDUCE_OP_MIN: return _b < _a ? _b : _a;  \
+        case SMLT_REDUCE_OP_MAX: return _b > _a ? _b : _a;  \
+        default: break;                                     \
+    }
+
+#define REF_BITWISE(_op, _a, _b)                            \
+    switch (_op) {                                          \
+        case SMLT_REDUCE_OP_BAND: return _a & _b;           \
+        case SMLT_REDUCE_OP_BOR: return _a | _b;            \
+        case SMLT_REDUCE_OP_BXOR: return _a ^ _b;           \
+        default: break;                                     \
+    }
+
+static uint32_t ref_u32(smlt_reduce_op_t op, uint32_t a, uint32_t b)
+{
+    REF_ARITH(uint32_t, op, a, b)
+    REF_BITWISE(op, a, b)
+    return 0;
+}
+
+static uint64_t ref_u64(smlt_reduce_op_t op, uint64_t a, uint64_t b)
+{
+    REF_ARITH(uint64_t, op, a, b)
+    REF_BITWISE(op, a, b)
+    return 0;
+}
+
+static int64_t ref_i64(smlt_reduce_op_t op, int64_t a, int64_t b)
+{
+    /* the sum wraps around, compute it unsigned */
+    if (op == SMLT_REDUCE_OP_SUM) {
+        return (int64_t)((uint64_t) a + (uint64_t) b);
+    }
+    REF_ARITH(int64_t, op, a, b)
+    REF_BITWISE(op, a, b)
+    return 0;
+}
+
+static float ref_f32(smlt_reduce_op_t op, float a, float b)
+{
+    REF_ARITH(float, op, a, b)
+    return 0;
+}
+
+static double ref_f64(smlt_reduce_op_t op, double a, double b)
+{
+    REF_ARITH(double, op, a, b)
+    return 0;
+}
+
+static void fill(struct smlt_msg *msg, smlt_reduce_dtype_t dtype,
+                 uint32_t words)
+{
+    msg->words = words;
+    for (uint32_t w = 0; w < words; w++) {
+        msg->data[w] = ((uint64_t) rand() << 32) | (uint64_t) rand();
+    }
+
+    /* keep the floats finite, the comparisons are exact */
+    if (dtype == SMLT_REDUCE_DTYPE_F32) {
+        float *f = (float *) msg->data;
+        for (uint32_t i = 0; i < words * 2; i++) {
+            f[i] = (float)(rand() % 2000 - 1000) / 8;
+        }
+    } else if (dtype == SMLT_REDUCE_DTYPE_F64) {
+        double *f = (double *) msg->data;
+        for (uint32_t i = 0; i < words; i++) {
+            f[i] = (double)(rand() % 2000 - 1000) / 8;
+        }
+    }
+}
+
+static int check(smlt_reduce_op_t op, smlt_reduce_dtype_t dtype,
+                 struct smlt_msg *a, struct smlt_msg *b,
+                 struct smlt_msg *res)
+{
+    uint32_t words = a->words;
+
+    for (uint32_t i = 0; i < words * 2; i++) {
+        if (dtype == SMLT_REDUCE_DTYPE_U32) {
+            uint32_t *x = (uint32_t *) a->data, *y = (uint32_t *) b->data;
+            if (((uint32_t *) res->data)[i] != ref_u32(op, x[i], y[i])) {
+                return 1;
+            }
+        } else if (dtype == SMLT_REDUCE_DTYPE_F32) {
+            float *x = (float *) a->data, *y = (float *) b->data;
+            if (((float *) res->data)[i] != ref_f32(op, x[i], y[i])) {
+                return 1;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < words; i++) {
+        if (dtype == SMLT_REDUCE_DTYPE_U64) {
+            if (res->data[i] != ref_u64(op, a->data[i], b->data[i])) {
+                return 1;
+            }
+        } else if (dtype == SMLT_REDUCE_DTYPE_I64) {
+            int64_t *x = (int64_t *) a->data, *y = (int64_t *) b->data;
+            if (((int64_t *) res->data)[i] != ref_i64(op, x[i], y[i])) {
+                return 1;
+            }
+        } else if (dtype == SMLT_REDUCE_DTYPE_F64) {
+            double *x = (double *) a->data, *y = (double *) b->data;
+            if (((double *) res->data)[i] != ref_f64(op, x[i], y[i])) {
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t bytes = MAX_WORDS * sizeof(smlt_msg_payload_t);
+    struct smlt_msg *a = smlt_message_alloc(bytes);
+    struct smlt_msg *b = smlt_message_alloc(bytes);
+    struct smlt_msg *res = smlt_message_alloc(bytes);
+
+    int num_wrong = 0;
+
+    srand(42);
+
+    for (int op = 0; op < SMLT_REDUCE_OP_NUM; op++) {
+        for (int dtype = 0; dtype < SMLT_REDUCE_DTYPE_NUM; dtype++) {
+            bool bitwise = (op == SMLT_REDUCE_OP_BAND ||
+                            op == SMLT_REDUCE_OP_BOR ||
+                            op == SMLT_REDUCE_OP_BXOR);
+            bool is_float = (dtype == SMLT_REDUCE_DTYPE_F32 ||
+                             dtype == SMLT_REDUCE_DTYPE_F64);
+
+            if (bitwise && is_float) {
+                /* bitwise operations are not defined on floats */
+                if (smlt_reduce_op_is_valid(op, dtype) ||
+                    smlt_reduce_op_apply(op, dtype, a, b) != SMLT_ERR_INVAL) {
+                    printf("%s/%s: accepted invalid operation\n",
+                           op_names[op], dtype_names[dtype]);
+                    num_wrong++;
+                }
+                continue;
+            }
+
+            for (uint32_t s = 0; s < NUM_SIZES; s++) {
+                fill(a, dtype, msg_words[s]);
+                fill(b, dtype, msg_words[s]);
+
+                memcpy(res->data, a->data,
+                       msg_words[s] * sizeof(smlt_msg_payload_t));
+                res->words = msg_words[s];
+
+                errval_t err = smlt_reduce_op_apply(op, dtype, res, b);
+                if (smlt_err_is_fail(err) || check(op, dtype, a, b, res)) {
+                    printf("%s/%s: wrong result for %u words\n",
+                           op_names[op], dtype_names[dtype], msg_words[s]);
+                    num_wrong++;
+                }
+            }
+        }
+    }
+
+    /* the identity leaves the other operand unchanged */
+    for (int op = 0; op < SMLT_REDUCE_OP_NUM; op++) {
+        for (int dtype = 0; dtype < SMLT_REDUCE_DTYPE_NUM; dtype++) {
+            if (!smlt_reduce_op_is_valid(op, dtype)) {
+                continue;
+            }
+
+            fill(a, dtype, 64);
+            b->words = 64;
+            if (smlt_err_is_fail(smlt_reduce_op_identity(op, dtype, b))) {
+                num_wrong++;
+                continue;
+            }
+
+            memcpy(res->data, a->data, 64 * sizeof(smlt_msg_payload_t));
+            res->words = 64;
+            smlt_reduce_op_apply(op, dtype, res, b);
+            if (memcmp(res->data, a->data, 64 * sizeof(smlt_msg_payload_t))) {
+                printf("%s/%s: wrong identity\n", op_names[op],
+                       dtype_names[dtype]);
+                num_wrong++;
+            }
+        }
+    }
+
+    /* operands of different length */
+    a->words = 2;
+    b->words = 3;
+    if (smlt_reduce_op_apply(SMLT_REDUCE_OP_SUM, SMLT_REDUCE_DTYPE_U64,
+                             a, b) != SMLT_ERR_INVAL) {
+        printf("accepted operands of different length\n");
+        num_wrong++;
+    }
+
+    smlt_message_free(a);
+    smlt_message_free(b);
+    smlt_message_free(res);
+
+    if (num_wrong) {
+        printf("Test Failed \n");
+        return 1;
+    }
+
+    printf("Test Succeeded \n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+/**
+ * \brief Testing bulk messages on the shared memory queue
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <smlt.h>
+#include <smlt_message.h>
+#include <backends/shm/swmr.h>
+
+#define NUM_RUNS 100
+#define MAX_WORDS 2048  // 16 KiB payload, larger than the queue
+
+#define NUM_READERS 3
+
+static uint32_t cores[NUM_READERS + 1] = {0, 1, 2, 3};
+
+static uint32_t msg_words[] = { 1, 7, 8, 12, 13, 64, 200, 1000, MAX_WORDS };
+
+#define NUM_SIZES (sizeof(msg_words) / sizeof(msg_words[0]))
+
+static struct swmr_queue *queue;
+
+static void pin(int core)
+{
+    cpu_set_t cpu_mask;
+
+    CPU_ZERO(&cpu_mask);
+    CPU_SET(core, &cpu_mask);
+
+    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+}
+
+void* thr_writer(void* arg)
+{
+    pin(cores[0]);
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t s = 0; s < NUM_SIZES; s++) {
+            for (uint32_t w = 0; w < msg_words[s]; w++) {
+                msg->data[w] = (i << 32) | (s << 16) | w;
+            }
+            msg->words = msg_words[s];
+            smlt_swmr_send(queue, msg);
+        }
+    }
+
+    return 0;
+}
+
+void* thr_reader(void* arg)
+{
+    uint64_t id = (uint64_t) arg;
+
+    pin(cores[id + 1]);
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    int num_wrong = 0;
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t s = 0; s < NUM_SIZES; s++) {
+            msg->words = msg_words[s];
+            smlt_swmr_recv(&queue->dst[id], msg);
+            if (msg->words != msg_words[s]) {
+                printf("wrong length: %u / %u\n", msg->words, msg_words[s]);
+                num_wrong++;
+                continue;
+            }
+            for (uint32_t w = 0; w < msg_words[s]; w++) {
+                if (msg->data[w] != ((i << 32) | (s << 16) | w)) {
+                    printf("wrong: %" PRIu64 " at %u\n", msg->data[w], w);
+                    num_wrong++;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (num_wrong) {
+        printf("Reader %" PRIu64 ": Test Failed \n", id);
+    } else {
+        printf("Reader %" PRIu64 ": Test Succeeded \n", id);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t tids[NUM_READERS + 1];
+
+    queue = (struct swmr_queue*) malloc(sizeof(struct swmr_queue));
+    assert(queue != NULL);
+
+    swmr_queue_create(&queue, cores[0], &cores[1], NUM_READERS, false);
+
+    pthread_create(&tids[0], NULL, thr_writer, NULL);
+    for (uint64_t i = 0; i < NUM_READERS; i++) {
+        pthread_create(&tids[i + 1], NULL, thr_reader, (void*) i);
+    }
+
+    for (int i = 0; i < NUM_READERS + 1; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    return 0;
+}
@@ -9,10 +9,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <smlt.h>
 #include <smlt_topology.h>
 #include <smlt_generator.h>
+#include <smlt_model_cache.h>
+#include <smlt_sparse_model.h>
 
 #define NUM_THREADS 8
 
@@ -28,14 +31,18 @@ static uint32_t leafs[NUM_THREADS] = {3,4,5,6,7,0,0,0};
 static uint32_t cores[NUM_THREADS];
 
 
-static uint16_t model2[64] = { 0, 70, 70, 70, 1, 0, 0, 0,
-                             50, 0, 0, 1, 2, 0, 0, 0,
-                             50, 0, 0, 0, 0, 1, 2, 3,
-                             50, 0, 0, 0, 0, 0, 0, 0,
-                             99, 0, 0, 0, 0, 71, 71, 71,
-                              0, 0, 0, 0, 0, 51, 0, 0,
-                              0, 0, 0, 0, 0, 51, 0, 0,
-                              0, 0, 0, 0, 0, 51, 0, 0};
+#define MA TOPO_MATRIX_SHM_MASTER_START
+#define SL TOPO_MATRIX_SHM_SLAVE_START
+#define PA TOPO_MATRIX_PARENT
+
+static uint16_t model2[64] = {  0, MA, MA, MA,  1,  0,  0,  0,
+                               SL,  0,  0,  0,  0,  0,  0,  0,
+                               SL,  0,  0,  0,  0,  0,  0,  0,
+                               SL,  0,  0,  0,  0,  0,  0,  0,
+                               PA,  0,  0,  0,  0, MA+1, MA+1, MA+1,
+                                0,  0,  0,  0, SL+1, 0,  0,  0,
+                                0,  0,  0,  0, SL+1, 0,  0,  0,
+                                0,  0,  0,  0, SL+1, 0,  0,  0};
 
 
 static const char *name = "binary_tree";
@@ -57,6 +64,7 @@ int main(int argc, char **argv)
     m = (struct smlt_generated_model*) malloc(sizeof(struct smlt_generated_model));
     m->model = model;
     m->leafs = leafs;
+    m->num_leafs = 5;
     m->root = 0;
     m->ncores = NUM_THREADS;
     m->len = NUM_THREADS;
@@ -83,4 +91,218 @@ int main(int argc, char **argv)
 
     smlt_generate_model(cores, NUM_THREADS, name, &m2);
     smlt_topology_create(m2, name, &topo2);
+
+    const char *builtin[] = { "sequential", "bintree", "kary-3", "binomial",
+                              "cluster", "adaptivetree" };
+    for (unsigned i = 0; i < sizeof(builtin) / sizeof(builtin[0]); i++) {
+        smlt_generator_shape_t shape;
+        uint32_t fanout;
+        printf("Creating built-in %s \n", builtin[i]);
+        err = smlt_generator_shape_by_name(builtin[i], &shape, &fanout);
+        if (smlt_err_is_fail(err)) {
+            printf("FAILED TO FIND SHAPE %s !\n", builtin[i]);
+            return 1;
+        }
+
+        err = smlt_generate_tree_model(cores, smlt_get_num_proc(), shape,
+                                       fanout, &m2);
+        if (smlt_err_is_fail(err)) {
+            printf("FAILED TO GENERATE %s !\n", builtin[i]);
+            return 1;
+        }
+
+        // every core but the root has a parent
+        for (unsigned j = 1; j < m2->ncores; j++) {
+            int parents = 0;
+            for (unsigned k = 0; k < m2->len; k++) {
+                if (m2->model[j * m2->len + k] == TOPO_MATRIX_PARENT) {
+                    parents++;
+                }
+            }
+            if (parents != 1) {
+                printf("FAILED: core %u of %s has %d parents !\n", j,
+                       builtin[i], parents);
+                return 1;
+            }
+        }
+        smlt_topology_create(m2, builtin[i], &topo2);
+    }
+
+    printf("Creating sparse hybrid tree \n");
+    m->model = model2;
+    struct smlt_sparse_model *sparse = NULL;
+    err = smlt_sparse_model_from_model(m, &sparse);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CONVERT MODEL !\n");
+        return 1;
+    }
+
+    size_t size = smlt_sparse_model_size(sparse);
+    uint32_t *buf = malloc(size);
+    err = smlt_sparse_model_serialize(sparse, buf, size);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO SERIALIZE MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_sparse_model_deserialize(buf, size, &sparse);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO DESERIALIZE MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_topology_create_sparse(sparse, "hybrid", &topo2);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE SPARSE TOPOLOGY !\n");
+        return 1;
+    }
+
+    // both topologies have the same shape
+    struct smlt_topology_node *n2 = smlt_topology_get_first_node(topo2);
+    struct smlt_topology_node *n3 = smlt_topology_get_first_node(topo3);
+    for (int i = 0; i < NUM_THREADS; i++) {
+        struct smlt_topology_node *p2 = smlt_topology_node_parent(n2);
+        struct smlt_topology_node *p3 = smlt_topology_node_parent(n3);
+        if ((p2 == NULL) != (p3 == NULL) ||
+            (p2 && smlt_topology_node_get_id(p2) !=
+                   smlt_topology_node_get_id(p3)) ||
+            smlt_topology_node_use_shm(n2) != smlt_topology_node_use_shm(n3) ||
+            smlt_topology_node_get_num_children(n2) !=
+            smlt_topology_node_get_num_children(n3) ||
+            smlt_topology_node_get_num_children_shm(n2) !=
+            smlt_topology_node_get_num_children_shm(n3) ||
+            smlt_topo_is_model_leaf(n2) != smlt_topo_is_model_leaf(n3)) {
+            printf("FAILED: node %d differs in the sparse topology !\n", i);
+            return 1;
+        }
+        n2 = smlt_topology_node_next(n2);
+        n3 = smlt_topology_node_next(n3);
+    }
+
+    // 4 and 5 are each other's parent, 6 hangs below the orphan 5
+    struct smlt_sparse_model_node *nodes = (struct smlt_sparse_model_node *)
+        ((uint8_t *) buf + sizeof(struct smlt_sparse_model_header));
+    nodes[4].parent = 5;
+    err = smlt_sparse_model_deserialize(buf, size, &sparse);
+    if (err != SMLT_ERR_INVAL) {
+        printf("FAILED: accepted a cyclic model !\n");
+        return 1;
+    }
+    nodes[5].parent = SMLT_SPARSE_MODEL_NO_PARENT;
+    err = smlt_sparse_model_deserialize(buf, size, &sparse);
+    if (err != SMLT_ERR_INVAL) {
+        printf("FAILED: accepted a node that does not reach the root !\n");
+        return 1;
+    }
+
+    printf("Caching adaptivetree \n");
+    char cache_dir[] = "/tmp/smlt-model-cache-XXXXXX";
+    if (mkdtemp(cache_dir) == NULL) {
+        printf("FAILED TO CREATE CACHE DIRECTORY !\n");
+        return 1;
+    }
+    setenv("SMLT_CACHE_DIR", cache_dir, 1);
+
+    err = smlt_model_cache_store(cores, smlt_get_num_proc(), "adaptivetree",
+                                 m2);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO STORE MODEL !\n");
+        return 1;
+    }
+
+    struct smlt_generated_model *m3 = NULL;
+    err = smlt_model_cache_lookup(cores, smlt_get_num_proc(), "adaptivetree",
+                                  &m3);
+    if (smlt_err_is_fail(err) || m3->root != m2->root ||
+        m3->len != m2->len || m3->num_leafs != m2->num_leafs ||
+        memcmp(m3->model, m2->model, m2->len * m2->len * sizeof(uint16_t))) {
+        printf("FAILED TO LOAD MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_model_cache_lookup(cores, smlt_get_num_proc(), "cluster", &m3);
+    if (err != SMLT_ERR_CACHE_MISS) {
+        printf("FAILED: unexpected cache hit !\n");
+        return 1;
+    }
+
+    printf("Caching sparse binomial tree \n");
+    struct smlt_sparse_model *s1 = NULL, *s2 = NULL;
+    err = smlt_generate_tree_sparse_model(cores, smlt_get_num_proc(),
+                                          SMLT_GENERATOR_BINOMIAL, 0, &s1);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO GENERATE SPARSE MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_model_cache_store_sparse(cores, smlt_get_num_proc(), "binomial",
+                                        s1);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO STORE SPARSE MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_model_cache_lookup_sparse(cores, smlt_get_num_proc(),
+                                         "binomial", &s2);
+    if (smlt_err_is_fail(err) || s2->root != s1->root || s2->len != s1->len ||
+        memcmp(s2->nodes, s1->nodes,
+               s1->len * sizeof(struct smlt_sparse_model_node))) {
+        printf("FAILED TO LOAD SPARSE MODEL !\n");
+        return 1;
+    }
+
+    err = smlt_topology_create_sparse(s2, "binomial", &topo2);
+    if (smlt_err_is_fail(err)) {
+        printf("FAILED TO CREATE SPARSE TOPOLOGY !\n");
+        return 1;
+    }
+    smlt_topology_destroy(topo2);
+
+    printf("Loading shared memory based tree from json \n");
+    char json_path[sizeof(cache_dir) + 16];
+    snprintf(json_path, sizeof(json_path), "%s/model.json", cache_dir);
+    FILE *f = fopen(json_path, "w");
+    if (f == NULL) {
+        printf("FAILED TO WRITE JSON MODEL !\n");
+        return 1;
+    }
+    fprintf(f, "{\"git-version\": \"[x]\", \"root\": 0,\n"
+               " \"extra\": {\"a\": [1, {\"b\": null}], \"c\": [ ]},\n"
+               " \"leaf_nodes\": [1, 2, 3, 5, 6, 7],\n \"model\": [");
+    for (int x = 0; x < NUM_THREADS; x++) {
+        fprintf(f, "%s\n  [", x ? "," : "");
+        for (int y = 0; y < NUM_THREADS; y++) {
+            fprintf(f, "%s%d", y ? ", " : "", model2[x * NUM_THREADS + y]);
+        }
+        fprintf(f, "]");
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+
+    struct smlt_generated_model *m4 = NULL;
+    err = smlt_generate_modal_from_file(json_path, NUM_THREADS, &m4);
+    if (smlt_err_is_fail(err) || m4->root != 0 || m4->len != NUM_THREADS ||
+        m4->num_leafs != 6 || m4->leafs[3] != 5 ||
+        memcmp(m4->model, model2, sizeof(model2))) {
+        printf("FAILED TO PARSE JSON MODEL !\n");
+        return 1;
+    }
+
+    const char *bad[] = {
+        "{\"root\": 0, \"leaf_nodes\": [], \"model\": [[0, 1], [99]]}",
+        "{\"x\": , \"root\": 0, \"leaf_nodes\": [], \"model\": [[0]]}",
+        "{\"x\": [1,, 2], \"root\": 0, \"leaf_nodes\": [], \"model\": [[0]]}",
+        "{\"x\": [1, ], \"root\": 0, \"leaf_nodes\": [], \"model\": [[0]]}",
+    };
+    for (unsigned i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        err = smlt_generate_model_from_json(bad[i], strlen(bad[i]), 2, &m4);
+        if (err != SMLT_ERR_GENERATOR) {
+            printf("FAILED: accepted a malformed json model !\n");
+            return 1;
+        }
+    }
+
+    unlink(json_path);
+
+    return 0;
 }
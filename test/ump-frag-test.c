@@ -0,0 +1,319 @@
+/**
+ * \brief Testing fragmentation of large messages on UMP queuepairs
+ */
+
+/*
+ * Copyright (c) 2016, ETH Zurich.
+ * All rights reserved.
+ *
+ * This file is distributed under the terms in the attached LICENSE file.
+ * If you do not find this file, copies can be found by writing to:
+ * ETH Zurich D-INFK, Universitaetstr. 6, CH-8092 Zurich. Attn: Systems Group.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <smlt.h>
+#include <smlt_queuepair.h>
+
+#define NUM_RUNS 100
+#define MAX_WORDS 2048  // 16 KiB payload, larger than the UMP queue
+
+#define CORE_SRC 0
+#define CORE_DST 1
+
+static uint32_t msg_words[] = { 1, 6, 7, 8, 13, 14, 64, 441, 442, 1000,
+                                MAX_WORDS };
+
+#define NUM_SIZES (sizeof(msg_words) / sizeof(msg_words[0]))
+
+static void pin(int core)
+{
+    cpu_set_t cpu_mask;
+
+    CPU_ZERO(&cpu_mask);
+    CPU_SET(core, &cpu_mask);
+
+    sched_setaffinity(0, sizeof(cpu_set_t), &cpu_mask);
+}
+
+void* thr_sender(void* arg)
+{
+    struct smlt_qp* qp = (struct smlt_qp*) arg;
+
+    pin(CORE_SRC);
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t s = 0; s < NUM_SIZES; s++) {
+            for (uint32_t w = 0; w < msg_words[s]; w++) {
+                msg->data[w] = (i << 32) | (s << 16) | w;
+            }
+            msg->words = msg_words[s];
+            smlt_queuepair_send(qp, msg);
+        }
+    }
+
+    return 0;
+}
+
+void* thr_receiver(void* arg)
+{
+    struct smlt_qp* qp = (struct smlt_qp*) arg;
+
+    pin(CORE_DST);
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    int num_wrong = 0;
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t s = 0; s < NUM_SIZES; s++) {
+            msg->words = msg_words[s];
+            smlt_queuepair_recv(qp, msg);
+            if (msg->words != msg_words[s]) {
+                printf("wrong length: %u / %u\n", msg->words, msg_words[s]);
+                num_wrong++;
+                continue;
+            }
+            for (uint32_t w = 0; w < msg_words[s]; w++) {
+                if (msg->data[w] != ((i << 32) | (s << 16) | w)) {
+                    printf("wrong: %" PRIu64 " at %u\n", msg->data[w], w);
+                    num_wrong++;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!num_wrong) {
+       printf("Test Success \n");
+    } else {
+       printf("Test Failed \n");
+    }
+    return 0;
+}
+
+struct exchange_arg {
+    struct smlt_qp* qp;
+    int core;
+    uint64_t id;
+};
+
+/*
+ * both ends send a message larger than the queue to each other at the same
+ * time, which only completes if a partially sent message does not block the
+ * receive side
+ */
+void* thr_exchange(void* arg)
+{
+    struct exchange_arg* x = (struct exchange_arg*) arg;
+
+    pin(x->core);
+
+    struct smlt_msg* out = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+    struct smlt_msg* in = smlt_message_alloc(MAX_WORDS *
+                                             sizeof(smlt_msg_payload_t));
+
+    int num_wrong = 0;
+    for (uint64_t i = 0; i < NUM_RUNS; i++) {
+        for (uint32_t w = 0; w < MAX_WORDS; w++) {
+            out->data[w] = (x->id << 48) | (i << 32) | w;
+        }
+        out->words = MAX_WORDS;
+        in->words = MAX_WORDS;
+
+        bool sent = false, received = false;
+        while (!sent || !received) {
+            if (!sent) {
+                sent = (smlt_queuepair_try_send(x->qp, out) !=
+                        SMLT_ERR_QUEUE_FULL);
+            }
+            if (!received) {
+                received = (smlt_queuepair_try_recv(x->qp, in) !=
+                            SMLT_ERR_QUEUE_EMPTY);
+            }
+        }
+
+        for (uint32_t w = 0; w < MAX_WORDS; w++) {
+            if (in->words != MAX_WORDS ||
+                in->data[w] != (((1 - x->id) << 48) | (i << 32) | w)) {
+                num_wrong++;
+                break;
+            }
+        }
+    }
+
+    if (!num_wrong) {
+       printf("Exchange Success \n");
+    } else {
+       printf("Exchange Failed \n");
+    }
+    return 0;
+}
+
+/*
+ * receives a fragmented message whose sending was interrupted, followed by a
+ * notification and a prepared message, which must not end up in between the
+ * fragments
+ */
+void* thr_pending_receiver(void* arg)
+{
+    struct smlt_qp* qp = (struct smlt_qp*) arg;
+
+    pin(CORE_DST);
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+
+    int num_wrong = 0;
+
+    msg->words = MAX_WORDS;
+    smlt_queuepair_recv(qp, msg);
+    if (msg->words != MAX_WORDS) {
+        num_wrong++;
+    }
+    for (uint32_t w = 0; w < MAX_WORDS && !num_wrong; w++) {
+        if (msg->data[w] != ((0xaaULL << 32) | w)) {
+            num_wrong++;
+        }
+    }
+
+    smlt_queuepair_recv0(qp);
+
+    msg->words = 1;
+    smlt_queuepair_recv(qp, msg);
+    if (msg->words != 1 || msg->data[0] != 0xbb) {
+        num_wrong++;
+    }
+
+    if (!num_wrong) {
+       printf("Pending Success \n");
+    } else {
+       printf("Pending Failed \n");
+    }
+    return 0;
+}
+
+/*
+ * interrupts a fragmented send on a full queue and checks that neither a
+ * notification nor a prepared message is injected before it is completed
+ */
+static int test_pending(void)
+{
+    struct smlt_qp* qp1;
+    struct smlt_qp* qp2;
+    pthread_t tid;
+    errval_t err;
+
+    err = smlt_queuepair_create_sized(SMLT_QP_TYPE_UMP, &qp1, &qp2,
+                                      CORE_SRC, CORE_DST, 4);
+    if (smlt_err_is_fail(err)) {
+        printf("Pending Failed: could not create queuepair \n");
+        return 1;
+    }
+
+    struct smlt_msg* msg = smlt_message_alloc(MAX_WORDS *
+                                              sizeof(smlt_msg_payload_t));
+    for (uint32_t w = 0; w < MAX_WORDS; w++) {
+        msg->data[w] = (0xaaULL << 32) | w;
+    }
+    msg->words = MAX_WORDS;
+
+    int num_wrong = 0;
+
+    /* nobody receives yet, so the message stays partially sent */
+    if (smlt_queuepair_try_send(qp1, msg) != SMLT_ERR_QUEUE_FULL) {
+        num_wrong++;
+    }
+
+    smlt_msg_payload_t *data;
+    uint32_t words;
+    if (smlt_queuepair_can_send(qp1)) {
+        num_wrong++;
+    }
+    if (smlt_queuepair_try_send_prepare(qp1, &data, &words) !=
+        SMLT_ERR_QUEUE_FULL) {
+        num_wrong++;
+    }
+    if (smlt_queuepair_notify(qp1) != SMLT_ERR_QUEUE_FULL) {
+        num_wrong++;
+    }
+
+    pthread_create(&tid, NULL, thr_pending_receiver, (void*) qp2);
+
+    smlt_queuepair_send(qp1, msg);
+    smlt_queuepair_notify(qp1);
+    smlt_queuepair_send_prepare(qp1, &data, &words);
+    data[0] = 0xbb;
+    smlt_queuepair_send_commit(qp1);
+
+    pthread_join(tid, NULL);
+
+    smlt_queuepair_destroy(qp1);
+    smlt_queuepair_destroy(qp2);
+
+    if (num_wrong) {
+        printf("Pending Failed: message was not left pending \n");
+    }
+
+    return num_wrong;
+}
+
+// ring sizes to test, 0 is the default size
+static uint32_t ring_slots[] = { 0, 2, 4, 1024 };
+
+#define NUM_RINGS (sizeof(ring_slots) / sizeof(ring_slots[0]))
+
+int main(int argc, char **argv)
+{
+    struct smlt_qp* qp1;
+    struct smlt_qp* qp2;
+    pthread_t tids[2];
+
+    for (uint32_t r = 0; r < NUM_RINGS; r++) {
+        printf("Ring with %u slots \n", ring_slots[r]);
+
+        errval_t err = smlt_queuepair_create_sized(SMLT_QP_TYPE_UMP, &qp1, &qp2,
+                                                   CORE_SRC, CORE_DST,
+                                                   ring_slots[r]);
+        if (smlt_err_is_fail(err)) {
+            printf("Test Failed: could not create queuepair \n");
+            return 1;
+        }
+
+        pthread_create(&tids[0], NULL, thr_sender, (void*) qp1);
+        pthread_create(&tids[1], NULL, thr_receiver, (void*) qp2);
+
+        for (int i = 0; i < 2; i++) {
+            pthread_join(tids[i], NULL);
+        }
+
+        struct exchange_arg args[2] = {
+            { .qp = qp1, .core = CORE_SRC, .id = 0 },
+            { .qp = qp2, .core = CORE_DST, .id = 1 }
+        };
+
+        for (int i = 0; i < 2; i++) {
+            pthread_create(&tids[i], NULL, thr_exchange, (void*) &args[i]);
+        }
+
+        for (int i = 0; i < 2; i++) {
+            pthread_join(tids[i], NULL);
+        }
+
+        smlt_queuepair_destroy(qp1);
+        smlt_queuepair_destroy(qp2);
+    }
+
+    return test_pending();
+}